@@ -0,0 +1,35 @@
+/*
+ *  bench.h
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#ifndef Data_Structures_bench_h
+#define Data_Structures_bench_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/* Gets the current time from a monotonic clock.
+ *
+ * Returns the time in seconds.
+ */
+static inline double bench_now() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/* A sink for benchmark results, so the compiler can't discard the
+ * work being measured.
+ */
+extern volatile uint64_t bench_sink;
+
+extern char *bench_make_keys(const char *format, size_t count, size_t key_size);
+extern size_t bench_heap_used();
+
+#endif
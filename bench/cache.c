@@ -0,0 +1,131 @@
+/*
+ *  bench/cache.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "cache.h"
+
+/* Requests are drawn from a Zipfian distribution over CACHE_KEYS
+ * keys, with ZIPF_EXPONENT close to what web caches see; the cache
+ * holds a tenth of the keys.
+ */
+#define CACHE_KEYS 1000000
+#define CACHE_CAPACITY 100000
+#define CACHE_REQUESTS 8000000
+#define ZIPF_EXPONENT 0.99
+#define KEY_SIZE 24
+
+/* Draws the indices of count requests from a Zipfian distribution
+ * over CACHE_KEYS keys, with the most popular keys scattered over
+ * the key space.
+ *
+ * Returns the indices, or NULL if they couldn't be allocated.
+ */
+unsigned int *cache_bench_make_requests(size_t count) {
+	double *cumulative = malloc(CACHE_KEYS * sizeof(double));
+	unsigned int *requests = malloc(count * sizeof(unsigned int));
+	if (cumulative == NULL || requests == NULL) {
+		free(cumulative);
+		free(requests);
+		return NULL;
+	}
+
+	double total = 0;
+	size_t i = 0;
+	for (i = 0; i < CACHE_KEYS; i++) {
+		total += 1 / pow(i + 1, ZIPF_EXPONENT);
+		cumulative[i] = total;
+	}
+
+	uint64_t state = 0x9e3779b97f4a7c15ULL;
+	for (i = 0; i < count; i++) {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+
+		double target = (state >> 11) * (1.0 / 9007199254740992.0) * total;
+		size_t low = 0, high = CACHE_KEYS - 1;
+		while (low < high) {
+			size_t middle = (low + high) / 2;
+			if (cumulative[middle] < target) {
+				low = middle + 1;
+			} else {
+				high = middle;
+			}
+		}
+
+		requests[i] = (low * 7919) % CACHE_KEYS;
+	}
+
+	free(cumulative);
+
+	return requests;
+}
+
+/* Serves every request from a cache, putting each missed key in
+ * the cache the way a read-through cache would.
+ */
+void cache_bench_zipf(const char *name, cache_policy policy, char *keys, unsigned int *requests) {
+	static int value;
+	cache_options options = { .policy = policy, .capacity = CACHE_CAPACITY };
+	cache *cache = cache_new_with_options(&options);
+	if (cache == NULL) {
+		return;
+	}
+
+	size_t hits = 0;
+	double start = bench_now();
+
+	size_t i = 0;
+	for (i = 0; i < CACHE_REQUESTS; i++) {
+		char *key = keys + requests[i] * KEY_SIZE;
+		if (cache_get(cache, key) != NULL) {
+			hits++;
+		} else {
+			cache_put(cache, &value, key, 1);
+		}
+	}
+
+	double elapsed = bench_now() - start;
+	start = bench_now();
+
+	/* Hits alone, on the hottest keys the cache holds
+	 */
+	size_t hot_hits = 0;
+	for (i = 0; i < CACHE_REQUESTS; i++) {
+		hot_hits += cache_get(cache, keys + ((i % 1000) * 7919 % CACHE_KEYS) * KEY_SIZE) != NULL;
+	}
+
+	double hit_time = bench_now() - start;
+	bench_sink += hits + hot_hits;
+
+	printf("%-20s %8.1f ns/request  %5.1f%% hits  %8.1f ns/hit on hot keys\n", name, elapsed * 1e9 / CACHE_REQUESTS,
+		100.0 * hits / CACHE_REQUESTS, hit_time * 1e9 / CACHE_REQUESTS);
+
+	cache_free(cache);
+}
+
+void cache_bench() {
+	char *keys = bench_make_keys("object:%zu", CACHE_KEYS, KEY_SIZE);
+	unsigned int *requests = cache_bench_make_requests(CACHE_REQUESTS);
+	if (keys == NULL || requests == NULL) {
+		free(keys);
+		free(requests);
+		return;
+	}
+
+	printf("Cache (%d keys, Zipfian requests, room for %d)\n", CACHE_KEYS, CACHE_CAPACITY);
+	cache_bench_zipf("lru", CACHE_LRU, keys, requests);
+	cache_bench_zipf("clock", CACHE_CLOCK, keys, requests);
+
+	free(keys);
+	free(requests);
+}
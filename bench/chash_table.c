@@ -0,0 +1,123 @@
+/*
+ *  bench/chash_table.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "chash_table.h"
+#include "hash_table.h"
+
+#define MIXED_KEYS 1000000
+#define MIXED_OPERATIONS 2000000
+#define MIXED_MAX_THREADS 8
+#define KEY_SIZE 24
+
+/* Percent of operations in the mixed workload that are sets
+ */
+#define MIXED_SET_PERCENT 5
+
+typedef struct {
+	chash_table *concurrent;
+	hash_table *locked;
+	pthread_mutex_t *lock;
+	char *keys;
+	unsigned int seed;
+	unsigned long operations;
+} chash_table_bench_worker;
+
+/* Runs a share of the mixed workload against either the concurrent
+ * table or the plain table behind one global lock.
+ */
+void *chash_table_bench_mixed_worker(void *context) {
+	chash_table_bench_worker *worker = context;
+	uint64_t found = 0;
+	uint64_t state = worker->seed;
+
+	unsigned long i = 0;
+	for (i = 0; i < worker->operations; i++) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		char *key = worker->keys + ((state >> 33) % MIXED_KEYS) * KEY_SIZE;
+		bool set = (state >> 16) % 100 < MIXED_SET_PERCENT;
+
+		if (worker->concurrent != NULL) {
+			if (set) {
+				chash_table_set(worker->concurrent, key, key, NULL);
+			} else {
+				found += chash_table_get(worker->concurrent, key) != NULL;
+			}
+		} else {
+			pthread_mutex_lock(worker->lock);
+			if (set) {
+				hash_table_set(worker->locked, key, key, NULL);
+			} else {
+				found += hash_table_get(worker->locked, key) != NULL;
+			}
+			pthread_mutex_unlock(worker->lock);
+		}
+	}
+
+	__atomic_add_fetch(&bench_sink, found, __ATOMIC_RELAXED);
+
+	return NULL;
+}
+
+void chash_table_bench_mixed(const char *name, chash_table *concurrent, hash_table *locked, char *keys, int threads) {
+	pthread_t handles[MIXED_MAX_THREADS];
+	chash_table_bench_worker workers[MIXED_MAX_THREADS];
+	pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+	double start = bench_now();
+
+	int i = 0;
+	for (i = 0; i < threads; i++) {
+		workers[i] = (chash_table_bench_worker){concurrent, locked, &lock, keys, i + 1, MIXED_OPERATIONS / threads};
+		pthread_create(&handles[i], NULL, &chash_table_bench_mixed_worker, &workers[i]);
+	}
+
+	for (i = 0; i < threads; i++) {
+		pthread_join(handles[i], NULL);
+	}
+
+	double elapsed = bench_now() - start;
+
+	printf("%-20s %d threads %8.2f Mops/s\n", name, threads, MIXED_OPERATIONS / elapsed / 1e6);
+}
+
+void chash_table_bench() {
+	char *keys = bench_make_keys("user:%zu", MIXED_KEYS, KEY_SIZE);
+	if (keys == NULL) {
+		return;
+	}
+
+	chash_table *concurrent = chash_table_new();
+	hash_table *locked = hash_table_new();
+	if (concurrent == NULL || locked == NULL) {
+		free(keys);
+		return;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < MIXED_KEYS; i++) {
+		chash_table_set(concurrent, keys + i * KEY_SIZE, keys + i * KEY_SIZE, NULL);
+		hash_table_set(locked, keys + i * KEY_SIZE, keys + i * KEY_SIZE, NULL);
+	}
+
+	printf("Concurrent hash table, %d%% gets and %d%% sets (%d keys)\n", 100 - MIXED_SET_PERCENT, MIXED_SET_PERCENT, MIXED_KEYS);
+
+	int threads = 1;
+	for (threads = 1; threads <= MIXED_MAX_THREADS; threads *= 2) {
+		chash_table_bench_mixed("chash_table", concurrent, NULL, keys, threads);
+		chash_table_bench_mixed("locked hash_table", NULL, locked, keys, threads);
+	}
+
+	chash_table_free(concurrent);
+	hash_table_free(locked);
+	free(keys);
+}
@@ -0,0 +1,183 @@
+/*
+ *  bench/filter.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "bloom_filter.h"
+#include "cuckoo_filter.h"
+#include "hash_table.h"
+
+#define FILTER_KEYS 1000000
+#define FILTER_QUERIES 4000000
+#define KEY_SIZE 24
+
+/* Lookups against tables with filters miss this often, as in a
+ * negative cache
+ */
+#define MISS_PERCENT 80
+
+/* Times lookups of keys that were added and of keys that weren't,
+ * and measures the rate of false positives among the second.
+ */
+void filter_bench_bloom(double rate, char *keys, char *missing) {
+	bloom_filter *filter = bloom_filter_new(FILTER_KEYS, rate);
+	if (filter == NULL) {
+		return;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < FILTER_KEYS; i++) {
+		char *key = keys + i * KEY_SIZE;
+		bloom_filter_add(filter, key, strlen(key));
+	}
+
+	size_t found = 0;
+	double start = bench_now();
+
+	for (i = 0; i < FILTER_QUERIES; i++) {
+		char *key = keys + (i % FILTER_KEYS) * KEY_SIZE;
+		found += bloom_filter_contains(filter, key, strlen(key));
+	}
+
+	double hits = bench_now() - start;
+	size_t false_positives = 0;
+	start = bench_now();
+
+	for (i = 0; i < FILTER_QUERIES; i++) {
+		char *key = missing + (i % FILTER_KEYS) * KEY_SIZE;
+		false_positives += bloom_filter_contains(filter, key, strlen(key));
+	}
+
+	double misses = bench_now() - start;
+	bench_sink += found;
+
+	printf("bloom %-14g %8.1f ns/hit  %8.1f ns/miss  %8.4f%% false positives (%.4f%% expected)  %5.1f bits/key\n", rate,
+		hits * 1e9 / FILTER_QUERIES, misses * 1e9 / FILTER_QUERIES, 100.0 * false_positives / FILTER_QUERIES,
+		100 * bloom_filter_false_positive_rate(filter), filter->block_count * 256.0 / FILTER_KEYS);
+
+	bloom_filter_free(filter);
+}
+
+/* Times lookups of keys that were added and of keys that weren't,
+ * and measures the rate of false positives among the second.
+ */
+void filter_bench_cuckoo(double rate, char *keys, char *missing) {
+	cuckoo_filter *filter = cuckoo_filter_new(FILTER_KEYS, rate);
+	if (filter == NULL) {
+		return;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < FILTER_KEYS; i++) {
+		char *key = keys + i * KEY_SIZE;
+		cuckoo_filter_add(filter, key, strlen(key));
+	}
+
+	size_t found = 0;
+	double start = bench_now();
+
+	for (i = 0; i < FILTER_QUERIES; i++) {
+		char *key = keys + (i % FILTER_KEYS) * KEY_SIZE;
+		found += cuckoo_filter_contains(filter, key, strlen(key));
+	}
+
+	double hits = bench_now() - start;
+	size_t false_positives = 0;
+	start = bench_now();
+
+	for (i = 0; i < FILTER_QUERIES; i++) {
+		char *key = missing + (i % FILTER_KEYS) * KEY_SIZE;
+		false_positives += cuckoo_filter_contains(filter, key, strlen(key));
+	}
+
+	double misses = bench_now() - start;
+	bench_sink += found;
+
+	printf("cuckoo %-13g %8.1f ns/hit  %8.1f ns/miss  %8.4f%% false positives  %5.1f bits/key\n", rate,
+		hits * 1e9 / FILTER_QUERIES, misses * 1e9 / FILTER_QUERIES, 100.0 * false_positives / FILTER_QUERIES,
+		(double)filter->bucket_count * CUCKOO_FILTER_BUCKET_SIZE * filter->fingerprint_bits / FILTER_KEYS);
+
+	cuckoo_filter_free(filter);
+}
+
+/* Times gets from a table, most of them for missing keys, with and
+ * without a filter in front of it.
+ */
+void filter_bench_table(const char *name, hash_table_options *options, bool freeze, char *keys, char *missing) {
+	hash_table *table = hash_table_new_with_options(options);
+	if (table == NULL) {
+		return;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < FILTER_KEYS; i++) {
+		hash_table_set(table, keys + i * KEY_SIZE, keys + i * KEY_SIZE, NULL);
+	}
+
+	if (freeze) {
+		hash_table_freeze(table);
+	}
+
+	double times[2];
+	size_t found = 0;
+
+	int pass = 0;
+	for (pass = 0; pass < 2; pass++) {
+		if (pass == 1) {
+			hash_table_add_filter(table);
+		}
+
+		double start = bench_now();
+
+		for (i = 0; i < FILTER_QUERIES; i++) {
+			size_t index = (i * 7919) % FILTER_KEYS;
+			char *key = (i % 100 < MISS_PERCENT) ? missing + index * KEY_SIZE : keys + index * KEY_SIZE;
+			found += hash_table_get(table, key) != NULL;
+		}
+
+		times[pass] = bench_now() - start;
+	}
+
+	bench_sink += found;
+
+	printf("%-20s %8.1f ns/get  %8.1f ns/get filtered  %5.2fx\n", name, times[0] * 1e9 / FILTER_QUERIES,
+		times[1] * 1e9 / FILTER_QUERIES, times[0] / times[1]);
+
+	hash_table_free(table);
+}
+
+void filter_bench() {
+	char *keys = bench_make_keys("user:%zu", FILTER_KEYS, KEY_SIZE);
+	char *missing = bench_make_keys("guest:%zu", FILTER_KEYS, KEY_SIZE);
+	if (keys == NULL || missing == NULL) {
+		free(keys);
+		free(missing);
+		return;
+	}
+
+	printf("Filters (%d keys, by target false positive rate)\n", FILTER_KEYS);
+	filter_bench_bloom(0.01, keys, missing);
+	filter_bench_bloom(0.001, keys, missing);
+	filter_bench_cuckoo(0.01, keys, missing);
+	filter_bench_cuckoo(0.001, keys, missing);
+
+	printf("\nHash table gets with a filter (%d keys, %d%% misses)\n", FILTER_KEYS, MISS_PERCENT);
+
+	hash_table_options chained = { .layout = HASH_TABLE_CHAINED };
+	filter_bench_table("chained", &chained, false, keys, missing);
+
+	hash_table_options flat = { .layout = HASH_TABLE_FLAT };
+	filter_bench_table("flat", &flat, false, keys, missing);
+	filter_bench_table("frozen", &flat, true, keys, missing);
+
+	free(keys);
+	free(missing);
+}
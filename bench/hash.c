@@ -0,0 +1,74 @@
+/*
+ *  bench/hash.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "hash.h"
+
+#define BENCH_BYTES (256 * 1024 * 1024)
+
+/* The byte-sum hash that hash_table used before hash_fast, kept as
+ * a baseline.
+ */
+uint64_t additive_hash(const void *key, size_t length, uint64_t seed) {
+	const char *bytes = key;
+	unsigned int hash = 0;
+
+	size_t i = 0;
+	for (i = 0; i < length; i++) {
+		hash += 3 * bytes[i] - 19;
+	}
+
+	return hash;
+}
+
+void hash_bench_one(const char *name, uint64_t (*hash_function)(const void *, size_t, uint64_t), const unsigned char *data, size_t length) {
+	size_t iterations = BENCH_BYTES / length;
+	if (iterations > 20000000) {
+		iterations = 20000000;
+	}
+
+	uint64_t sum = 0;
+	double start = bench_now();
+
+	size_t i = 0;
+	for (i = 0; i < iterations; i++) {
+		sum += hash_function(data + (i & 63), length, i);
+	}
+
+	double elapsed = bench_now() - start;
+	bench_sink += sum;
+
+	printf("%-12s %6zu bytes: %8.2f ns/hash %8.2f GB/s\n", name, length, elapsed * 1e9 / iterations, (iterations * (double)length) / elapsed / 1e9);
+}
+
+void hash_bench() {
+	size_t lengths[] = { 4, 8, 16, 32, 64, 256, 4096 };
+
+	unsigned char *data = malloc(4096 + 64);
+	if (data == NULL) {
+		return;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < 4096 + 64; i++) {
+		data[i] = (unsigned char)(i * 131 + 7);
+	}
+
+	printf("Hash function throughput\n");
+
+	for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+		hash_bench_one("additive", &additive_hash, data, lengths[i]);
+		hash_bench_one("hash_fast", &hash_fast, data, lengths[i]);
+		hash_bench_one("hash_keyed", &hash_keyed, data, lengths[i]);
+	}
+
+	free(data);
+}
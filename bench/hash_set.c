@@ -0,0 +1,193 @@
+/*
+ *  bench/hash_set.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/18/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "hash_set.h"
+#include "hash_table.h"
+
+#define SET_KEYS 1000000
+#define SET_LOOKUPS 4000000
+#define KEY_SIZE 24
+
+/* Adds and then looks up every key in a hash_set.
+ */
+void hash_set_bench_set(const char *name, hash_set_options *options, char *keys) {
+	size_t heap = bench_heap_used();
+	double start = bench_now();
+
+	hash_set *set = hash_set_new_with_options(options);
+	if (set == NULL) {
+		return;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < SET_KEYS; i++) {
+		hash_set_insert(set, keys + i * KEY_SIZE);
+	}
+
+	double insert = bench_now() - start;
+	size_t used = bench_heap_used() - heap;
+	size_t found = 0;
+	start = bench_now();
+
+	for (i = 0; i < SET_LOOKUPS; i++) {
+		found += hash_set_contains(set, keys + ((i * 7919) % SET_KEYS) * KEY_SIZE);
+	}
+
+	double contains = bench_now() - start;
+	bench_sink += found;
+
+	printf("%-24s %8.1f ns/insert  %8.1f ns/contains  %6.1f bytes/key\n", name, insert * 1e9 / SET_KEYS,
+		contains * 1e9 / SET_LOOKUPS, (double)used / SET_KEYS);
+
+	hash_set_free(set);
+}
+
+/* Adds and then looks up every key in a hash_table used as a set,
+ * with every key given the same dummy value.
+ */
+void hash_set_bench_table(const char *name, hash_table_options *options, char *keys) {
+	static int present = 1;
+
+	size_t heap = bench_heap_used();
+	double start = bench_now();
+
+	hash_table *table = hash_table_new_with_options(options);
+	if (table == NULL) {
+		return;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < SET_KEYS; i++) {
+		hash_table_set(table, &present, keys + i * KEY_SIZE, NULL);
+	}
+
+	double insert = bench_now() - start;
+	size_t used = bench_heap_used() - heap;
+	size_t found = 0;
+	start = bench_now();
+
+	for (i = 0; i < SET_LOOKUPS; i++) {
+		found += hash_table_get(table, keys + ((i * 7919) % SET_KEYS) * KEY_SIZE) != NULL;
+	}
+
+	double contains = bench_now() - start;
+	bench_sink += found;
+
+	printf("%-24s %8.1f ns/insert  %8.1f ns/contains  %6.1f bytes/key\n", name, insert * 1e9 / SET_KEYS,
+		contains * 1e9 / SET_LOOKUPS, (double)used / SET_KEYS);
+
+	hash_table_free(table);
+}
+
+typedef struct {
+	hash_table *other;
+	hash_table *result;
+} hash_set_bench_intersection;
+
+static void hash_set_bench_intersect_item(const char *key, size_t length, void *value, void *context) {
+	hash_set_bench_intersection *intersection = context;
+	if (hash_table_get_bytes(intersection->other, key, length) != NULL) {
+		hash_table_set_bytes(intersection->result, value, key, length, NULL);
+	}
+}
+
+/* Times the set operations on two sets of SET_KEYS keys that share
+ * half of them, and the same intersection done by hand with two
+ * hash_tables.
+ */
+void hash_set_bench_ops(char *keys, char *others) {
+	hash_set *set = hash_set_new();
+	hash_set *other = hash_set_new();
+	hash_table *table = hash_table_new();
+	hash_table *other_table = hash_table_new();
+	if (set == NULL || other == NULL || table == NULL || other_table == NULL) {
+		return;
+	}
+
+	static int present = 1;
+	size_t i = 0;
+	for (i = 0; i < SET_KEYS; i++) {
+		char *key = keys + i * KEY_SIZE;
+		char *other_key = (i % 2 == 0) ? key : others + i * KEY_SIZE;
+
+		hash_set_insert(set, key);
+		hash_set_insert(other, other_key);
+		hash_table_set(table, &present, key, NULL);
+		hash_table_set(other_table, &present, other_key, NULL);
+	}
+
+	const char *names[3] = { "union", "intersection", "difference" };
+	hash_set *(*operations[3])(const hash_set *, const hash_set *) = { hash_set_union, hash_set_intersection, hash_set_difference };
+
+	int o = 0;
+	for (o = 0; o < 3; o++) {
+		double start = bench_now();
+		hash_set *result = operations[o](set, other);
+		double elapsed = bench_now() - start;
+
+		bench_sink += result->length;
+		printf("hash_set %-15s %8.1f ns/key  %u keys\n", names[o], elapsed * 1e9 / (2 * SET_KEYS), result->length);
+
+		hash_set_free(result);
+	}
+
+	double start = bench_now();
+
+	hash_set_bench_intersection intersection = { other_table, hash_table_new() };
+	hash_table_foreach(table, hash_set_bench_intersect_item, &intersection);
+
+	double elapsed = bench_now() - start;
+	bench_sink += intersection.result->length;
+	printf("hash_table %-13s %8.1f ns/key  %u keys\n", "intersection", elapsed * 1e9 / (2 * SET_KEYS), intersection.result->length);
+
+	hash_table_free(intersection.result);
+	hash_table_free(table);
+	hash_table_free(other_table);
+	hash_set_free(set);
+	hash_set_free(other);
+}
+
+void hash_set_bench() {
+	char *ids = bench_make_keys("%zu", SET_KEYS, KEY_SIZE);
+	char *keys = bench_make_keys("user:%zu@example.com", SET_KEYS, KEY_SIZE);
+	char *others = bench_make_keys("guest:%zu@test.com", SET_KEYS, KEY_SIZE);
+	if (ids == NULL || keys == NULL || others == NULL) {
+		free(ids);
+		free(keys);
+		free(others);
+		return;
+	}
+
+	hash_set_options fast = { .hash = HASH_TABLE_HASH_FAST };
+	hash_set_options wide = { .hash = HASH_TABLE_HASH_FAST, .inline_key_size = 23 };
+	hash_table_options chained = { .layout = HASH_TABLE_CHAINED };
+	hash_table_options flat = { .layout = HASH_TABLE_FLAT };
+
+	printf("Sets of short keys (%d keys, %d lookups)\n", SET_KEYS, SET_LOOKUPS);
+	hash_set_bench_set("hash_set", &fast, ids);
+	hash_set_bench_table("hash_table chained", &chained, ids);
+	hash_set_bench_table("hash_table flat", &flat, ids);
+
+	printf("\nSets of long keys (%d keys, %d lookups)\n", SET_KEYS, SET_LOOKUPS);
+	hash_set_bench_set("hash_set", &fast, keys);
+	hash_set_bench_set("hash_set inline 23", &wide, keys);
+	hash_set_bench_table("hash_table chained", &chained, keys);
+	hash_set_bench_table("hash_table flat", &flat, keys);
+
+	printf("\nSet operations (%d keys in each set, half shared)\n", SET_KEYS);
+	hash_set_bench_ops(keys, others);
+
+	free(ids);
+	free(keys);
+	free(others);
+}
@@ -0,0 +1,781 @@
+/*
+ *  bench/hash_table.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "bench.h"
+#include "hash_table.h"
+
+#define INSERT_LATENCY_KEYS 2000000
+#define LOOKUP_KEYS 900000
+#define LOOKUP_ROUNDS 4
+#define KEY_SIZE 24
+#define URL_KEY_SIZE 96
+#define SCAN_STEP 100
+
+/* Counting draws words from a small vocabulary, so most are
+ * already in the table
+ */
+#define COUNT_WORDS 4000000
+#define COUNT_VOCABULARY 200000
+
+/* Tiny tables each hold a few fields, like parsed JSON objects
+ */
+#define TINY_TABLES 200000
+#define TINY_LOOKUP_ROUNDS 10
+
+/* Scratch tables are filled with a few hundred keys per request
+ * and then emptied for the next one
+ */
+#define SCRATCH_REQUESTS 20000
+#define SCRATCH_KEYS 500
+
+/* Batched lookups use enough keys that the tables are larger than
+ * the last level cache of most machines
+ */
+#define BATCH_KEYS 4000000
+#define BATCH_QUERIES 4000000
+#define BATCH_SIZE 256
+
+/* Makes an array of count keys from a format taking the key's
+ * index, each key_size bytes apart.
+ *
+ * Returns the keys, or NULL if they couldn't be allocated.
+ */
+char *bench_make_keys(const char *format, size_t count, size_t key_size) {
+	char *keys = malloc(count * key_size);
+	if (keys == NULL) {
+		return NULL;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < count; i++) {
+		snprintf(keys + i * key_size, key_size, format, i);
+	}
+
+	return keys;
+}
+
+/* Gets the number of bytes allocated from the heap, where the C
+ * library can tell.
+ *
+ * Returns the number of bytes, or zero if it isn't known.
+ */
+size_t bench_heap_used() {
+#ifdef __GLIBC__
+	struct mallinfo2 info = mallinfo2();
+	return info.uordblks + info.hblkhd;
+#else
+	return 0;
+#endif
+}
+
+int bench_compare_doubles(const void *one, const void *two) {
+	double a = *(const double *)one, b = *(const double *)two;
+	return (a > b) - (a < b);
+}
+
+void hash_table_bench_insert_latency(const char *name, hash_table_options *options, char *keys, double *latencies) {
+	hash_table *table = hash_table_new_with_options(options);
+	if (table == NULL) {
+		return;
+	}
+
+	double total_start = bench_now();
+
+	size_t i = 0;
+	for (i = 0; i < INSERT_LATENCY_KEYS; i++) {
+		double start = bench_now();
+		hash_table_set(table, NULL, keys + i * KEY_SIZE, NULL);
+		latencies[i] = bench_now() - start;
+	}
+
+	double total = bench_now() - total_start;
+
+	hash_table_free(table);
+
+	qsort(latencies, INSERT_LATENCY_KEYS, sizeof(double), &bench_compare_doubles);
+
+	printf("%-20s %8.1f ns/insert  p50 %8.0f ns  p99 %8.0f ns  p99.9 %10.0f ns  max %12.0f ns\n",
+		   name,
+		   total * 1e9 / INSERT_LATENCY_KEYS,
+		   latencies[INSERT_LATENCY_KEYS / 2] * 1e9,
+		   latencies[INSERT_LATENCY_KEYS / 100 * 99] * 1e9,
+		   latencies[INSERT_LATENCY_KEYS / 1000 * 999] * 1e9,
+		   latencies[INSERT_LATENCY_KEYS - 1] * 1e9);
+}
+
+void hash_table_bench_lookup(const char *name, hash_table_options *options, char *keys, size_t key_size) {
+	hash_table *table = hash_table_new_with_options(options);
+	if (table == NULL) {
+		return;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < LOOKUP_KEYS; i++) {
+		hash_table_set(table, keys + i * key_size, keys + i * key_size, NULL);
+	}
+
+	uint64_t found = 0;
+	double start = bench_now();
+
+	int round = 0;
+	for (round = 0; round < LOOKUP_ROUNDS; round++) {
+		for (i = 0; i < LOOKUP_KEYS; i++) {
+			size_t index = (i * 7919) % LOOKUP_KEYS;
+			found += hash_table_get(table, keys + index * key_size) != NULL;
+		}
+	}
+
+	double elapsed = bench_now() - start;
+	start = bench_now();
+
+	char missing[URL_KEY_SIZE];
+	for (i = 0; i < LOOKUP_KEYS; i++) {
+		memcpy(missing, keys + ((i * 7919) % LOOKUP_KEYS) * key_size, key_size);
+		missing[0] = 'x';
+		found += hash_table_get(table, missing) != NULL;
+	}
+
+	double missed = bench_now() - start;
+	bench_sink += found;
+
+	unsigned int max = 0;
+	double mean = 0;
+	hash_table_probe_lengths(table, &max, &mean);
+	double load = ((double)table->length) / table->bucket_count;
+
+	hash_table_free(table);
+
+	printf("%-20s %8.1f ns/get  %8.1f ns/miss  load %.2f  probe max %u mean %.2f\n", name, elapsed * 1e9 / (LOOKUP_ROUNDS * LOOKUP_KEYS), missed * 1e9 / LOOKUP_KEYS, load, max, mean);
+}
+
+void hash_table_bench_bulk_load(const char *name, hash_table_options *options, char *keys, size_t count) {
+	double start = bench_now();
+
+	hash_table *table = hash_table_new_with_options(options);
+	if (table == NULL) {
+		return;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < count; i++) {
+		hash_table_set(table, NULL, keys + i * KEY_SIZE, NULL);
+	}
+
+	double elapsed = bench_now() - start;
+
+	hash_table_free(table);
+
+	printf("%-20s %8.1f ns/insert\n", name, elapsed * 1e9 / count);
+}
+
+void hash_table_bench_get_many(const char *name, hash_table_options *options, char *keys) {
+	hash_table *table = hash_table_new_with_options(options);
+	char **queries = malloc(BATCH_QUERIES * sizeof(char *));
+	void **values = malloc(BATCH_SIZE * sizeof(void *));
+	if (table == NULL || queries == NULL || values == NULL) {
+		if (table != NULL) {
+			hash_table_free(table);
+		}
+
+		free(queries);
+		free(values);
+		return;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < BATCH_KEYS; i++) {
+		hash_table_set(table, keys + i * KEY_SIZE, keys + i * KEY_SIZE, NULL);
+	}
+
+	uint64_t state = 1;
+	for (i = 0; i < BATCH_QUERIES; i++) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		queries[i] = keys + ((state >> 33) % BATCH_KEYS) * KEY_SIZE;
+	}
+
+	uint64_t found = 0;
+	double start = bench_now();
+
+	for (i = 0; i < BATCH_QUERIES; i++) {
+		found += hash_table_get(table, queries[i]) != NULL;
+	}
+
+	double single = bench_now() - start;
+	start = bench_now();
+
+	for (i = 0; i < BATCH_QUERIES; i += BATCH_SIZE) {
+		hash_table_get_many(table, queries + i, BATCH_SIZE, values);
+
+		size_t j = 0;
+		for (j = 0; j < BATCH_SIZE; j++) {
+			found += values[j] != NULL;
+		}
+	}
+
+	double batched = bench_now() - start;
+	bench_sink += found;
+
+	hash_table_free(table);
+	free(queries);
+	free(values);
+
+	printf("%-20s %8.1f ns/get  %8.1f ns/get batched  %5.2fx\n", name, single * 1e9 / BATCH_QUERIES, batched * 1e9 / BATCH_QUERIES, single / batched);
+}
+
+void hash_table_bench_build_free(const char *name, hash_table_options *options, char *keys, size_t count) {
+	double start = bench_now();
+
+	hash_table *table = hash_table_new_with_options(options);
+	if (table == NULL) {
+		return;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < count; i++) {
+		hash_table_set(table, NULL, keys + i * KEY_SIZE, NULL);
+	}
+
+	double built = bench_now();
+	hash_table_free(table);
+	double freed = bench_now();
+
+	printf("%-20s %8.1f ns/insert  %8.1f ns/key to free\n", name, (built - start) * 1e9 / count, (freed - built) * 1e9 / count);
+}
+
+void hash_table_bench_freeze(hash_table_options *options, char *keys, size_t count) {
+	hash_table *table = hash_table_new_with_options(options);
+	if (table == NULL) {
+		return;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < count; i++) {
+		hash_table_set(table, keys + i * KEY_SIZE, keys + i * KEY_SIZE, NULL);
+	}
+
+	uint64_t found = 0;
+	double start = bench_now();
+
+	for (i = 0; i < count; i++) {
+		found += hash_table_get(table, keys + ((i * 7919) % count) * KEY_SIZE) != NULL;
+	}
+
+	double mutable = bench_now() - start;
+	start = bench_now();
+
+	if (!hash_table_freeze(table)) {
+		hash_table_free(table);
+		return;
+	}
+
+	double build = bench_now() - start;
+	start = bench_now();
+
+	for (i = 0; i < count; i++) {
+		found += hash_table_get(table, keys + ((i * 7919) % count) * KEY_SIZE) != NULL;
+	}
+
+	double frozen = bench_now() - start;
+	bench_sink += found;
+
+	printf("build %8.1f ms  %5.2f bits/key  %8.1f ns/get mutable  %8.1f ns/get frozen\n", build * 1e3, hash_table_frozen_bits_per_key(table), mutable * 1e9 / count, frozen * 1e9 / count);
+
+	hash_table_free(table);
+}
+
+/* Compares rebuilding a table key by key with loading a saved copy
+ * and looking up every key, which faults in the whole file.
+ */
+void hash_table_bench_load(hash_table_options *options, char *keys, size_t count) {
+	const char *path = "bench_hash_table.tmp";
+	hash_table *table = hash_table_new_with_options(options);
+	if (table == NULL) {
+		return;
+	}
+
+	double start = bench_now();
+
+	size_t i = 0;
+	for (i = 0; i < count; i++) {
+		hash_table_set(table, keys + i * KEY_SIZE, keys + i * KEY_SIZE, NULL);
+	}
+
+	double build = bench_now() - start;
+	start = bench_now();
+
+	bool saved = hash_table_save(table, path, NULL);
+	double save = bench_now() - start;
+
+	hash_table_free(table);
+	if (!saved) {
+		return;
+	}
+
+	start = bench_now();
+
+	table = hash_table_load(path);
+	if (table == NULL) {
+		remove(path);
+		return;
+	}
+
+	double load = bench_now() - start;
+	uint64_t found = 0;
+
+	for (i = 0; i < count; i++) {
+		found += hash_table_get(table, keys + i * KEY_SIZE) != NULL;
+	}
+
+	double touch = bench_now() - start;
+	bench_sink += found;
+
+	printf("build %8.1f ms  save %8.1f ms  load %8.3f ms  load and get all %8.1f ms\n", build * 1e3, save * 1e3, load * 1e3, touch * 1e3);
+
+	hash_table_free(table);
+	remove(path);
+}
+
+void hash_table_bench_count_item(const char *key, size_t length, void *value, void *context) {
+	*(uint64_t *)context += length;
+}
+
+/* Times a full scan of a table in steps, and a single pass over
+ * its storage.
+ */
+void hash_table_bench_scan(const char *name, hash_table_options *options, char *keys, size_t count) {
+	hash_table *table = hash_table_new_with_options(options);
+	if (table == NULL) {
+		return;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < count; i++) {
+		hash_table_set(table, keys + i * KEY_SIZE, keys + i * KEY_SIZE, NULL);
+	}
+
+	uint64_t total = 0;
+	double start = bench_now();
+
+	unsigned long cursor = 0;
+	do {
+		cursor = hash_table_scan(table, cursor, SCAN_STEP, &hash_table_bench_count_item, &total);
+	} while (cursor != 0);
+
+	double scan = bench_now() - start;
+	start = bench_now();
+
+	hash_table_foreach(table, &hash_table_bench_count_item, &total);
+
+	double foreach = bench_now() - start;
+	bench_sink += total;
+
+	printf("%-20s %8.2f ns/item scan  %8.2f ns/item foreach\n", name, scan * 1e9 / count, foreach * 1e9 / count);
+
+	hash_table_free(table);
+}
+
+/* Fills a table, then removes all but one in a hundred of its keys
+ * and compacts it, reporting how its bucket count follows the
+ * number of live keys.
+ */
+void hash_table_bench_drain(const char *name, hash_table_options *options, char *keys, size_t count) {
+	hash_table *table = hash_table_new_with_options(options);
+	if (table == NULL) {
+		return;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < count; i++) {
+		hash_table_set(table, NULL, keys + i * KEY_SIZE, NULL);
+	}
+
+	unsigned int full = table->bucket_count;
+	double start = bench_now();
+
+	for (i = 0; i < count; i++) {
+		if (i % 100 != 0) {
+			hash_table_remove(table, keys + i * KEY_SIZE);
+		}
+	}
+
+	double drained = bench_now();
+	unsigned int remaining = table->bucket_count;
+
+	hash_table_compact(table);
+
+	double compacted = bench_now();
+
+	printf("%-20s %8.1f ns/remove  %8u -> %7u -> %7u buckets  %6.2f ms to compact\n", name, (drained - start) * 1e9 / count, full, remaining, table->bucket_count, (compacted - drained) * 1e3);
+
+	hash_table_free(table);
+}
+
+/* Fills a table, reporting the heap it takes per key and how long
+ * a pass over it takes.
+ */
+void hash_table_bench_memory(const char *name, hash_table_options *options, char *keys, size_t count) {
+	size_t heap = bench_heap_used();
+
+	hash_table *table = hash_table_new_with_options(options);
+	if (table == NULL) {
+		return;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < count; i++) {
+		hash_table_set(table, keys + i * KEY_SIZE, keys + i * KEY_SIZE, NULL);
+	}
+
+	size_t used = bench_heap_used() - heap;
+	uint64_t total = 0;
+	double start = bench_now();
+
+	hash_table_foreach(table, &hash_table_bench_count_item, &total);
+
+	double foreach = bench_now() - start;
+	bench_sink += total;
+
+	printf("%-20s %8.1f bytes/key  %8.2f ns/item foreach\n", name, (double)used / count, foreach * 1e9 / count);
+
+	hash_table_free(table);
+}
+
+/* Counts words, each a key in a table whose value is its count,
+ * first by getting and then setting each key, then by changing
+ * counts in place through hash_table_get_or_insert.
+ */
+void hash_table_bench_count(const char *name, hash_table_options *options, char *keys) {
+	hash_table *table = hash_table_new_with_options(options);
+	if (table == NULL) {
+		return;
+	}
+
+	uint64_t state = 1;
+	double start = bench_now();
+
+	size_t i = 0;
+	for (i = 0; i < COUNT_WORDS; i++) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		char *word = keys + ((state >> 33) % COUNT_VOCABULARY) * KEY_SIZE;
+
+		uintptr_t count = (uintptr_t)hash_table_get(table, word);
+		hash_table_set(table, (void *)(count + 1), word, NULL);
+	}
+
+	double separate = bench_now() - start;
+
+	hash_table_free(table);
+	table = hash_table_new_with_options(options);
+	if (table == NULL) {
+		return;
+	}
+
+	state = 1;
+	start = bench_now();
+
+	for (i = 0; i < COUNT_WORDS; i++) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		char *word = keys + ((state >> 33) % COUNT_VOCABULARY) * KEY_SIZE;
+
+		void **count = hash_table_get_or_insert(table, word, NULL);
+		*count = (void *)((uintptr_t)*count + 1);
+	}
+
+	double in_place = bench_now() - start;
+	bench_sink += table->length;
+
+	hash_table_free(table);
+
+	printf("%-20s %8.1f ns/word get and set  %8.1f ns/word in place  %5.2fx\n", name, separate * 1e9 / COUNT_WORDS, in_place * 1e9 / COUNT_WORDS, separate / in_place);
+}
+
+typedef struct {
+	uint64_t id;
+	uint64_t visits;
+	double score;
+} hash_table_bench_record;
+
+/* Builds a table of 24-byte records and reads a field of each,
+ * either with each record allocated and stored as a pointer, or
+ * with records copied into the table next to their keys.
+ */
+void hash_table_bench_records(const char *name, hash_table_options *options, char *keys, size_t count) {
+	size_t heap = bench_heap_used();
+	double start = bench_now();
+
+	hash_table *table = hash_table_new_with_options(options);
+	if (table == NULL) {
+		return;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < count; i++) {
+		hash_table_bench_record record = { i, 0, i / 2.0 };
+
+		if (options->value_size > 0) {
+			hash_table_set(table, &record, keys + i * KEY_SIZE, NULL);
+		} else {
+			hash_table_bench_record *copy = malloc(sizeof(record));
+			*copy = record;
+			hash_table_set(table, copy, keys + i * KEY_SIZE, &free);
+		}
+	}
+
+	double build = bench_now() - start;
+	size_t used = bench_heap_used() - heap;
+	uint64_t total = 0;
+	start = bench_now();
+
+	for (i = 0; i < count; i++) {
+		hash_table_bench_record *record = hash_table_get(table, keys + ((i * 7919) % count) * KEY_SIZE);
+		total += record->id;
+	}
+
+	double get = bench_now() - start;
+	bench_sink += total;
+	start = bench_now();
+
+	hash_table_free(table);
+
+	double freed = bench_now() - start;
+
+	printf("%-20s %8.1f ns/insert  %8.1f ns/get  %8.1f ns/key to free  %6.1f bytes/key\n", name, build * 1e9 / count, get * 1e9 / count, freed * 1e9 / count, (double)used / count);
+}
+
+/* Builds many tables of a few fields each, then gets every field
+ * of every table, including one that is missing.
+ */
+void hash_table_bench_tiny(const char *name, hash_table_options *options) {
+	static char *fields[] = { "id", "name", "email", "created_at", "status", "missing" };
+	size_t field_count = sizeof(fields) / sizeof(fields[0]) - 1;
+
+	hash_table **tables = malloc(TINY_TABLES * sizeof(hash_table *));
+	if (tables == NULL) {
+		return;
+	}
+
+	size_t heap = bench_heap_used();
+	double start = bench_now();
+
+	size_t i = 0, j = 0;
+	for (i = 0; i < TINY_TABLES; i++) {
+		tables[i] = hash_table_new_with_options(options);
+		for (j = 0; j < field_count; j++) {
+			hash_table_set(tables[i], fields[j], fields[j], NULL);
+		}
+	}
+
+	double build = bench_now() - start;
+	size_t used = bench_heap_used() - heap;
+	uint64_t found = 0;
+	start = bench_now();
+
+	size_t round = 0;
+	for (round = 0; round < TINY_LOOKUP_ROUNDS; round++) {
+		for (i = 0; i < TINY_TABLES; i++) {
+			for (j = 0; j <= field_count; j++) {
+				found += hash_table_get(tables[i], fields[j]) != NULL;
+			}
+		}
+	}
+
+	double get = bench_now() - start;
+	bench_sink += found;
+
+	for (i = 0; i < TINY_TABLES; i++) {
+		hash_table_free(tables[i]);
+	}
+
+	free(tables);
+
+	size_t gets = (size_t)TINY_LOOKUP_ROUNDS * TINY_TABLES * (field_count + 1);
+	printf("%-20s %8.1f ns/table build  %8.1f ns/get  %6.1f bytes/table\n", name, build * 1e9 / TINY_TABLES, get * 1e9 / gets, (double)used / TINY_TABLES);
+}
+
+/* Fills a scratch table with the keys of each of many requests,
+ * emptying it between requests either by freeing it and making a
+ * new one or by clearing it.
+ */
+void hash_table_bench_scratch(const char *name, hash_table_options *options, char *keys) {
+	double times[2];
+
+	int clear = 0;
+	for (clear = 0; clear < 2; clear++) {
+		hash_table *table = hash_table_new_with_options(options);
+		double start = bench_now();
+
+		size_t request = 0;
+		for (request = 0; request < SCRATCH_REQUESTS; request++) {
+			char *request_keys = keys + (request * SCRATCH_KEYS % (INSERT_LATENCY_KEYS - SCRATCH_KEYS)) * KEY_SIZE;
+
+			size_t i = 0;
+			for (i = 0; i < SCRATCH_KEYS; i++) {
+				hash_table_set(table, request_keys + i * KEY_SIZE, request_keys + i * KEY_SIZE, NULL);
+			}
+
+			bench_sink += table->length;
+
+			if (clear) {
+				hash_table_clear(table);
+			} else {
+				hash_table_free(table);
+				table = hash_table_new_with_options(options);
+			}
+		}
+
+		times[clear] = bench_now() - start;
+		hash_table_free(table);
+	}
+
+	printf("%-20s %8.1f us/request free and new  %8.1f us/request clear  %5.2fx\n", name, times[0] * 1e6 / SCRATCH_REQUESTS, times[1] * 1e6 / SCRATCH_REQUESTS, times[0] / times[1]);
+}
+
+void hash_table_bench() {
+	char *keys = bench_make_keys("user:%zu", INSERT_LATENCY_KEYS, KEY_SIZE);
+	double *latencies = malloc(INSERT_LATENCY_KEYS * sizeof(double));
+	if (keys == NULL || latencies == NULL) {
+		free(keys);
+		free(latencies);
+		return;
+	}
+
+	printf("Hash table insert latency (%d keys)\n", INSERT_LATENCY_KEYS);
+
+	hash_table_options chained = { .layout = HASH_TABLE_CHAINED };
+	hash_table_bench_insert_latency("chained", &chained, keys, latencies);
+
+	hash_table_options incremental = { .layout = HASH_TABLE_CHAINED, .incremental_resize = true };
+	hash_table_bench_insert_latency("chained incremental", &incremental, keys, latencies);
+
+	hash_table_options flat = { .layout = HASH_TABLE_FLAT };
+	hash_table_bench_insert_latency("flat", &flat, keys, latencies);
+
+	hash_table_options robin_hood = { .layout = HASH_TABLE_ROBIN_HOOD };
+	hash_table_bench_insert_latency("robin hood", &robin_hood, keys, latencies);
+
+	hash_table_options ordered = { .layout = HASH_TABLE_ORDERED };
+	hash_table_bench_insert_latency("ordered", &ordered, keys, latencies);
+
+	printf("\nHash table bulk load (%d keys)\n", INSERT_LATENCY_KEYS);
+	hash_table_bench_bulk_load("chained", &chained, keys, INSERT_LATENCY_KEYS);
+
+	hash_table_options chained_reserved = { .layout = HASH_TABLE_CHAINED, .capacity = INSERT_LATENCY_KEYS };
+	hash_table_bench_bulk_load("chained reserved", &chained_reserved, keys, INSERT_LATENCY_KEYS);
+
+	hash_table_bench_bulk_load("flat", &flat, keys, INSERT_LATENCY_KEYS);
+
+	hash_table_options flat_reserved = { .layout = HASH_TABLE_FLAT, .capacity = INSERT_LATENCY_KEYS };
+	hash_table_bench_bulk_load("flat reserved", &flat_reserved, keys, INSERT_LATENCY_KEYS);
+
+	printf("\nHash table build and free (%d keys)\n", INSERT_LATENCY_KEYS);
+	hash_table_bench_build_free("chained", &chained, keys, INSERT_LATENCY_KEYS);
+
+	hash_table_options chained_arena = { .layout = HASH_TABLE_CHAINED, .arena = true };
+	hash_table_bench_build_free("chained arena", &chained_arena, keys, INSERT_LATENCY_KEYS);
+
+	hash_table_bench_build_free("flat", &flat, keys, INSERT_LATENCY_KEYS);
+
+	hash_table_options flat_arena = { .layout = HASH_TABLE_FLAT, .arena = true };
+	hash_table_bench_build_free("flat arena", &flat_arena, keys, INSERT_LATENCY_KEYS);
+
+	printf("\nFrozen hash table (%d keys, frozen from flat)\n", INSERT_LATENCY_KEYS);
+	hash_table_bench_freeze(&flat, keys, INSERT_LATENCY_KEYS);
+
+	printf("\nMapped hash table (%d keys, saved from flat)\n", INSERT_LATENCY_KEYS);
+	hash_table_bench_load(&flat, keys, INSERT_LATENCY_KEYS);
+
+	printf("\nHash table iteration (%d keys, scans of %d items per call)\n", INSERT_LATENCY_KEYS, SCAN_STEP);
+	hash_table_bench_scan("chained", &chained, keys, INSERT_LATENCY_KEYS);
+	hash_table_bench_scan("flat", &flat, keys, INSERT_LATENCY_KEYS);
+	hash_table_bench_scan("robin hood", &robin_hood, keys, INSERT_LATENCY_KEYS);
+	hash_table_bench_scan("ordered", &ordered, keys, INSERT_LATENCY_KEYS);
+
+	printf("\nHash table memory (%d keys, including copies of the keys)\n", INSERT_LATENCY_KEYS);
+	hash_table_bench_memory("chained", &chained, keys, INSERT_LATENCY_KEYS);
+	hash_table_bench_memory("flat", &flat, keys, INSERT_LATENCY_KEYS);
+	hash_table_bench_memory("robin hood", &robin_hood, keys, INSERT_LATENCY_KEYS);
+	hash_table_bench_memory("ordered", &ordered, keys, INSERT_LATENCY_KEYS);
+
+	printf("\nHash table of 24-byte records (%d keys)\n", INSERT_LATENCY_KEYS);
+	hash_table_bench_records("chained pointers", &chained, keys, INSERT_LATENCY_KEYS);
+
+	hash_table_options chained_values = { .layout = HASH_TABLE_CHAINED, .value_size = sizeof(hash_table_bench_record) };
+	hash_table_bench_records("chained values", &chained_values, keys, INSERT_LATENCY_KEYS);
+
+	hash_table_bench_records("flat pointers", &flat, keys, INSERT_LATENCY_KEYS);
+
+	hash_table_options flat_values = { .layout = HASH_TABLE_FLAT, .value_size = sizeof(hash_table_bench_record) };
+	hash_table_bench_records("flat values", &flat_values, keys, INSERT_LATENCY_KEYS);
+
+	printf("\nHash table counting (%d words, %d distinct)\n", COUNT_WORDS, COUNT_VOCABULARY);
+	hash_table_bench_count("chained", &chained, keys);
+	hash_table_bench_count("flat", &flat, keys);
+	hash_table_bench_count("robin hood", &robin_hood, keys);
+	hash_table_bench_count("ordered", &ordered, keys);
+
+	printf("\nTiny hash tables (%d tables of 5 fields)\n", TINY_TABLES);
+	hash_table_bench_tiny("chained small", &chained);
+
+	hash_table_options chained_hashed = { .layout = HASH_TABLE_CHAINED, .capacity = HASH_TABLE_SMALL_SIZE + 1 };
+	hash_table_bench_tiny("chained hashed", &chained_hashed);
+
+	hash_table_bench_tiny("flat small", &flat);
+
+	hash_table_options flat_hashed = { .layout = HASH_TABLE_FLAT, .capacity = HASH_TABLE_SMALL_SIZE + 1 };
+	hash_table_bench_tiny("flat hashed", &flat_hashed);
+
+	printf("\nHash table scratch reuse (%d requests of %d keys)\n", SCRATCH_REQUESTS, SCRATCH_KEYS);
+	hash_table_bench_scratch("chained", &chained, keys);
+	hash_table_bench_scratch("chained arena", &chained_arena, keys);
+	hash_table_bench_scratch("flat arena", &flat_arena, keys);
+
+	hash_table_options ordered_arena = { .layout = HASH_TABLE_ORDERED, .arena = true };
+	hash_table_bench_scratch("ordered arena", &ordered_arena, keys);
+
+	printf("\nHash table removals (%d keys, 1%% kept, then compacted)\n", INSERT_LATENCY_KEYS);
+	hash_table_bench_drain("chained", &chained, keys, INSERT_LATENCY_KEYS);
+	hash_table_bench_drain("chained arena", &chained_arena, keys, INSERT_LATENCY_KEYS);
+	hash_table_bench_drain("flat", &flat, keys, INSERT_LATENCY_KEYS);
+	hash_table_bench_drain("robin hood", &robin_hood, keys, INSERT_LATENCY_KEYS);
+	hash_table_bench_drain("ordered", &ordered, keys, INSERT_LATENCY_KEYS);
+
+	free(keys);
+	free(latencies);
+
+	keys = bench_make_keys("user:%zu", BATCH_KEYS, KEY_SIZE);
+	if (keys == NULL) {
+		return;
+	}
+
+	printf("\nHash table batched lookups (%d keys, batches of %d)\n", BATCH_KEYS, BATCH_SIZE);
+	hash_table_bench_get_many("chained", &chained, keys);
+	hash_table_bench_get_many("flat", &flat, keys);
+
+	free(keys);
+
+	char *url_keys = bench_make_keys("https://www.example.com/catalog/products/by-category/electronics/item?id=%zu", LOOKUP_KEYS, URL_KEY_SIZE);
+	if (url_keys == NULL) {
+		return;
+	}
+
+	printf("\nHash table lookups (%d URL keys)\n", LOOKUP_KEYS);
+	hash_table_bench_lookup("chained", &chained, url_keys, URL_KEY_SIZE);
+	hash_table_bench_lookup("flat", &flat, url_keys, URL_KEY_SIZE);
+	hash_table_bench_lookup("robin hood", &robin_hood, url_keys, URL_KEY_SIZE);
+	hash_table_bench_lookup("ordered", &ordered, url_keys, URL_KEY_SIZE);
+
+	free(url_keys);
+}
@@ -0,0 +1,43 @@
+/*
+ *  bench/main.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <stdio.h>
+
+#include "bench.h"
+
+volatile uint64_t bench_sink = 0;
+
+extern void hash_bench();
+extern void hash_table_bench();
+extern void chash_table_bench();
+extern void u64_table_bench();
+extern void hash_set_bench();
+extern void sharded_table_bench();
+extern void cache_bench();
+extern void filter_bench();
+
+int main(int argc, const char * argv[])
+{
+	hash_bench();
+	printf("\n");
+	hash_table_bench();
+	printf("\n");
+	chash_table_bench();
+	printf("\n");
+	u64_table_bench();
+	printf("\n");
+	hash_set_bench();
+	printf("\n");
+	sharded_table_bench();
+	printf("\n");
+	cache_bench();
+	printf("\n");
+	filter_bench();
+
+	return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ *  bench/sharded_table.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/18/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "chash_table.h"
+#include "hash_table.h"
+#include "sharded_table.h"
+
+#define INGEST_KEYS 2000000
+#define INGEST_MAX_THREADS 8
+#define KEY_SIZE 24
+
+typedef struct {
+	sharded_table_writer *writer;
+	chash_table *concurrent;
+	hash_table *locked;
+	pthread_mutex_t *lock;
+	char *keys;
+	size_t start;
+	size_t end;
+} sharded_table_bench_worker;
+
+/* Sets a share of the keys through a sharded table's writer, in
+ * the concurrent table, or in the plain table behind one global
+ * lock.
+ */
+void *sharded_table_bench_ingest_worker(void *context) {
+	sharded_table_bench_worker *worker = context;
+
+	size_t i = 0;
+	for (i = worker->start; i < worker->end; i++) {
+		char *key = worker->keys + i * KEY_SIZE;
+
+		if (worker->writer != NULL) {
+			sharded_table_writer_set(worker->writer, key, key, NULL);
+		} else if (worker->concurrent != NULL) {
+			chash_table_set(worker->concurrent, key, key, NULL);
+		} else {
+			pthread_mutex_lock(worker->lock);
+			hash_table_set(worker->locked, key, key, NULL);
+			pthread_mutex_unlock(worker->lock);
+		}
+	}
+
+	return NULL;
+}
+
+/* Ingests every key with a number of threads into one kind of
+ * table; a sharded table is given to sharded, and is then merged
+ * with the same number of threads.
+ */
+void sharded_table_bench_ingest(const char *name, sharded_table *sharded, chash_table *concurrent, hash_table *locked, char *keys, int threads) {
+	pthread_t handles[INGEST_MAX_THREADS];
+	sharded_table_bench_worker workers[INGEST_MAX_THREADS];
+	pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+	double start = bench_now();
+
+	int i = 0;
+	for (i = 0; i < threads; i++) {
+		sharded_table_writer *writer = (sharded != NULL) ? sharded_table_writer_new(sharded) : NULL;
+		workers[i] = (sharded_table_bench_worker){writer, concurrent, locked, &lock, keys,
+			(size_t)INGEST_KEYS * i / threads, (size_t)INGEST_KEYS * (i + 1) / threads};
+		pthread_create(&handles[i], NULL, &sharded_table_bench_ingest_worker, &workers[i]);
+	}
+
+	for (i = 0; i < threads; i++) {
+		pthread_join(handles[i], NULL);
+	}
+
+	double ingest = bench_now() - start;
+
+	if (sharded == NULL) {
+		printf("%-20s %d threads %8.2f Mkeys/s\n", name, threads, INGEST_KEYS / ingest / 1e6);
+		return;
+	}
+
+	start = bench_now();
+	sharded_table_merge(sharded, threads);
+	double merge = bench_now() - start;
+
+	bench_sink += sharded_table_length(sharded);
+
+	printf("%-20s %d threads %8.2f Mkeys/s  (%.0f ms ingest, %.0f ms merge)\n", name, threads,
+		INGEST_KEYS / (ingest + merge) / 1e6, ingest * 1e3, merge * 1e3);
+}
+
+void sharded_table_bench() {
+	char *keys = bench_make_keys("user:%zu", INGEST_KEYS, KEY_SIZE);
+	if (keys == NULL) {
+		return;
+	}
+
+	printf("Parallel ingest (%d keys)\n", INGEST_KEYS);
+
+	int threads = 1;
+	for (threads = 1; threads <= INGEST_MAX_THREADS; threads *= 2) {
+		sharded_table_options options = { .table = { .layout = HASH_TABLE_FLAT } };
+		sharded_table *sharded = sharded_table_new_with_options(&options);
+		chash_table *concurrent = chash_table_new();
+		hash_table_options flat = { .layout = HASH_TABLE_FLAT };
+		hash_table *locked = hash_table_new_with_options(&flat);
+		if (sharded == NULL || concurrent == NULL || locked == NULL) {
+			break;
+		}
+
+		sharded_table_bench_ingest("sharded_table", sharded, NULL, NULL, keys, threads);
+		sharded_table_bench_ingest("chash_table", NULL, concurrent, NULL, keys, threads);
+		sharded_table_bench_ingest("locked hash_table", NULL, NULL, locked, keys, threads);
+
+		sharded_table_free(sharded);
+		chash_table_free(concurrent);
+		hash_table_free(locked);
+	}
+
+	free(keys);
+}
@@ -0,0 +1,126 @@
+/*
+ *  bench/u64_table.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "hash_table.h"
+#include "u64_table.h"
+
+#define ID_KEYS 2000000
+#define ID_LOOKUPS 4000000
+
+/* Makes an array of count 64-bit IDs, scattered the way database
+ * IDs handed out by several shards would be.
+ *
+ * Returns the IDs, or NULL if they couldn't be allocated.
+ */
+uint64_t *u64_table_bench_make_ids(size_t count) {
+	uint64_t *ids = malloc(count * sizeof(uint64_t));
+	if (ids == NULL) {
+		return NULL;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < count; i++) {
+		ids[i] = ((uint64_t)(i % 16) << 48) | (1000000000ULL + i * 7);
+	}
+
+	return ids;
+}
+
+/* Sets and then looks up every ID in a u64_table.
+ */
+void u64_table_bench_ids(uint64_t *ids) {
+	double start = bench_now();
+
+	u64_table *table = u64_table_new();
+	if (table == NULL) {
+		return;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < ID_KEYS; i++) {
+		u64_table_set_u64(table, ids[i], i);
+	}
+
+	double set = bench_now() - start;
+	uint64_t found = 0, value = 0;
+	start = bench_now();
+
+	for (i = 0; i < ID_LOOKUPS; i++) {
+		found += u64_table_get_u64(table, ids[(i * 7919) % ID_KEYS], &value) ? value : 0;
+	}
+
+	double get = bench_now() - start;
+	bench_sink += found;
+
+	printf("%-20s %8.1f ns/set  %8.1f ns/get  %6.1f bytes/key\n", "u64_table", set * 1e9 / ID_KEYS, get * 1e9 / ID_LOOKUPS,
+		(double)table->bucket_count * 2 * sizeof(uint64_t) / ID_KEYS);
+
+	u64_table_free(table);
+}
+
+/* Sets and then looks up every ID in a string-keyed hash_table,
+ * formatting each ID as its key.
+ */
+void u64_table_bench_string_ids(const char *name, hash_table_options *options, uint64_t *ids) {
+	static uint64_t values[ID_KEYS];
+	char key[24];
+
+	double start = bench_now();
+
+	hash_table *table = hash_table_new_with_options(options);
+	if (table == NULL) {
+		return;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < ID_KEYS; i++) {
+		values[i] = i;
+		snprintf(key, sizeof(key), "%llu", (unsigned long long)ids[i]);
+		hash_table_set(table, &values[i], key, NULL);
+	}
+
+	double set = bench_now() - start;
+	uint64_t found = 0;
+	start = bench_now();
+
+	for (i = 0; i < ID_LOOKUPS; i++) {
+		snprintf(key, sizeof(key), "%llu", (unsigned long long)ids[(i * 7919) % ID_KEYS]);
+
+		uint64_t *value = hash_table_get(table, key);
+		found += (value != NULL) ? *value : 0;
+	}
+
+	double get = bench_now() - start;
+	bench_sink += found;
+
+	printf("%-20s %8.1f ns/set  %8.1f ns/get\n", name, set * 1e9 / ID_KEYS, get * 1e9 / ID_LOOKUPS);
+
+	hash_table_free(table);
+}
+
+void u64_table_bench() {
+	uint64_t *ids = u64_table_bench_make_ids(ID_KEYS);
+	if (ids == NULL) {
+		return;
+	}
+
+	printf("Integer IDs (%d keys, %d lookups)\n", ID_KEYS, ID_LOOKUPS);
+	u64_table_bench_ids(ids);
+
+	hash_table_options chained = { .layout = HASH_TABLE_CHAINED };
+	u64_table_bench_string_ids("hash_table chained", &chained, ids);
+
+	hash_table_options flat = { .layout = HASH_TABLE_FLAT };
+	u64_table_bench_string_ids("hash_table flat", &flat, ids);
+
+	free(ids);
+}
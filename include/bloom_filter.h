@@ -0,0 +1,46 @@
+/*
+ *  bloom_filter.h
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#ifndef Data_Structures_bloom_filter_h
+#define Data_Structures_bloom_filter_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* The number of 32-bit words in each block of a Bloom filter; each
+ * key sets one bit in every word of one block
+ */
+#define BLOOM_FILTER_BLOCK_WORDS 8
+
+struct bloom_filter_block;
+
+typedef struct bloom_filter {
+	/* The blocks of the filter, each the size of half a cache line
+	 * and aligned so that it never spans two
+	 */
+	struct bloom_filter_block *blocks;
+
+	/* The number of blocks
+	 */
+	size_t block_count;
+
+	/* The number of keys added to the filter
+	 */
+	size_t length;
+} bloom_filter;
+
+extern bloom_filter *bloom_filter_new(size_t count, double false_positive_rate);
+extern void bloom_filter_add(bloom_filter *filter, const void *key, size_t length);
+extern void bloom_filter_add_hash(bloom_filter *filter, uint64_t hash);
+extern bool bloom_filter_contains(const bloom_filter *filter, const void *key, size_t length);
+extern bool bloom_filter_contains_hash(const bloom_filter *filter, uint64_t hash);
+extern double bloom_filter_false_positive_rate(const bloom_filter *filter);
+extern void bloom_filter_free(bloom_filter *filter);
+
+#endif
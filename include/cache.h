@@ -0,0 +1,96 @@
+/*
+ *  cache.h
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#ifndef Data_Structures_cache_h
+#define Data_Structures_cache_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash_table.h"
+
+typedef enum {
+	/* Entries are evicted in order of their last use; every hit
+	 * moves its entry to the front of the recency list
+	 */
+	CACHE_LRU,
+
+	/* Entries are evicted roughly in order of their last use, by
+	 * second chance: a hit only marks its entry as referenced, and
+	 * referenced entries are moved to the front of the list, with
+	 * their marks cleared, when they come up for eviction
+	 */
+	CACHE_CLOCK
+} cache_policy;
+
+typedef struct {
+	/* The order entries are evicted in
+	 */
+	cache_policy policy;
+
+	/* The total size of the entries the cache may hold, in
+	 * whatever units sizes are given to cache_put in
+	 */
+	size_t capacity;
+
+	/* A function to call with each value that leaves the cache,
+	 * whether it is evicted, replaced, removed or freed with the
+	 * cache, or NULL to call no function
+	 */
+	void (*evict_function)(const char *key, size_t length, void *value, void *context);
+
+	/* The context passed to evict_function
+	 */
+	void *evict_context;
+} cache_options;
+
+struct cache_entry;
+
+typedef struct {
+	/* The order entries are evicted in
+	 */
+	cache_policy policy;
+
+	/* The total size of the entries the cache may hold, and of
+	 * those it holds
+	 */
+	size_t capacity;
+	size_t size;
+
+	/* The number of entries in the cache
+	 */
+	unsigned int length;
+
+	/* The entries of the cache, by key
+	 */
+	hash_table *entries;
+
+	/* The ends of the recency list, which links the entries
+	 * themselves; the newest entry is the most recently used,
+	 * and the oldest is the next to be considered for eviction
+	 */
+	struct cache_entry *newest;
+	struct cache_entry *oldest;
+
+	void (*evict_function)(const char *key, size_t length, void *value, void *context);
+	void *evict_context;
+} cache;
+
+extern cache *cache_new(size_t capacity);
+extern cache *cache_new_with_options(const cache_options *options);
+extern bool cache_put(cache *cache, void *value, char *key, size_t size);
+extern bool cache_put_bytes(cache *cache, void *value, const void *key, size_t length, size_t size);
+extern void *cache_get(cache *cache, char *key);
+extern void *cache_get_bytes(cache *cache, const void *key, size_t length);
+extern bool cache_remove(cache *cache, char *key);
+extern bool cache_remove_bytes(cache *cache, const void *key, size_t length);
+extern void cache_free(cache *cache);
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ *  chash_table.h
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#ifndef Data_Structures_chash_table_h
+#define Data_Structures_chash_table_h
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash.h"
+
+struct chash_buckets;
+struct chash_stripe;
+struct chash_node;
+
+typedef struct {
+	/* The hash function used to build the table
+	 */
+	uint64_t (*hash_function)(const void *, size_t, uint64_t);
+
+	/* The seed passed to the hash function
+	 */
+	uint64_t seed;
+
+	/* The current bucket array. While the table is growing,
+	 * buckets that have been moved to the next, larger array
+	 * are marked as moved.
+	 */
+	struct chash_buckets *buckets;
+
+	/* The locks that writers hold while changing buckets, each
+	 * covering every bucket whose index is equal to the lock's
+	 * index modulo stripe_count
+	 */
+	struct chash_stripe *stripes;
+
+	/* The number of locks in stripes
+	 */
+	unsigned int stripe_count;
+
+	/* Removed items and replaced bucket arrays that may still be
+	 * in use by concurrent readers, newest first
+	 */
+	struct chash_node *garbage_nodes;
+	struct chash_buckets *garbage_buckets;
+
+	/* The number of removed items and bucket arrays waiting to be
+	 * freed
+	 */
+	unsigned int garbage_count;
+
+	/* The lock held while adding to or freeing garbage
+	 */
+	pthread_mutex_t garbage_lock;
+} chash_table;
+
+extern chash_table *chash_table_new();
+extern chash_table *chash_table_new_with_capacity(unsigned int capacity);
+extern bool chash_table_set(chash_table *table, void *elem, char *key, void (*release_function)(void *));
+extern bool chash_table_set_bytes(chash_table *table, void *elem, const void *key, size_t length, void (*release_function)(void *));
+extern void *chash_table_get(chash_table *table, char *key);
+extern void *chash_table_get_bytes(chash_table *table, const void *key, size_t length);
+extern bool chash_table_remove(chash_table *table, char *key);
+extern bool chash_table_remove_bytes(chash_table *table, const void *key, size_t length);
+extern unsigned long chash_table_length(chash_table *table);
+extern void chash_table_free(chash_table *table);
+
+#endif
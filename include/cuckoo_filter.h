@@ -0,0 +1,58 @@
+/*
+ *  cuckoo_filter.h
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#ifndef Data_Structures_cuckoo_filter_h
+#define Data_Structures_cuckoo_filter_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* The number of fingerprints in each bucket of a cuckoo filter
+ */
+#define CUCKOO_FILTER_BUCKET_SIZE 4
+
+typedef struct cuckoo_filter {
+	/* The buckets of the filter, each holding
+	 * CUCKOO_FILTER_BUCKET_SIZE fingerprints, where a fingerprint
+	 * of zero marks an empty entry
+	 */
+	unsigned char *buckets;
+
+	/* The number of buckets
+	 */
+	size_t bucket_count;
+
+	/* The number of bits in each fingerprint, either 8 or 16
+	 */
+	unsigned int fingerprint_bits;
+
+	/* The number of keys in the filter
+	 */
+	size_t length;
+
+	/* A fingerprint that couldn't be placed when the filter filled
+	 * up, and one of the two buckets it belongs in; once there is
+	 * one, nothing more can be added
+	 */
+	bool has_victim;
+	uint32_t victim_fingerprint;
+	size_t victim_index;
+} cuckoo_filter;
+
+extern cuckoo_filter *cuckoo_filter_new(size_t count, double false_positive_rate);
+extern bool cuckoo_filter_add(cuckoo_filter *filter, const void *key, size_t length);
+extern bool cuckoo_filter_add_hash(cuckoo_filter *filter, uint64_t hash);
+extern bool cuckoo_filter_contains(const cuckoo_filter *filter, const void *key, size_t length);
+extern bool cuckoo_filter_contains_hash(const cuckoo_filter *filter, uint64_t hash);
+extern bool cuckoo_filter_remove(cuckoo_filter *filter, const void *key, size_t length);
+extern bool cuckoo_filter_remove_hash(cuckoo_filter *filter, uint64_t hash);
+extern void cuckoo_filter_clear(cuckoo_filter *filter);
+extern void cuckoo_filter_free(cuckoo_filter *filter);
+
+#endif
@@ -0,0 +1,19 @@
+/*
+ *  hash.h
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#ifndef Data_Structures_hash_h
+#define Data_Structures_hash_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+extern uint64_t hash_fast(const void *key, size_t length, uint64_t seed);
+extern uint64_t hash_keyed(const void *key, size_t length, uint64_t seed);
+extern uint64_t hash_random_seed();
+
+#endif
@@ -0,0 +1,88 @@
+/*
+ *  hash_set.h
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/18/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#ifndef Data_Structures_hash_set_h
+#define Data_Structures_hash_set_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash_table.h"
+
+/* The longest keys stored inside their slots by default
+ */
+#define HASH_SET_INLINE_KEY_SIZE 7
+
+typedef struct {
+	/* The hash function to use for the set
+	 */
+	hash_table_hash hash;
+
+	/* The number of keys the set should be able to hold before
+	 * it first grows
+	 */
+	unsigned int capacity;
+
+	/* The longest keys to store inside their slots rather than in
+	 * the set's key storage, or zero for HASH_SET_INLINE_KEY_SIZE;
+	 * slots are made large enough to hold them, rounded up to a
+	 * multiple of eight bytes, so this trades memory for sets of
+	 * long keys against speed for sets of short ones
+	 */
+	unsigned int inline_key_size;
+} hash_set_options;
+
+typedef struct {
+	/* The hash function used to build the set, and its seed
+	 */
+	uint64_t (*hash_function)(const void *, size_t, uint64_t);
+	uint64_t seed;
+
+	/* The number of slots, which is always a power of two
+	 */
+	unsigned int bucket_count;
+
+	/* The number of keys in the set
+	 */
+	unsigned int length;
+
+	/* The slots, each slot_size bytes long, holding part of its
+	 * key's hash, its key's length, and either the key itself or
+	 * where to find it in keys
+	 */
+	char *slots;
+	size_t slot_size;
+	unsigned int inline_key_size;
+
+	/* Storage for keys too long to be inline, each followed by a
+	 * zero byte; removing a key leaves its bytes unused until the
+	 * storage is compacted
+	 */
+	char *keys;
+	size_t keys_used;
+	size_t keys_size;
+	size_t keys_unused;
+} hash_set;
+
+extern hash_set *hash_set_new();
+extern hash_set *hash_set_new_with_options(const hash_set_options *options);
+extern bool hash_set_insert(hash_set *set, char *key);
+extern bool hash_set_insert_bytes(hash_set *set, const void *key, size_t length);
+extern bool hash_set_contains(const hash_set *set, char *key);
+extern bool hash_set_contains_bytes(const hash_set *set, const void *key, size_t length);
+extern bool hash_set_remove(hash_set *set, char *key);
+extern bool hash_set_remove_bytes(hash_set *set, const void *key, size_t length);
+extern hash_set *hash_set_union(const hash_set *set, const hash_set *other);
+extern hash_set *hash_set_intersection(const hash_set *set, const hash_set *other);
+extern hash_set *hash_set_difference(const hash_set *set, const hash_set *other);
+extern void hash_set_foreach(const hash_set *set, void (*visit)(const char *key, size_t length, void *context), void *context);
+extern void hash_set_free(hash_set *set);
+
+#endif
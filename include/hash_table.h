@@ -11,22 +11,204 @@
 
 #include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#include "dll.h"
+#include "hash.h"
+
+typedef enum {
+	/* Each bucket is a linked list of separately allocated items
+	 */
+	HASH_TABLE_CHAINED,
+	
+	/* Items are stored inline in one flat array of slots, which is
+	 * probed sixteen slots at a time using a parallel array of
+	 * one-byte control codes
+	 */
+	HASH_TABLE_FLAT,
+	
+	/* Items are stored inline in one flat array of slots, which is
+	 * probed linearly, with items kept close to their home slots
+	 * by Robin Hood insertion; this allows a high load factor
+	 */
+	HASH_TABLE_ROBIN_HOOD,
+	
+	/* Items are stored in an immutable array indexed by a minimal
+	 * perfect hash of their keys; tables are only given this
+	 * layout by hash_table_freeze
+	 */
+	HASH_TABLE_FROZEN,
+	
+	/* Items are stored in a dense array in the order they were
+	 * added, which is the order hash_table_foreach visits them in,
+	 * and found through a sparse index of one-, two- or four-byte
+	 * positions in that array
+	 */
+	HASH_TABLE_ORDERED
+} hash_table_layout;
+
+typedef enum {
+	/* A fast, well-distributed hash with a fixed seed (hash_fast)
+	 */
+	HASH_TABLE_HASH_FAST,
+	
+	/* A keyed hash with a random per-table seed (hash_keyed),
+	 * for tables whose keys may be chosen by an attacker
+	 */
+	HASH_TABLE_HASH_KEYED
+} hash_table_hash;
+
+typedef struct {
+	/* The storage layout to use for the table
+	 */
+	hash_table_layout layout;
+	
+	/* The hash function to use for the table
+	 */
+	hash_table_hash hash;
+	
+	/* Whether a chained table should spread the work of growing
+	 * over later calls, moving a few buckets to the new bucket
+	 * array on each set and get, rather than moving every item
+	 * in the call that triggered the growth
+	 */
+	bool incremental_resize;
+	
+	/* The number of items the table should be able to hold
+	 * before it first grows
+	 */
+	unsigned int capacity;
+	
+	/* Whether keys and chain nodes should be carved out of large
+	 * slabs owned by the table rather than allocated one by one,
+	 * so that they are freed together with the table in one pass
+	 * over the slabs. Memory in slabs is not reused before the
+	 * table is freed.
+	 */
+	bool arena;
+	
+	/* The size in bytes of each value, which is copied into the
+	 * table next to its key, or zero for a table of pointers
+	 */
+	size_t value_size;
+} hash_table_options;
+
+/* The most items a table holds in its small form, in which its
+ * keys are searched one after another without being hashed. New
+ * tables made to hold no more items start in the small form, and
+ * move into the storage of their layout when they outgrow it.
+ */
+#define HASH_TABLE_SMALL_SIZE 8
+
+/* The number of probe and chain lengths counted separately by
+ * hash_table_get_stats; longer ones are counted together in the
+ * last entry of each histogram
+ */
+#define HASH_TABLE_STATS_HISTOGRAM_SIZE 16
+
+#ifdef HASH_TABLE_STATS
+typedef struct {
+	/* The number of calls to get a key's value, and the number of
+	 * them that found a value
+	 */
+	uint64_t gets;
+	uint64_t hits;
+	
+	/* The number of searches made for keys to get, set or remove
+	 * them, and the number of stored items whose hashes were
+	 * compared with the keys
+	 */
+	uint64_t searches;
+	uint64_t comparisons;
+	
+	/* The number of times the table's storage was rebuilt, and the
+	 * total wall time spent doing so; for incremental resizes, only
+	 * the call that starts the resize is timed
+	 */
+	uint64_t resizes;
+	double resize_seconds;
+} hash_table_counters;
+
+typedef struct {
+	hash_table_layout layout;
+	unsigned int length;
+	unsigned int bucket_count;
+	unsigned int occupied_buckets;
+	
+	/* The number of items per bucket, or per slot for layouts
+	 * other than chained
+	 */
+	double load_factor;
+	
+	/* The number of items found after each number of probes,
+	 * starting at one probe; probes are nodes for chained tables,
+	 * groups for flat tables and slots for Robin Hood tables
+	 */
+	unsigned long probe_lengths[HASH_TABLE_STATS_HISTOGRAM_SIZE];
+	unsigned int max_probe_length;
+	double mean_probe_length;
+	
+	/* For chained tables, the number of buckets holding each number
+	 * of items, starting at zero items
+	 */
+	unsigned long chain_lengths[HASH_TABLE_STATS_HISTOGRAM_SIZE];
+	
+	hash_table_counters counters;
+} hash_table_stats;
+#endif
+
+struct hash_table_item;
+struct hash_table_node;
+struct hash_table_slab;
+struct hash_table_frozen;
+struct cuckoo_filter;
 
 typedef struct {
 	/* The hash function used to build the table
 	 */
-	unsigned int (*hash_function)(char *);
+	uint64_t (*hash_function)(const void *, size_t, uint64_t);
+	
+	/* The seed passed to the hash function
+	 */
+	uint64_t seed;
+	
+	/* The storage layout used by the table
+	 */
+	hash_table_layout layout;
+	
+	/* Whether the table grows incrementally
+	 */
+	bool incremental_resize;
+	
+	/* The size in bytes of each value stored in the table, or zero
+	 * if values are pointers stored as given
+	 */
+	size_t value_size;
+	
+	/* Whether the table is in its small form, with its items
+	 * packed at the start of slots in the order they were added,
+	 * and a tag of each key's length and first bytes in small_tags
+	 */
+	bool small;
+	uint32_t small_tags[HASH_TABLE_SMALL_SIZE];
 	
-	/* The number of buckets allocated for the table
+	/* The number of buckets allocated for the table, which is
+	 * always a power of two; for flat tables, this is the
+	 * number of slots, and for small tables, the number of items
+	 * there is room for in slots
 	 */
 	unsigned int bucket_count;
 	
-	/* The number of occupied buckets
+	/* The number of buckets the table was created with, which it
+	 * doesn't shrink below as items are removed
+	 */
+	unsigned int min_bucket_count;
+	
+	/* The number of occupied buckets, counting those of both
+	 * bucket arrays while a chained table is being resized;
+	 * for flat tables, this is the number of slots in use
 	 */
 	unsigned int occupied_buckets;
 	
@@ -34,15 +216,125 @@ typedef struct {
 	 */
 	unsigned int length;
 	
-	/* An array of pointers to the linked lists
-	 * actually used to store items
+	/* An array of pointers to the first item of each bucket's
+	 * chain of items
+	 */
+	struct hash_table_node **items;
+	
+	/* While a chained table is being resized, the bucket array
+	 * that items are being moved out of, or NULL otherwise
+	 */
+	struct hash_table_node **old_items;
+	
+	/* The number of buckets in old_items
+	 */
+	unsigned int old_bucket_count;
+	
+	/* The index of the next bucket in old_items to be moved;
+	 * buckets before it are already empty
+	 */
+	unsigned int rehash_index;
+	
+	/* The control bytes of a flat table, one per slot, each
+	 * either marking the slot as empty or holding seven bits
+	 * of the hash of the slot's key
+	 */
+	signed char *control;
+	
+	/* The slots of a flat or Robin Hood table, or the entries of an
+	 * ordered table in the order they were added, where removed
+	 * entries have a NULL key
 	 */
-	ll_dlist **items;
+	struct hash_table_item *slots;
+	
+	/* The index of an ordered table, holding for each of its
+	 * bucket_count slots the position of an entry plus one, or
+	 * zero for an empty slot, in index_width bytes
+	 */
+	void *index;
+	unsigned int index_width;
+	
+	/* The number of entries of an ordered table in use, including
+	 * removed ones, and the number it has room for
+	 */
+	unsigned int entry_count;
+	unsigned int entry_capacity;
+	
+	/* The distance of the item in each slot of a Robin Hood table
+	 * from its home slot, plus one, or zero for an empty slot
+	 */
+	unsigned char *distances;
+	
+	/* After the table is cleared, the epoch of each chunk of its
+	 * slots, whose metadata is stale until the chunk is next used
+	 * if it isn't the table's epoch, or NULL if no chunk is stale
+	 */
+	unsigned char *epochs;
+	unsigned char epoch;
+	
+	/* The perfect hash and entries of a frozen table, which may
+	 * be mapped from a file by hash_table_load
+	 */
+	struct hash_table_frozen *frozen;
+	
+	/* Whether keys and chain nodes are allocated from slabs
+	 */
+	bool arena;
+	
+	/* The slabs of the table's arena, newest first
+	 */
+	struct hash_table_slab *slabs;
+	
+	/* Whether any item has been given a release function, so
+	 * that freeing the table must visit every item
+	 */
+	bool releases_values;
+	
+	/* A filter of the hashes of the table's keys, consulted before
+	 * each lookup so that most misses skip the table, or NULL
+	 */
+	struct cuckoo_filter *filter;
+	
+	/* Whether a filter was dropped when the table was cleared, and
+	 * should be built again once the table holds enough keys
+	 */
+	bool filter_pending;
+	
+#ifdef HASH_TABLE_STATS
+	/* Counters of the table's use, for hash_table_get_stats
+	 */
+	hash_table_counters counters;
+#endif
 } hash_table;
 
 extern hash_table *hash_table_new();
+extern hash_table *hash_table_new_with_capacity(unsigned int capacity);
+extern hash_table *hash_table_new_with_value_size(size_t value_size);
+extern hash_table *hash_table_new_with_options(const hash_table_options *options);
+extern bool hash_table_reserve(hash_table *table, unsigned int capacity);
 extern bool hash_table_set(hash_table *table, void *elem, char *key, void (*release_function)(void *));
+extern bool hash_table_set_bytes(hash_table *table, void *elem, const void *key, size_t length, void (*release_function)(void *));
+extern void **hash_table_get_or_insert(hash_table *table, char *key, bool *inserted);
+extern void **hash_table_get_or_insert_bytes(hash_table *table, const void *key, size_t length, bool *inserted);
 extern void *hash_table_get(hash_table *table, char *key);
+extern void *hash_table_get_bytes(hash_table *table, const void *key, size_t length);
+extern void hash_table_get_many(hash_table *table, char **keys, size_t count, void **values);
+extern bool hash_table_remove(hash_table *table, char *key);
+extern bool hash_table_remove_bytes(hash_table *table, const void *key, size_t length);
+extern bool hash_table_clear(hash_table *table);
+extern bool hash_table_compact(hash_table *table);
+extern bool hash_table_add_filter(hash_table *table);
+extern unsigned long hash_table_scan(hash_table *table, unsigned long cursor, unsigned int count, void (*visit)(const char *key, size_t length, void *value, void *context), void *context);
+extern void hash_table_foreach(hash_table *table, void (*visit)(const char *key, size_t length, void *value, void *context), void *context);
+extern void hash_table_probe_lengths(hash_table *table, unsigned int *max, double *mean);
+#ifdef HASH_TABLE_STATS
+extern void hash_table_get_stats(hash_table *table, hash_table_stats *stats);
+extern void hash_table_print_stats(hash_table *table, FILE *file);
+#endif
+extern bool hash_table_freeze(hash_table *table);
+extern double hash_table_frozen_bits_per_key(hash_table *table);
+extern bool hash_table_save(hash_table *table, const char *path, size_t (*value_length)(void *value));
+extern hash_table *hash_table_load(const char *path);
 extern void hash_table_free(hash_table *table);
 
 #endif
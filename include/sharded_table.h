@@ -0,0 +1,85 @@
+/*
+ *  sharded_table.h
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/18/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#ifndef Data_Structures_sharded_table_h
+#define Data_Structures_sharded_table_h
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash_table.h"
+
+struct sharded_table_writer;
+
+typedef struct {
+	/* The number of shards, or zero for several per available
+	 * processor
+	 */
+	unsigned int shard_count;
+
+	/* The options each shard is created with; the capacity is
+	 * divided between the shards
+	 */
+	hash_table_options table;
+} sharded_table_options;
+
+typedef struct {
+	/* The hash function and seed shared by every shard, so that a
+	 * key is hashed only once to pick its shard and find its place
+	 * in it
+	 */
+	uint64_t (*hash_function)(const void *, size_t, uint64_t);
+	uint64_t seed;
+
+	/* The options shards and writers' sub-tables are created with
+	 */
+	hash_table_options options;
+
+	/* The shards, each holding the keys whose hashes' high bits
+	 * select it
+	 */
+	unsigned int shard_count;
+	hash_table **shards;
+
+	/* The writers created for the table, newest first, and the lock
+	 * held while adding to them
+	 */
+	struct sharded_table_writer *writers;
+	pthread_mutex_t writers_lock;
+} sharded_table;
+
+typedef struct sharded_table_writer {
+	sharded_table *table;
+
+	/* The writer's sub-table for each shard, or NULL for shards it
+	 * hasn't written to since the last merge
+	 */
+	hash_table **shards;
+
+	struct sharded_table_writer *next;
+} sharded_table_writer;
+
+extern sharded_table *sharded_table_new();
+extern sharded_table *sharded_table_new_with_options(const sharded_table_options *options);
+extern sharded_table_writer *sharded_table_writer_new(sharded_table *table);
+extern bool sharded_table_writer_set(sharded_table_writer *writer, void *elem, char *key, void (*release_function)(void *));
+extern bool sharded_table_writer_set_bytes(sharded_table_writer *writer, void *elem, const void *key, size_t length, void (*release_function)(void *));
+extern bool sharded_table_merge(sharded_table *table, unsigned int threads);
+extern bool sharded_table_set(sharded_table *table, void *elem, char *key, void (*release_function)(void *));
+extern bool sharded_table_set_bytes(sharded_table *table, void *elem, const void *key, size_t length, void (*release_function)(void *));
+extern void *sharded_table_get(sharded_table *table, char *key);
+extern void *sharded_table_get_bytes(sharded_table *table, const void *key, size_t length);
+extern bool sharded_table_remove(sharded_table *table, char *key);
+extern bool sharded_table_remove_bytes(sharded_table *table, const void *key, size_t length);
+extern unsigned long sharded_table_length(sharded_table *table);
+extern void sharded_table_free(sharded_table *table);
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ *  u64_table.h
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#ifndef Data_Structures_u64_table_h
+#define Data_Structures_u64_table_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct u64_table_slot;
+
+typedef struct {
+	/* The number of slots, which is always a power of two
+	 */
+	unsigned int bucket_count;
+
+	/* The number of bits a key's hash is shifted right by to
+	 * get its home slot
+	 */
+	unsigned int shift;
+
+	/* The number of items in the table
+	 */
+	unsigned int length;
+
+	/* The slots, each holding a key and its value inline; a slot
+	 * whose key is zero is empty
+	 */
+	struct u64_table_slot *slots;
+
+	/* Whether the table holds the key zero, which can't be stored
+	 * in a slot, and its value
+	 */
+	bool has_zero_key;
+	uint64_t zero_value;
+} u64_table;
+
+extern u64_table *u64_table_new();
+extern u64_table *u64_table_new_with_capacity(unsigned int capacity);
+extern bool u64_table_reserve(u64_table *table, unsigned int capacity);
+extern bool u64_table_set(u64_table *table, uint64_t key, void *value);
+extern void *u64_table_get(u64_table *table, uint64_t key);
+extern bool u64_table_set_u64(u64_table *table, uint64_t key, uint64_t value);
+extern bool u64_table_get_u64(u64_table *table, uint64_t key, uint64_t *value);
+extern bool u64_table_remove(u64_table *table, uint64_t key);
+extern void u64_table_free(u64_table *table);
+
+#endif
@@ -0,0 +1,373 @@
+/*
+ *  cache.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include "cache.h"
+
+/* An entry of a cache, which is its own node in the recency list,
+ * so that moving or unlinking it takes no search and no allocation.
+ * Its key is kept for the evict function and to remove it from the
+ * hash table when it is evicted.
+ */
+typedef struct cache_entry {
+	struct cache_entry *newer;
+	struct cache_entry *older;
+	void *value;
+	size_t size;
+
+	/* Whether the entry has been hit since it was inserted or last
+	 * given a second chance, for CACHE_CLOCK
+	 */
+	bool referenced;
+
+	size_t key_length;
+	char key[];
+} cache_entry;
+
+void _cache_link_newest(cache *cache, cache_entry *entry);
+void _cache_unlink(cache *cache, cache_entry *entry);
+void _cache_drop(cache *cache, cache_entry *entry);
+void _cache_touch(cache *cache, cache_entry *entry);
+cache_entry *_cache_victim(cache *cache);
+
+/* Private: Adds an entry to the newest end of a cache's recency
+ *          list.
+ *
+ * cache - The cache the entry belongs to.
+ * entry - The entry, which must not be in the list.
+ *
+ * Returns nothing.
+ */
+void _cache_link_newest(cache *cache, cache_entry *entry) {
+	entry->newer = NULL;
+	entry->older = cache->newest;
+
+	if (cache->newest != NULL) {
+		cache->newest->newer = entry;
+	} else {
+		cache->oldest = entry;
+	}
+
+	cache->newest = entry;
+}
+
+/* Private: Takes an entry out of a cache's recency list.
+ *
+ * cache - The cache the entry belongs to.
+ * entry - The entry, which must be in the list.
+ *
+ * Returns nothing.
+ */
+void _cache_unlink(cache *cache, cache_entry *entry) {
+	if (entry->newer != NULL) {
+		entry->newer->older = entry->older;
+	} else {
+		cache->newest = entry->older;
+	}
+
+	if (entry->older != NULL) {
+		entry->older->newer = entry->newer;
+	} else {
+		cache->oldest = entry->newer;
+	}
+}
+
+/* Private: Removes an entry from a cache, calling the evict
+ *          function with its value, and frees it.
+ *
+ * cache - The cache the entry belongs to.
+ * entry - The entry to remove.
+ *
+ * Returns nothing.
+ */
+void _cache_drop(cache *cache, cache_entry *entry) {
+	hash_table_remove_bytes(cache->entries, entry->key, entry->key_length);
+	_cache_unlink(cache, entry);
+
+	cache->size -= entry->size;
+	cache->length--;
+
+	if (cache->evict_function != NULL) {
+		cache->evict_function(entry->key, entry->key_length, entry->value, cache->evict_context);
+	}
+
+	free(entry);
+}
+
+/* Private: Marks an entry of a cache as used. For CACHE_LRU, the
+ *          entry is moved to the front of the recency list; for
+ *          CACHE_CLOCK, it is only marked as referenced, which
+ *          writes nothing if it already is.
+ *
+ * cache - The cache the entry belongs to.
+ * entry - The entry that was used.
+ *
+ * Returns nothing.
+ */
+void _cache_touch(cache *cache, cache_entry *entry) {
+	if (cache->policy == CACHE_CLOCK) {
+		if (!entry->referenced) {
+			entry->referenced = true;
+		}
+	} else if (entry != cache->newest) {
+		_cache_unlink(cache, entry);
+		_cache_link_newest(cache, entry);
+	}
+}
+
+/* Private: Chooses the next entry to evict from a cache. For
+ *          CACHE_CLOCK, referenced entries at the old end of the
+ *          list are moved to the new end with their marks cleared
+ *          until an unreferenced one is found.
+ *
+ * cache - The cache to choose an entry from, which must not be
+ *         empty.
+ *
+ * Returns the entry to evict.
+ */
+cache_entry *_cache_victim(cache *cache) {
+	cache_entry *entry = cache->oldest;
+
+	if (cache->policy == CACHE_CLOCK) {
+		while (entry->referenced) {
+			entry->referenced = false;
+
+			if (entry != cache->newest) {
+				_cache_unlink(cache, entry);
+				_cache_link_newest(cache, entry);
+			}
+
+			entry = cache->oldest;
+		}
+	}
+
+	return entry;
+}
+
+/* Public: Creates a new least recently used cache.
+ *
+ * capacity - The total size of the entries the cache may hold.
+ *
+ * Returns the new cache, or NULL if it couldn't be created.
+ */
+cache *cache_new(size_t capacity) {
+	cache_options options = { .policy = CACHE_LRU, .capacity = capacity };
+
+	return cache_new_with_options(&options);
+}
+
+/* Public: Creates a new cache with the specified options.
+ *
+ * options - The options to create the cache with.
+ *
+ * Returns the new cache, or NULL if it couldn't be created.
+ */
+cache *cache_new_with_options(const cache_options *options) {
+	cache *new_cache = malloc(sizeof(*new_cache));
+	if (new_cache == NULL) {
+		return NULL;
+	}
+
+	hash_table_options table_options = { .layout = HASH_TABLE_FLAT };
+	new_cache->entries = hash_table_new_with_options(&table_options);
+	if (new_cache->entries == NULL) {
+		free(new_cache);
+		return NULL;
+	}
+
+	new_cache->policy = options->policy;
+	new_cache->capacity = options->capacity;
+	new_cache->size = 0;
+	new_cache->length = 0;
+	new_cache->newest = NULL;
+	new_cache->oldest = NULL;
+	new_cache->evict_function = options->evict_function;
+	new_cache->evict_context = options->evict_context;
+
+	return new_cache;
+}
+
+/* Public: Puts a value in a cache under a key, replacing any value
+ *         the key already has and marking it as used, and evicts
+ *         entries until the cache is within its capacity.
+ *
+ * cache - The cache to put the value in.
+ * value - The value to cache.
+ * key - The key to cache the value under.
+ * size - The size of the entry, which counts towards the cache's
+ *        capacity.
+ *
+ * Returns true if the value was cached; otherwise, false is returned,
+ * nothing is evicted, and the evict function is not called with the
+ * value. The value is not cached if its size is more than the
+ * cache's capacity.
+ */
+bool cache_put(cache *cache, void *value, char *key, size_t size) {
+	return cache_put_bytes(cache, value, key, strlen(key), size);
+}
+
+/* Public: Puts a value in a cache under a key of arbitrary bytes,
+ *         replacing any value the key already has and marking it
+ *         as used, and evicts entries until the cache is within
+ *         its capacity.
+ *
+ * cache - The cache to put the value in.
+ * value - The value to cache.
+ * key - The key to cache the value under.
+ * length - The length of the key in bytes.
+ * size - The size of the entry, which counts towards the cache's
+ *        capacity.
+ *
+ * Returns true if the value was cached; otherwise, false is returned,
+ * nothing is evicted, and the evict function is not called with the
+ * value. The value is not cached if its size is more than the
+ * cache's capacity.
+ */
+bool cache_put_bytes(cache *cache, void *value, const void *key, size_t length, size_t size) {
+	if (size > cache->capacity) {
+		return false;
+	}
+
+	cache_entry *entry = hash_table_get_bytes(cache->entries, key, length);
+	if (entry != NULL) {
+		void *old_value = entry->value;
+
+		entry->value = value;
+		cache->size = cache->size - entry->size + size;
+		entry->size = size;
+
+		_cache_touch(cache, entry);
+
+		if (cache->evict_function != NULL && old_value != value) {
+			cache->evict_function(entry->key, entry->key_length, old_value, cache->evict_context);
+		}
+
+		while (cache->size > cache->capacity) {
+			_cache_drop(cache, _cache_victim(cache));
+		}
+
+		return true;
+	}
+
+	entry = malloc(sizeof(cache_entry) + length + 1);
+	if (entry == NULL) {
+		return false;
+	}
+
+	memcpy(entry->key, key, length);
+	entry->key[length] = '\0';
+	entry->key_length = length;
+	entry->value = value;
+	entry->size = size;
+	entry->referenced = false;
+
+	if (!hash_table_set_bytes(cache->entries, entry, key, length, NULL)) {
+		free(entry);
+		return false;
+	}
+
+	/* Nothing is evicted until the entry can no longer fail to be
+	 * added, and it isn't linked in until then so it can't be
+	 * chosen itself.
+	 */
+	while (cache->length > 0 && cache->size + size > cache->capacity) {
+		_cache_drop(cache, _cache_victim(cache));
+	}
+
+	_cache_link_newest(cache, entry);
+	cache->size += size;
+	cache->length++;
+
+	return true;
+}
+
+/* Public: Gets the value of a key in a cache, marking it as used.
+ *
+ * cache - The cache to get the value from.
+ * key - The key to get the value of.
+ *
+ * Returns the value of key in cache, or NULL if it isn't cached.
+ */
+void *cache_get(cache *cache, char *key) {
+	return cache_get_bytes(cache, key, strlen(key));
+}
+
+/* Public: Gets the value of a key of arbitrary bytes in a cache,
+ *         marking it as used.
+ *
+ * cache - The cache to get the value from.
+ * key - The key to get the value of.
+ * length - The length of the key in bytes.
+ *
+ * Returns the value of key in cache, or NULL if it isn't cached.
+ */
+void *cache_get_bytes(cache *cache, const void *key, size_t length) {
+	cache_entry *entry = hash_table_get_bytes(cache->entries, key, length);
+	if (entry == NULL) {
+		return NULL;
+	}
+
+	_cache_touch(cache, entry);
+
+	return entry->value;
+}
+
+/* Public: Removes a key from a cache, calling the evict function
+ *         with its value.
+ *
+ * cache - The cache to remove the key from.
+ * key - The key to remove.
+ *
+ * Returns true if the key was found and removed.
+ */
+bool cache_remove(cache *cache, char *key) {
+	return cache_remove_bytes(cache, key, strlen(key));
+}
+
+/* Public: Removes a key of arbitrary bytes from a cache, calling
+ *         the evict function with its value.
+ *
+ * cache - The cache to remove the key from.
+ * key - The key to remove.
+ * length - The length of the key in bytes.
+ *
+ * Returns true if the key was found and removed.
+ */
+bool cache_remove_bytes(cache *cache, const void *key, size_t length) {
+	cache_entry *entry = hash_table_get_bytes(cache->entries, key, length);
+	if (entry == NULL) {
+		return false;
+	}
+
+	_cache_drop(cache, entry);
+
+	return true;
+}
+
+/* Public: Frees memory associated with a cache, calling the evict
+ *         function with each value it holds, oldest first.
+ *
+ * cache - The cache to free.
+ *
+ * Returns nothing.
+ */
+void cache_free(cache *cache) {
+	cache_entry *entry = cache->oldest;
+	while (entry != NULL) {
+		cache_entry *newer = entry->newer;
+
+		if (cache->evict_function != NULL) {
+			cache->evict_function(entry->key, entry->key_length, entry->value, cache->evict_context);
+		}
+
+		free(entry);
+		entry = newer;
+	}
+
+	hash_table_free(cache->entries);
+	free(cache);
+}
@@ -0,0 +1,246 @@
+/*
+ *  bloom_filter.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "bloom_filter.h"
+#include "hash.h"
+
+/* A split block Bloom filter: the high half of a key's hash picks
+ * one block, and the low half is multiplied by a different odd
+ * constant for each of the block's words, the top five bits of each
+ * product picking the bit to set in that word. A lookup reads only
+ * one block, and the eight words are independent, so compilers turn
+ * the loops over them into a few vector instructions.
+ */
+#define BITS_PER_WORD 32
+#define BITS_PER_BLOCK (BLOOM_FILTER_BLOCK_WORDS * BITS_PER_WORD)
+#define BLOCK_ALIGNMENT 32
+
+typedef struct bloom_filter_block {
+	uint32_t words[BLOOM_FILTER_BLOCK_WORDS];
+} bloom_filter_block;
+
+static const uint32_t _bloom_filter_salts[BLOOM_FILTER_BLOCK_WORDS] = {
+	0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+	0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+};
+
+double _bloom_filter_expected_rate(size_t count, size_t block_count);
+
+/* Private: Gets the block a hash belongs to.
+ *
+ * filter - The filter the hash is for.
+ * hash - The hash.
+ *
+ * Returns the block.
+ */
+static inline bloom_filter_block *_bloom_filter_block(const bloom_filter *filter, uint64_t hash) {
+	return &filter->blocks[((hash >> 32) * filter->block_count) >> 32];
+}
+
+/* Private: Gets the bit a hash sets in each word of its block.
+ *
+ * hash - The hash.
+ * mask - Set to one bit for each word.
+ *
+ * Returns nothing.
+ */
+static inline void _bloom_filter_mask(uint64_t hash, uint32_t *mask) {
+	uint32_t low = (uint32_t)hash;
+
+	int i = 0;
+	for (i = 0; i < BLOOM_FILTER_BLOCK_WORDS; i++) {
+		mask[i] = 1U << ((low * _bloom_filter_salts[i]) >> (BITS_PER_WORD - 5));
+	}
+}
+
+/* Private: Gets the expected false positive rate of a filter. The
+ *          number of keys in each block follows a Poisson
+ *          distribution, and a block holding j keys has a false
+ *          positive rate of (1 - (1 - 1 / 32)^j)^8.
+ *
+ * count - The number of keys in the filter.
+ * block_count - The number of blocks.
+ *
+ * Returns the rate.
+ */
+double _bloom_filter_expected_rate(size_t count, size_t block_count) {
+	double mean = (double)count / block_count;
+	double spread = 10 * sqrt(mean) + 10;
+
+	double j = floor(fmax(0, mean - spread));
+	double last = ceil(mean + spread);
+	double rate = 0;
+
+	for (; j <= last; j++) {
+		double probability = exp(-mean + j * log(fmax(mean, 1e-300)) - lgamma(j + 1));
+		double word_rate = 1 - pow(1 - 1.0 / BITS_PER_WORD, j);
+
+		rate += probability * pow(word_rate, BLOOM_FILTER_BLOCK_WORDS);
+	}
+
+	return rate;
+}
+
+/* Public: Creates a new Bloom filter sized so that, once it holds a
+ *         number of keys, the rate of false positives is at most a
+ *         target rate.
+ *
+ * count - The number of keys the filter should hold.
+ * false_positive_rate - The target rate of false positives, above
+ *                       zero and below one.
+ *
+ * Returns the new filter, or NULL if it couldn't be created.
+ */
+bloom_filter *bloom_filter_new(size_t count, double false_positive_rate) {
+	if (!(false_positive_rate > 0 && false_positive_rate < 1)) {
+		return NULL;
+	}
+
+	if (count == 0) {
+		count = 1;
+	}
+
+	/* Doubling from about the size of a classic Bloom filter with
+	 * eight hash functions, then searching below that, finds the
+	 * fewest blocks that meet the rate.
+	 */
+	size_t high = count * 12 / BITS_PER_BLOCK + 1;
+	while (_bloom_filter_expected_rate(count, high) > false_positive_rate) {
+		if (high > UINT32_MAX / 2) {
+			return NULL;
+		}
+
+		high *= 2;
+	}
+
+	size_t low = 1;
+	while (low < high) {
+		size_t middle = low + (high - low) / 2;
+		if (_bloom_filter_expected_rate(count, middle) > false_positive_rate) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+
+	bloom_filter *filter = malloc(sizeof(bloom_filter));
+	if (filter == NULL) {
+		return NULL;
+	}
+
+	void *blocks = NULL;
+	if (posix_memalign(&blocks, BLOCK_ALIGNMENT, high * sizeof(bloom_filter_block)) != 0) {
+		free(filter);
+		return NULL;
+	}
+
+	memset(blocks, 0, high * sizeof(bloom_filter_block));
+
+	filter->blocks = blocks;
+	filter->block_count = high;
+	filter->length = 0;
+
+	return filter;
+}
+
+/* Public: Adds a key to a Bloom filter.
+ *
+ * filter - The filter to add the key to.
+ * key - The key to add.
+ * length - The length of the key in bytes.
+ *
+ * Returns nothing.
+ */
+void bloom_filter_add(bloom_filter *filter, const void *key, size_t length) {
+	bloom_filter_add_hash(filter, hash_fast(key, length, 0));
+}
+
+/* Public: Adds a key to a Bloom filter by its hash, for callers
+ *         that have already hashed the key. Every key must be
+ *         hashed the same way.
+ *
+ * filter - The filter to add the key to.
+ * hash - The key's 64-bit hash.
+ *
+ * Returns nothing.
+ */
+void bloom_filter_add_hash(bloom_filter *filter, uint64_t hash) {
+	bloom_filter_block *block = _bloom_filter_block(filter, hash);
+	uint32_t mask[BLOOM_FILTER_BLOCK_WORDS];
+	_bloom_filter_mask(hash, mask);
+
+	int i = 0;
+	for (i = 0; i < BLOOM_FILTER_BLOCK_WORDS; i++) {
+		block->words[i] |= mask[i];
+	}
+
+	filter->length++;
+}
+
+/* Public: Checks whether a key may have been added to a Bloom
+ *         filter.
+ *
+ * filter - The filter to check.
+ * key - The key to check for.
+ * length - The length of the key in bytes.
+ *
+ * Returns false if the key was never added, or true if it may
+ * have been.
+ */
+bool bloom_filter_contains(const bloom_filter *filter, const void *key, size_t length) {
+	return bloom_filter_contains_hash(filter, hash_fast(key, length, 0));
+}
+
+/* Public: Checks whether a key may have been added to a Bloom
+ *         filter by its hash.
+ *
+ * filter - The filter to check.
+ * hash - The key's 64-bit hash.
+ *
+ * Returns false if the key was never added, or true if it may
+ * have been.
+ */
+bool bloom_filter_contains_hash(const bloom_filter *filter, uint64_t hash) {
+	const bloom_filter_block *block = _bloom_filter_block(filter, hash);
+	uint32_t mask[BLOOM_FILTER_BLOCK_WORDS];
+	_bloom_filter_mask(hash, mask);
+
+	uint32_t missing = 0;
+
+	int i = 0;
+	for (i = 0; i < BLOOM_FILTER_BLOCK_WORDS; i++) {
+		missing |= mask[i] & ~block->words[i];
+	}
+
+	return missing == 0;
+}
+
+/* Public: Gets the expected rate of false positives of a Bloom
+ *         filter with the number of keys it holds.
+ *
+ * filter - The filter to get the rate of.
+ *
+ * Returns the rate.
+ */
+double bloom_filter_false_positive_rate(const bloom_filter *filter) {
+	return _bloom_filter_expected_rate(filter->length, filter->block_count);
+}
+
+/* Public: Frees memory associated with a Bloom filter.
+ *
+ * filter - The filter to free.
+ *
+ * Returns nothing.
+ */
+void bloom_filter_free(bloom_filter *filter) {
+	free(filter->blocks);
+	free(filter);
+}
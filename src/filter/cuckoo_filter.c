@@ -0,0 +1,404 @@
+/*
+ *  cuckoo_filter.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "cuckoo_filter.h"
+#include "hash.h"
+
+/* Each key has a fingerprint, taken from the high half of its hash,
+ * and two candidate buckets: one from the low half of its hash, and
+ * one found by subtracting that from a hash of the fingerprint,
+ * modulo the number of buckets, so either bucket can be found from
+ * the other without the key and the filter can have any number of
+ * buckets. A whole
+ * bucket is loaded as one integer and its fingerprints compared at
+ * once, by the same bit tricks as SIMD code but in ordinary
+ * registers.
+ */
+#define MAX_LOAD 0.9
+#define MAX_KICKS 500
+#define FINGERPRINT_MULTIPLIER 0x5bd1e995U
+
+bool _cuckoo_filter_insert(cuckoo_filter *filter, size_t index, uint32_t fingerprint);
+
+/* Private: Gets the number of bytes in a bucket of a filter.
+ *
+ * filter - The filter.
+ *
+ * Returns the number of bytes.
+ */
+static inline size_t _cuckoo_filter_bucket_bytes(const cuckoo_filter *filter) {
+	return CUCKOO_FILTER_BUCKET_SIZE * filter->fingerprint_bits / 8;
+}
+
+/* Private: Loads a bucket of a filter as one integer, with each
+ *          fingerprint in its own lane of fingerprint_bits bits.
+ *
+ * filter - The filter.
+ * index - The index of the bucket.
+ *
+ * Returns the bucket.
+ */
+static inline uint64_t _cuckoo_filter_load(const cuckoo_filter *filter, size_t index) {
+	const unsigned char *bucket = filter->buckets + index * _cuckoo_filter_bucket_bytes(filter);
+
+	if (filter->fingerprint_bits == 8) {
+		uint32_t word = 0;
+		memcpy(&word, bucket, sizeof(word));
+		return word;
+	}
+
+	uint64_t word = 0;
+	memcpy(&word, bucket, sizeof(word));
+	return word;
+}
+
+/* Private: Stores a bucket of a filter loaded by
+ *          _cuckoo_filter_load.
+ *
+ * filter - The filter.
+ * index - The index of the bucket.
+ * word - The bucket.
+ *
+ * Returns nothing.
+ */
+static inline void _cuckoo_filter_store(cuckoo_filter *filter, size_t index, uint64_t word) {
+	unsigned char *bucket = filter->buckets + index * _cuckoo_filter_bucket_bytes(filter);
+
+	if (filter->fingerprint_bits == 8) {
+		uint32_t narrow = (uint32_t)word;
+		memcpy(bucket, &narrow, sizeof(narrow));
+	} else {
+		memcpy(bucket, &word, sizeof(word));
+	}
+}
+
+/* Private: Finds the lanes of a bucket that hold a fingerprint.
+ *
+ * filter - The filter the bucket belongs to.
+ * word - The bucket, from _cuckoo_filter_load.
+ * fingerprint - The fingerprint to look for, or zero to look for
+ *               empty lanes.
+ *
+ * Returns a mask with the high bit of each matching lane set, or
+ * zero if no lane matches.
+ */
+static inline uint64_t _cuckoo_filter_match(const cuckoo_filter *filter, uint64_t word, uint32_t fingerprint) {
+	uint64_t ones = (filter->fingerprint_bits == 8) ? 0x01010101ULL : 0x0001000100010001ULL;
+	uint64_t highs = ones << (filter->fingerprint_bits - 1);
+	uint64_t difference = word ^ (ones * fingerprint);
+
+	return (difference - ones) & ~difference & highs;
+}
+
+/* Private: Gets a key's fingerprint.
+ *
+ * filter - The filter the key is for.
+ * hash - The key's hash.
+ *
+ * Returns the fingerprint, which is never zero.
+ */
+static inline uint32_t _cuckoo_filter_fingerprint(const cuckoo_filter *filter, uint64_t hash) {
+	uint32_t fingerprint = (hash >> 32) & ((1U << filter->fingerprint_bits) - 1);
+
+	return (fingerprint != 0) ? fingerprint : 1;
+}
+
+/* Private: Gets the first bucket a key may be in.
+ *
+ * filter - The filter the key is for.
+ * hash - The key's hash.
+ *
+ * Returns the index of the bucket.
+ */
+static inline size_t _cuckoo_filter_index(const cuckoo_filter *filter, uint64_t hash) {
+	return ((uint64_t)(uint32_t)hash * filter->bucket_count) >> 32;
+}
+
+/* Private: Gets the other bucket a fingerprint may be in.
+ *
+ * filter - The filter the fingerprint is in.
+ * index - One of the fingerprint's buckets.
+ * fingerprint - The fingerprint.
+ *
+ * Returns the fingerprint's other bucket.
+ */
+static inline size_t _cuckoo_filter_alternate(const cuckoo_filter *filter, size_t index, uint32_t fingerprint) {
+	size_t sum = ((uint64_t)(uint32_t)(fingerprint * FINGERPRINT_MULTIPLIER) * filter->bucket_count) >> 32;
+
+	return (sum >= index) ? sum - index : sum + filter->bucket_count - index;
+}
+
+/* Private: Puts a fingerprint in an empty lane of a bucket.
+ *
+ * filter - The filter to add the fingerprint to.
+ * index - The index of the bucket.
+ * fingerprint - The fingerprint.
+ *
+ * Returns true if the bucket had an empty lane; otherwise, false is
+ * returned and the bucket is unchanged.
+ */
+bool _cuckoo_filter_insert(cuckoo_filter *filter, size_t index, uint32_t fingerprint) {
+	uint64_t word = _cuckoo_filter_load(filter, index);
+	uint64_t empty = _cuckoo_filter_match(filter, word, 0);
+	if (empty == 0) {
+		return false;
+	}
+
+	unsigned int shift = __builtin_ctzll(empty) / filter->fingerprint_bits * filter->fingerprint_bits;
+	_cuckoo_filter_store(filter, index, word | ((uint64_t)fingerprint << shift));
+
+	return true;
+}
+
+/* Public: Creates a new cuckoo filter sized to hold a number of
+ *         keys, with fingerprints long enough for a target rate of
+ *         false positives. Fingerprints are 8 or 16 bits long, so
+ *         rates below about 0.012% are not met.
+ *
+ * count - The number of keys the filter should hold.
+ * false_positive_rate - The target rate of false positives, above
+ *                       zero and below one.
+ *
+ * Returns the new filter, or NULL if it couldn't be created.
+ */
+cuckoo_filter *cuckoo_filter_new(size_t count, double false_positive_rate) {
+	if (!(false_positive_rate > 0 && false_positive_rate < 1)) {
+		return NULL;
+	}
+
+	/* A lookup compares its fingerprint with the 2 * 4 in its two
+	 * buckets, so the rate is about 8 / 2^bits.
+	 */
+	unsigned int fingerprint_bits = (2 * CUCKOO_FILTER_BUCKET_SIZE / false_positive_rate <= 256) ? 8 : 16;
+
+	size_t bucket_count = ceil(count / (CUCKOO_FILTER_BUCKET_SIZE * MAX_LOAD));
+	if (bucket_count == 0) {
+		bucket_count = 1;
+	} else if (bucket_count > UINT32_MAX) {
+		return NULL;
+	}
+
+	cuckoo_filter *filter = malloc(sizeof(cuckoo_filter));
+	if (filter == NULL) {
+		return NULL;
+	}
+
+	filter->fingerprint_bits = fingerprint_bits;
+	filter->buckets = calloc(bucket_count, _cuckoo_filter_bucket_bytes(filter));
+	if (filter->buckets == NULL) {
+		free(filter);
+		return NULL;
+	}
+
+	filter->bucket_count = bucket_count;
+	filter->length = 0;
+	filter->has_victim = false;
+	filter->victim_fingerprint = 0;
+	filter->victim_index = 0;
+
+	return filter;
+}
+
+/* Public: Adds a key to a cuckoo filter.
+ *
+ * filter - The filter to add the key to.
+ * key - The key to add.
+ * length - The length of the key in bytes.
+ *
+ * Returns true if the key was added, or false if the filter is
+ * full.
+ */
+bool cuckoo_filter_add(cuckoo_filter *filter, const void *key, size_t length) {
+	return cuckoo_filter_add_hash(filter, hash_fast(key, length, 0));
+}
+
+/* Public: Adds a key to a cuckoo filter by its hash, for callers
+ *         that have already hashed the key. Every key must be
+ *         hashed the same way. If neither of the key's buckets
+ *         has room, fingerprints are moved to their other buckets
+ *         to make some; if that fails, the last fingerprint moved
+ *         out is kept aside, and no more keys can be added.
+ *
+ * filter - The filter to add the key to.
+ * hash - The key's 64-bit hash.
+ *
+ * Returns true if the key was added, or false if the filter is
+ * full.
+ */
+bool cuckoo_filter_add_hash(cuckoo_filter *filter, uint64_t hash) {
+	if (filter->has_victim) {
+		return false;
+	}
+
+	uint32_t fingerprint = _cuckoo_filter_fingerprint(filter, hash);
+	size_t index = _cuckoo_filter_index(filter, hash);
+	size_t alternate = _cuckoo_filter_alternate(filter, index, fingerprint);
+
+	filter->length++;
+
+	if (_cuckoo_filter_insert(filter, index, fingerprint) || _cuckoo_filter_insert(filter, alternate, fingerprint)) {
+		return true;
+	}
+
+	uint32_t lane_mask = (1U << filter->fingerprint_bits) - 1;
+	index = (fingerprint & 1) ? alternate : index;
+
+	unsigned int kick = 0;
+	for (kick = 0; kick < MAX_KICKS; kick++) {
+		unsigned int shift = (kick % CUCKOO_FILTER_BUCKET_SIZE) * filter->fingerprint_bits;
+		uint64_t word = _cuckoo_filter_load(filter, index);
+		uint32_t evicted = (word >> shift) & lane_mask;
+
+		word &= ~((uint64_t)lane_mask << shift);
+		_cuckoo_filter_store(filter, index, word | ((uint64_t)fingerprint << shift));
+
+		fingerprint = evicted;
+		index = _cuckoo_filter_alternate(filter, index, fingerprint);
+
+		if (_cuckoo_filter_insert(filter, index, fingerprint)) {
+			return true;
+		}
+	}
+
+	filter->has_victim = true;
+	filter->victim_fingerprint = fingerprint;
+	filter->victim_index = index;
+
+	return true;
+}
+
+/* Public: Checks whether a key may have been added to a cuckoo
+ *         filter.
+ *
+ * filter - The filter to check.
+ * key - The key to check for.
+ * length - The length of the key in bytes.
+ *
+ * Returns false if the key isn't in the filter, or true if it may
+ * be.
+ */
+bool cuckoo_filter_contains(const cuckoo_filter *filter, const void *key, size_t length) {
+	return cuckoo_filter_contains_hash(filter, hash_fast(key, length, 0));
+}
+
+/* Public: Checks whether a key may have been added to a cuckoo
+ *         filter by its hash.
+ *
+ * filter - The filter to check.
+ * hash - The key's 64-bit hash.
+ *
+ * Returns false if the key isn't in the filter, or true if it may
+ * be.
+ */
+bool cuckoo_filter_contains_hash(const cuckoo_filter *filter, uint64_t hash) {
+	uint32_t fingerprint = _cuckoo_filter_fingerprint(filter, hash);
+	size_t index = _cuckoo_filter_index(filter, hash);
+	size_t alternate = _cuckoo_filter_alternate(filter, index, fingerprint);
+
+	uint64_t matches = _cuckoo_filter_match(filter, _cuckoo_filter_load(filter, index), fingerprint) |
+		_cuckoo_filter_match(filter, _cuckoo_filter_load(filter, alternate), fingerprint);
+
+	return matches != 0 || (filter->has_victim && filter->victim_fingerprint == fingerprint &&
+		(filter->victim_index == index || filter->victim_index == alternate));
+}
+
+/* Public: Removes a key from a cuckoo filter. Only keys that were
+ *         added may be removed; removing any other key may remove
+ *         a key with the same fingerprint and buckets instead.
+ *
+ * filter - The filter to remove the key from.
+ * key - The key to remove.
+ * length - The length of the key in bytes.
+ *
+ * Returns true if the key's fingerprint was found and removed.
+ */
+bool cuckoo_filter_remove(cuckoo_filter *filter, const void *key, size_t length) {
+	return cuckoo_filter_remove_hash(filter, hash_fast(key, length, 0));
+}
+
+/* Public: Removes a key from a cuckoo filter by its hash. Only keys
+ *         that were added may be removed. If a fingerprint was kept
+ *         aside when the filter filled up, it is put back in its
+ *         buckets if there is now room.
+ *
+ * filter - The filter to remove the key from.
+ * hash - The key's 64-bit hash.
+ *
+ * Returns true if the key's fingerprint was found and removed.
+ */
+bool cuckoo_filter_remove_hash(cuckoo_filter *filter, uint64_t hash) {
+	uint32_t fingerprint = _cuckoo_filter_fingerprint(filter, hash);
+	size_t index = _cuckoo_filter_index(filter, hash);
+	size_t alternate = _cuckoo_filter_alternate(filter, index, fingerprint);
+	uint32_t lane_mask = (1U << filter->fingerprint_bits) - 1;
+
+	size_t candidates[2] = { index, alternate };
+	bool removed = false;
+
+	int i = 0;
+	for (i = 0; i < 2 && !removed; i++) {
+		uint64_t word = _cuckoo_filter_load(filter, candidates[i]);
+		uint64_t matches = _cuckoo_filter_match(filter, word, fingerprint);
+		if (matches != 0) {
+			unsigned int shift = __builtin_ctzll(matches) / filter->fingerprint_bits * filter->fingerprint_bits;
+			_cuckoo_filter_store(filter, candidates[i], word & ~((uint64_t)lane_mask << shift));
+			removed = true;
+		}
+	}
+
+	if (!removed && filter->has_victim && filter->victim_fingerprint == fingerprint &&
+		(filter->victim_index == index || filter->victim_index == alternate)) {
+		filter->has_victim = false;
+		removed = true;
+	}
+
+	if (!removed) {
+		return false;
+	}
+
+	filter->length--;
+
+	if (filter->has_victim) {
+		size_t victim_alternate = _cuckoo_filter_alternate(filter, filter->victim_index, filter->victim_fingerprint);
+		if (_cuckoo_filter_insert(filter, filter->victim_index, filter->victim_fingerprint) ||
+			_cuckoo_filter_insert(filter, victim_alternate, filter->victim_fingerprint)) {
+			filter->has_victim = false;
+		}
+	}
+
+	return true;
+}
+
+/* Public: Removes every key from a cuckoo filter, keeping its
+ *         buckets.
+ *
+ * filter - The filter to clear.
+ *
+ * Returns nothing.
+ */
+void cuckoo_filter_clear(cuckoo_filter *filter) {
+	memset(filter->buckets, 0, filter->bucket_count * _cuckoo_filter_bucket_bytes(filter));
+	filter->length = 0;
+	filter->has_victim = false;
+	filter->victim_fingerprint = 0;
+	filter->victim_index = 0;
+}
+
+/* Public: Frees memory associated with a cuckoo filter.
+ *
+ * filter - The filter to free.
+ *
+ * Returns nothing.
+ */
+void cuckoo_filter_free(cuckoo_filter *filter) {
+	free(filter->buckets);
+	free(filter);
+}
@@ -0,0 +1,234 @@
+/*
+ *  hash.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "hash.h"
+
+#define SIP_ROTATE(x, b) (((x) << (b)) | ((x) >> (64 - (b))))
+
+#define SIP_ROUND(v0, v1, v2, v3) \
+	do { \
+		v0 += v1; v1 = SIP_ROTATE(v1, 13); v1 ^= v0; v0 = SIP_ROTATE(v0, 32); \
+		v2 += v3; v3 = SIP_ROTATE(v3, 16); v3 ^= v2; \
+		v0 += v3; v3 = SIP_ROTATE(v3, 21); v3 ^= v0; \
+		v2 += v1; v1 = SIP_ROTATE(v1, 17); v1 ^= v2; v2 = SIP_ROTATE(v2, 32); \
+	} while (0)
+
+static const uint64_t _wy_secret[4] = {
+	0x2d358dccaa6c78a5ULL,
+	0x8bb84b93962eacc9ULL,
+	0x4b33a62ed433d4a3ULL,
+	0x4d5a2da51de1aa47ULL
+};
+
+static uint64_t _random_base = 0;
+static uint64_t _random_counter = 0;
+
+/* Private: Multiplies two 64-bit integers into a 128-bit product.
+ *
+ * a - The first factor; replaced with the low half of the product.
+ * b - The second factor; replaced with the high half of the product.
+ *
+ * Returns nothing.
+ */
+static inline void _wy_multiply(uint64_t *a, uint64_t *b) {
+#if defined(__SIZEOF_INT128__)
+	__uint128_t product = (__uint128_t)*a * *b;
+	*a = (uint64_t)product;
+	*b = (uint64_t)(product >> 64);
+#else
+	uint64_t a_high = *a >> 32, a_low = (uint32_t)*a;
+	uint64_t b_high = *b >> 32, b_low = (uint32_t)*b;
+
+	uint64_t high = a_high * b_high;
+	uint64_t middle_0 = a_high * b_low;
+	uint64_t middle_1 = b_high * a_low;
+	uint64_t low = a_low * b_low;
+
+	uint64_t t = low + (middle_0 << 32);
+	uint64_t carry = t < low;
+	uint64_t result_low = t + (middle_1 << 32);
+	carry += result_low < t;
+
+	*a = result_low;
+	*b = high + (middle_0 >> 32) + (middle_1 >> 32) + carry;
+#endif
+}
+
+/* Private: Folds the 128-bit product of two integers into 64 bits.
+ *
+ * a - The first factor.
+ * b - The second factor.
+ *
+ * Returns the mixed value.
+ */
+static inline uint64_t _wy_mix(uint64_t a, uint64_t b) {
+	_wy_multiply(&a, &b);
+	return a ^ b;
+}
+
+/* Private: Reads little-endian integers of various widths from
+ *          possibly unaligned memory.
+ */
+static inline uint64_t _read_64(const uint8_t *p) {
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	v = __builtin_bswap64(v);
+#endif
+	return v;
+}
+
+static inline uint64_t _read_32(const uint8_t *p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	v = __builtin_bswap32(v);
+#endif
+	return v;
+}
+
+/* Public: Hashes a key with a fast, well-distributed, non-
+ *         cryptographic hash. This is the final version of
+ *         wyhash, which mixes each 16 bytes of input with a single
+ *         64x64-bit multiply.
+ *
+ * key - The bytes to hash.
+ * length - The number of bytes in key.
+ * seed - A value to perturb the hash with.
+ *
+ * Returns the 64-bit hash.
+ */
+uint64_t hash_fast(const void *key, size_t length, uint64_t seed) {
+	const uint8_t *p = key;
+	uint64_t a = 0, b = 0;
+
+	seed ^= _wy_mix(seed ^ _wy_secret[0], _wy_secret[1]);
+
+	if (length <= 16) {
+		if (length >= 4) {
+			a = (_read_32(p) << 32) | _read_32(p + ((length >> 3) << 2));
+			b = (_read_32(p + length - 4) << 32) | _read_32(p + length - 4 - ((length >> 3) << 2));
+		} else if (length > 0) {
+			a = (((uint64_t)p[0]) << 16) | (((uint64_t)p[length >> 1]) << 8) | p[length - 1];
+		}
+	} else {
+		size_t remaining = length;
+		if (remaining >= 48) {
+			uint64_t seed_1 = seed, seed_2 = seed;
+			do {
+				seed = _wy_mix(_read_64(p) ^ _wy_secret[1], _read_64(p + 8) ^ seed);
+				seed_1 = _wy_mix(_read_64(p + 16) ^ _wy_secret[2], _read_64(p + 24) ^ seed_1);
+				seed_2 = _wy_mix(_read_64(p + 32) ^ _wy_secret[3], _read_64(p + 40) ^ seed_2);
+				p += 48;
+				remaining -= 48;
+			} while (remaining >= 48);
+
+			seed ^= seed_1 ^ seed_2;
+		}
+
+		while (remaining > 16) {
+			seed = _wy_mix(_read_64(p) ^ _wy_secret[1], _read_64(p + 8) ^ seed);
+			p += 16;
+			remaining -= 16;
+		}
+
+		a = _read_64(p + remaining - 16);
+		b = _read_64(p + remaining - 8);
+	}
+
+	a ^= _wy_secret[1];
+	b ^= seed;
+	_wy_multiply(&a, &b);
+
+	return _wy_mix(a ^ _wy_secret[0] ^ length, b ^ _wy_secret[1]);
+}
+
+/* Public: Hashes a key with SipHash-1-3, a keyed pseudorandom
+ *         function. As long as the seed is secret, an attacker
+ *         can't choose keys that collide, so tables hashed this
+ *         way hold up against hostile input.
+ *
+ * key - The bytes to hash.
+ * length - The number of bytes in key.
+ * seed - The secret key, which is expanded to SipHash's
+ *        128-bit key.
+ *
+ * Returns the 64-bit hash.
+ */
+uint64_t hash_keyed(const void *key, size_t length, uint64_t seed) {
+	const uint8_t *p = key;
+
+	uint64_t k0 = seed;
+	uint64_t k1 = _wy_mix(seed ^ _wy_secret[2], _wy_secret[3]);
+
+	uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+	uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+	uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+	uint64_t v3 = 0x7465646279746573ULL ^ k1;
+
+	const uint8_t *end = p + (length & ~((size_t)7));
+	for (; p != end; p += 8) {
+		uint64_t m = _read_64(p);
+		v3 ^= m;
+		SIP_ROUND(v0, v1, v2, v3);
+		v0 ^= m;
+	}
+
+	uint64_t last = ((uint64_t)length) << 56;
+	switch (length & 7) {
+		case 7: last |= ((uint64_t)p[6]) << 48;
+		case 6: last |= ((uint64_t)p[5]) << 40;
+		case 5: last |= ((uint64_t)p[4]) << 32;
+		case 4: last |= ((uint64_t)p[3]) << 24;
+		case 3: last |= ((uint64_t)p[2]) << 16;
+		case 2: last |= ((uint64_t)p[1]) << 8;
+		case 1: last |= ((uint64_t)p[0]);
+	}
+
+	v3 ^= last;
+	SIP_ROUND(v0, v1, v2, v3);
+	v0 ^= last;
+
+	v2 ^= 0xff;
+	SIP_ROUND(v0, v1, v2, v3);
+	SIP_ROUND(v0, v1, v2, v3);
+	SIP_ROUND(v0, v1, v2, v3);
+
+	return v0 ^ v1 ^ v2 ^ v3;
+}
+
+/* Public: Generates a random seed for hash_keyed. The first call
+ *         reads the system's random source; each later call
+ *         returns a different seed derived from it.
+ *
+ * Returns the seed.
+ */
+uint64_t hash_random_seed() {
+	uint64_t base = __atomic_load_n(&_random_base, __ATOMIC_ACQUIRE);
+	if (base == 0) {
+		FILE *source = fopen("/dev/urandom", "rb");
+		if (source == NULL || fread(&base, sizeof(base), 1, source) != 1) {
+			base = (uint64_t)time(NULL) ^ (uint64_t)(uintptr_t)&base;
+		}
+
+		if (source != NULL) {
+			fclose(source);
+		}
+
+		base |= 1;
+		__atomic_store_n(&_random_base, base, __ATOMIC_RELEASE);
+	}
+
+	uint64_t count = __atomic_add_fetch(&_random_counter, 1, __ATOMIC_RELAXED);
+
+	return _wy_mix(base ^ _wy_secret[0], count ^ _wy_secret[1]);
+}
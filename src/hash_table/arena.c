@@ -0,0 +1,216 @@
+/*
+ *  arena.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include "hash_table_private.h"
+
+/* Slabs start at MIN_SLAB_SIZE bytes and double in size up to
+ * MAX_SLAB_SIZE, so small tables stay small while large tables
+ * need few slabs. Allocations are rounded up to ALIGNMENT bytes.
+ */
+#define MIN_SLAB_SIZE (64 * 1024)
+#define MAX_SLAB_SIZE (4 * 1024 * 1024)
+#define ALIGNMENT sizeof(void *)
+#define ROUND_UP(size) (((size) + ALIGNMENT - 1) & ~(ALIGNMENT - 1))
+
+/* Whether a slot of a flat, Robin Hood or small table, or an entry
+ * of an ordered table, holds an item
+ */
+#define SLOT_USED(table, index) \
+	(((table)->small || (table)->layout == HASH_TABLE_ORDERED) ? (table)->slots[index].key != NULL : \
+	((table)->control != NULL) ? (table)->control[index] >= 0 : (table)->distances[index] != 0)
+
+/* Private: Allocates memory from a table's slabs, adding a slab if
+ *          the newest one is full. The memory is only freed when
+ *          the whole arena is.
+ *
+ * table - The table to allocate memory for.
+ * size - The number of bytes to allocate.
+ *
+ * Returns the memory, or NULL if it couldn't be allocated.
+ */
+void *_hash_table_arena_alloc(hash_table *table, size_t size) {
+	size = ROUND_UP(size);
+
+	hash_table_slab *slab = table->slabs;
+	if (slab == NULL || slab->size - slab->used < size) {
+		size_t slab_size = MIN_SLAB_SIZE;
+		if (slab != NULL && slab->size < MAX_SLAB_SIZE) {
+			slab_size = slab->size * 2;
+		} else if (slab != NULL) {
+			slab_size = MAX_SLAB_SIZE;
+		}
+
+		if (slab_size < size) {
+			slab_size = size;
+		}
+
+		hash_table_slab *new_slab = malloc(sizeof(hash_table_slab) + slab_size);
+		if (new_slab == NULL) {
+			return NULL;
+		}
+
+		new_slab->size = slab_size;
+		new_slab->used = 0;
+
+		/* An oversized allocation gets a slab to itself, placed
+		 * behind the newest slab so the rest of the newest slab
+		 * can still be used.
+		 */
+		if (slab != NULL && slab_size == size && size > MAX_SLAB_SIZE) {
+			new_slab->next = slab->next;
+			slab->next = new_slab;
+			new_slab->used = size;
+
+			return new_slab->data;
+		}
+
+		new_slab->next = slab;
+		table->slabs = new_slab;
+		slab = new_slab;
+	}
+
+	void *memory = slab->data + slab->used;
+	slab->used += size;
+
+	return memory;
+}
+
+/* Private: Frees every slab of a table's arena.
+ *
+ * table - The table whose arena should be freed.
+ *
+ * Returns nothing.
+ */
+void _hash_table_arena_free(hash_table *table) {
+	hash_table_slab *slab = table->slabs;
+	while (slab != NULL) {
+		hash_table_slab *next = slab->next;
+		free(slab);
+		slab = next;
+	}
+
+	table->slabs = NULL;
+}
+
+/* Private: Empties a table's arena for reuse, keeping only its
+ *          newest slab, which is the largest unless an oversized
+ *          allocation was given a slab of its own.
+ *
+ * table - The table whose arena should be emptied.
+ *
+ * Returns nothing.
+ */
+void _hash_table_arena_reset(hash_table *table) {
+	hash_table_slab *slab = table->slabs;
+	if (slab == NULL) {
+		return;
+	}
+
+	hash_table_slab *old = slab->next;
+	while (old != NULL) {
+		hash_table_slab *next = old->next;
+		free(old);
+		old = next;
+	}
+
+	slab->next = NULL;
+	slab->used = 0;
+}
+
+/* Private: Copies the key of an item into a table's arena, along
+ *          with its value if the table has a value size.
+ *
+ * table - The table the item belongs to.
+ * item - The item whose key should be copied.
+ *
+ * Returns nothing.
+ */
+static inline void _hash_table_arena_copy_key(hash_table *table, hash_table_item *item) {
+	size_t size = _hash_table_key_size(table, item->key_length);
+	char *key = _hash_table_arena_alloc(table, size);
+	memcpy(key, item->key, size);
+	item->key = key;
+
+	if (table->value_size > 0) {
+		item->value = key + _hash_table_value_offset(item->key_length);
+	}
+}
+
+/* Private: Copies the live keys and nodes of a table into one new
+ *          slab sized to hold exactly them, then frees the old
+ *          slabs, giving back the memory of removed items. Chained
+ *          tables must not be in the middle of a resize.
+ *
+ * table - The table whose arena should be compacted.
+ *
+ * Returns true if the arena was compacted; otherwise, false is
+ * returned and the table is unchanged.
+ */
+bool _hash_table_arena_compact(hash_table *table) {
+	_hash_table_epoch_settle(table);
+
+	bool chained = table->layout == HASH_TABLE_CHAINED && !table->small;
+	unsigned int count = table->bucket_count;
+	if (table->small) {
+		count = table->length;
+	} else if (table->layout == HASH_TABLE_ORDERED) {
+		count = table->entry_count;
+	}
+	size_t size = 0;
+
+	unsigned int i = 0;
+	for (i = 0; i < count; i++) {
+		if (chained) {
+			hash_table_node *node = NULL;
+			for (node = table->items[i]; node != NULL; node = node->next) {
+				size += ROUND_UP(sizeof(hash_table_node)) + ROUND_UP(_hash_table_key_size(table, node->item.key_length));
+			}
+		} else if (SLOT_USED(table, i)) {
+			size += ROUND_UP(_hash_table_key_size(table, table->slots[i].key_length));
+		}
+	}
+
+	hash_table_slab *old_slabs = table->slabs;
+	table->slabs = NULL;
+
+	if (size > 0) {
+		hash_table_slab *slab = malloc(sizeof(hash_table_slab) + size);
+		if (slab == NULL) {
+			table->slabs = old_slabs;
+			return false;
+		}
+
+		slab->next = NULL;
+		slab->size = size;
+		slab->used = 0;
+		table->slabs = slab;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (chained) {
+			hash_table_node **link = NULL;
+			for (link = &table->items[i]; *link != NULL; link = &(*link)->next) {
+				hash_table_node *node = _hash_table_arena_alloc(table, sizeof(hash_table_node));
+				*node = **link;
+				_hash_table_arena_copy_key(table, &node->item);
+				*link = node;
+			}
+		} else if (SLOT_USED(table, i)) {
+			_hash_table_arena_copy_key(table, &table->slots[i]);
+		}
+	}
+
+	hash_table_slab *slab = old_slabs;
+	while (slab != NULL) {
+		hash_table_slab *next = slab->next;
+		free(slab);
+		slab = next;
+	}
+
+	return true;
+}
@@ -0,0 +1,857 @@
+/*
+ *  chash_table.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include "chash_table.h"
+
+/* Writers lock one of STRIPE_COUNT stripes, chosen by the low bits
+ * of the key's hash. Bucket arrays never have fewer buckets than
+ * stripes, so each bucket of every array belongs to exactly one
+ * stripe.
+ */
+#define STRIPE_COUNT 64
+#define MAX_LOAD_FACTOR 0.75
+
+/* Writers that find the table growing move MIGRATE_CHUNK buckets to
+ * the larger bucket array before returning.
+ */
+#define MIGRATE_CHUNK 16
+
+/* Garbage is freed each time GARBAGE_BATCH more items have been
+ * retired.
+ */
+#define GARBAGE_BATCH 64
+
+#define CACHE_LINE_SIZE 64
+
+typedef struct chash_node {
+	/* The next node in the bucket, read without locks
+	 */
+	struct chash_node *next;
+
+	void *value;
+	void (*release_function)(void *);
+	uint64_t hash;
+	size_t key_length;
+
+	/* The next node in the table's garbage, the global epoch when
+	 * the node was retired, and whether its value should be
+	 * released when it is freed
+	 */
+	struct chash_node *garbage_next;
+	uint64_t garbage_epoch;
+	bool release_on_free;
+
+	char key[];
+} chash_node;
+
+typedef struct chash_buckets {
+	/* The number of buckets in the array, which is a power of two
+	 */
+	unsigned int count;
+
+	/* While the table is growing, the larger array that buckets
+	 * are being moved to
+	 */
+	struct chash_buckets *next;
+
+	/* The index of the next bucket for a writer to move, and the
+	 * number of buckets that have been moved
+	 */
+	unsigned int migrate_index;
+	unsigned int migrated;
+
+	struct chash_buckets *garbage_next;
+	uint64_t garbage_epoch;
+
+	chash_node *heads[];
+} chash_buckets;
+
+typedef struct chash_stripe {
+	pthread_mutex_t lock;
+
+	/* The number of items in the stripe's buckets
+	 */
+	unsigned long length;
+} __attribute__((aligned(CACHE_LINE_SIZE))) chash_stripe;
+
+/* A thread's record for epoch-based reclamation. While a thread is
+ * reading a table, epoch holds the global epoch it saw, with the low
+ * bit set; otherwise, it is zero. Records are shared by every table
+ * and are reused once their thread exits.
+ */
+typedef struct chash_thread {
+	uint64_t epoch;
+	bool in_use;
+	struct chash_thread *next;
+} __attribute__((aligned(CACHE_LINE_SIZE))) chash_thread;
+
+/* The head stored in a bucket that has been moved to the next array
+ */
+static char _moved_marker;
+#define MOVED ((chash_node *)&_moved_marker)
+
+static uint64_t _global_epoch = 2;
+static chash_thread *_threads = NULL;
+static pthread_once_t _thread_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t _thread_key;
+static __thread chash_thread *_current_thread = NULL;
+
+void _chash_thread_exit(void *record);
+void _chash_thread_key_create();
+chash_thread *_chash_thread();
+chash_thread *_chash_enter();
+void _chash_leave(chash_thread *thread);
+void _chash_try_advance();
+void _chash_collect(chash_table *table);
+void _chash_retire(chash_table *table, chash_node *first, chash_node *last, unsigned int count, bool release);
+void _chash_retire_buckets(chash_table *table, chash_buckets *buckets);
+chash_buckets *_chash_buckets_new(unsigned int count);
+void _chash_free_chains(chash_buckets *buckets);
+bool _chash_migrate_bucket(chash_table *table, chash_buckets *buckets, unsigned int index);
+void _chash_help_resize(chash_table *table);
+chash_node **_chash_locked_bucket(chash_table *table, uint64_t hash, chash_buckets **buckets);
+
+/* Private: Marks a thread's reclamation record as free for reuse
+ *          when the thread exits.
+ *
+ * record - The thread's record.
+ *
+ * Returns nothing.
+ */
+void _chash_thread_exit(void *record) {
+	chash_thread *thread = record;
+
+	__atomic_store_n(&thread->epoch, 0, __ATOMIC_RELEASE);
+	__atomic_store_n(&thread->in_use, false, __ATOMIC_RELEASE);
+}
+
+/* Private: Creates the key used to find out when a thread exits.
+ *
+ * Returns nothing.
+ */
+void _chash_thread_key_create() {
+	pthread_key_create(&_thread_key, &_chash_thread_exit);
+}
+
+/* Private: Gets the calling thread's reclamation record, claiming an
+ *          unused record or adding a new one on first use.
+ *
+ * Returns the record, or NULL if one couldn't be allocated.
+ */
+chash_thread *_chash_thread() {
+	chash_thread *thread = _current_thread;
+	if (thread != NULL) {
+		return thread;
+	}
+
+	pthread_once(&_thread_key_once, &_chash_thread_key_create);
+
+	for (thread = __atomic_load_n(&_threads, __ATOMIC_ACQUIRE); thread != NULL; thread = thread->next) {
+		bool unused = false;
+		if (!__atomic_load_n(&thread->in_use, __ATOMIC_RELAXED) &&
+			__atomic_compare_exchange_n(&thread->in_use, &unused, true, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+			break;
+		}
+	}
+
+	if (thread == NULL) {
+		void *memory = NULL;
+		if (posix_memalign(&memory, CACHE_LINE_SIZE, sizeof(chash_thread)) != 0) {
+			return NULL;
+		}
+
+		thread = memory;
+		thread->epoch = 0;
+		thread->in_use = true;
+		thread->next = __atomic_load_n(&_threads, __ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&_threads, &thread->next, thread, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+		}
+	}
+
+	pthread_setspecific(_thread_key, thread);
+	_current_thread = thread;
+
+	return thread;
+}
+
+/* Private: Starts a read of shared table memory. Nothing retired after
+ *          this call is freed before the matching _chash_leave.
+ *
+ * Returns the calling thread's record, or NULL if it couldn't be
+ * allocated.
+ */
+chash_thread *_chash_enter() {
+	chash_thread *thread = _chash_thread();
+	if (thread == NULL) {
+		return NULL;
+	}
+
+	uint64_t epoch = 0;
+	do {
+		epoch = __atomic_load_n(&_global_epoch, __ATOMIC_SEQ_CST);
+		__atomic_store_n(&thread->epoch, epoch | 1, __ATOMIC_SEQ_CST);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	} while (__atomic_load_n(&_global_epoch, __ATOMIC_SEQ_CST) != epoch);
+
+	return thread;
+}
+
+/* Private: Ends a read started by _chash_enter.
+ *
+ * thread - The record returned by _chash_enter.
+ *
+ * Returns nothing.
+ */
+void _chash_leave(chash_thread *thread) {
+	__atomic_store_n(&thread->epoch, 0, __ATOMIC_RELEASE);
+}
+
+/* Private: Advances the global epoch if every thread that is reading
+ *          has seen the current one.
+ *
+ * Returns nothing.
+ */
+void _chash_try_advance() {
+	uint64_t epoch = __atomic_load_n(&_global_epoch, __ATOMIC_SEQ_CST);
+
+	chash_thread *thread = __atomic_load_n(&_threads, __ATOMIC_ACQUIRE);
+	for (; thread != NULL; thread = thread->next) {
+		uint64_t thread_epoch = __atomic_load_n(&thread->epoch, __ATOMIC_SEQ_CST);
+		if ((thread_epoch & 1) != 0 && (thread_epoch & ~((uint64_t)1)) != epoch) {
+			return;
+		}
+	}
+
+	__atomic_compare_exchange_n(&_global_epoch, &epoch, epoch + 2, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+/* Private: Frees the garbage of a table that no thread can still be
+ *          reading, which is anything retired at least two epochs
+ *          before the current one. Must be called with the garbage
+ *          lock held.
+ *
+ * table - The table to collect garbage from.
+ *
+ * Returns nothing.
+ */
+void _chash_collect(chash_table *table) {
+	_chash_try_advance();
+
+	uint64_t epoch = __atomic_load_n(&_global_epoch, __ATOMIC_SEQ_CST);
+
+	chash_node **node_link = &table->garbage_nodes;
+	while (*node_link != NULL && (*node_link)->garbage_epoch + 4 > epoch) {
+		node_link = &(*node_link)->garbage_next;
+	}
+
+	chash_node *node = *node_link;
+	*node_link = NULL;
+
+	while (node != NULL) {
+		chash_node *next = node->garbage_next;
+		if (node->release_on_free && node->release_function != NULL) {
+			node->release_function(node->value);
+		}
+
+		free(node);
+		table->garbage_count--;
+		node = next;
+	}
+
+	chash_buckets **buckets_link = &table->garbage_buckets;
+	while (*buckets_link != NULL && (*buckets_link)->garbage_epoch + 4 > epoch) {
+		buckets_link = &(*buckets_link)->garbage_next;
+	}
+
+	chash_buckets *buckets = *buckets_link;
+	*buckets_link = NULL;
+
+	while (buckets != NULL) {
+		chash_buckets *next = buckets->garbage_next;
+		free(buckets);
+		table->garbage_count--;
+		buckets = next;
+	}
+}
+
+/* Private: Retires a chain of nodes that have been unlinked from a
+ *          table, to be freed once no reader can still see them.
+ *
+ * table - The table the nodes belonged to.
+ * first - The first node of the chain, linked by garbage_next.
+ * last - The last node of the chain.
+ * count - The number of nodes in the chain.
+ * release - Whether to release the nodes' values when they are freed.
+ *
+ * Returns nothing.
+ */
+void _chash_retire(chash_table *table, chash_node *first, chash_node *last, unsigned int count, bool release) {
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	pthread_mutex_lock(&table->garbage_lock);
+
+	uint64_t epoch = __atomic_load_n(&_global_epoch, __ATOMIC_SEQ_CST);
+	chash_node *node = first;
+	while (true) {
+		node->garbage_epoch = epoch;
+		node->release_on_free = release;
+		if (node == last) {
+			break;
+		}
+
+		node = node->garbage_next;
+	}
+
+	last->garbage_next = table->garbage_nodes;
+	table->garbage_nodes = first;
+
+	unsigned int old_count = table->garbage_count;
+	table->garbage_count += count;
+	if (old_count / GARBAGE_BATCH != table->garbage_count / GARBAGE_BATCH) {
+		_chash_collect(table);
+	}
+
+	pthread_mutex_unlock(&table->garbage_lock);
+}
+
+/* Private: Retires a bucket array that has been replaced.
+ *
+ * table - The table the array belonged to.
+ * buckets - The array to retire.
+ *
+ * Returns nothing.
+ */
+void _chash_retire_buckets(chash_table *table, chash_buckets *buckets) {
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	pthread_mutex_lock(&table->garbage_lock);
+
+	buckets->garbage_epoch = __atomic_load_n(&_global_epoch, __ATOMIC_SEQ_CST);
+	buckets->garbage_next = table->garbage_buckets;
+	table->garbage_buckets = buckets;
+	table->garbage_count++;
+
+	pthread_mutex_unlock(&table->garbage_lock);
+}
+
+/* Private: Allocates an empty bucket array.
+ *
+ * count - The number of buckets, which must be a power of two no
+ *         smaller than STRIPE_COUNT.
+ *
+ * Returns the array, or NULL if it couldn't be allocated.
+ */
+chash_buckets *_chash_buckets_new(unsigned int count) {
+	chash_buckets *buckets = calloc(1, sizeof(chash_buckets) + count * sizeof(chash_node *));
+	if (buckets == NULL) {
+		return NULL;
+	}
+
+	buckets->count = count;
+
+	return buckets;
+}
+
+/* Private: Frees and releases every node in a bucket array and the
+ *          array it is growing into, if any. No other thread may be
+ *          using the table.
+ *
+ * buckets - The array to clear.
+ *
+ * Returns nothing.
+ */
+void _chash_free_chains(chash_buckets *buckets) {
+	unsigned int i = 0;
+	for (i = 0; i < buckets->count; i++) {
+		chash_node *node = buckets->heads[i];
+		if (node == MOVED) {
+			continue;
+		}
+
+		while (node != NULL) {
+			chash_node *next = node->next;
+			if (node->release_function != NULL) {
+				node->release_function(node->value);
+			}
+
+			free(node);
+			node = next;
+		}
+	}
+
+	if (buckets->next != NULL) {
+		_chash_free_chains(buckets->next);
+		free(buckets->next);
+	}
+}
+
+/* Private: Moves one bucket of a growing table to the next bucket
+ *          array. Readers may still be walking the bucket's chain,
+ *          so its nodes are copied rather than relinked, and the old
+ *          nodes are retired. The thread that moves the last bucket
+ *          makes the next array current.
+ *
+ * table - The table that is growing.
+ * buckets - The array the bucket is in.
+ * index - The index of the bucket.
+ *
+ * Returns true if the bucket has been moved, or false if it couldn't
+ * be copied.
+ */
+bool _chash_migrate_bucket(chash_table *table, chash_buckets *buckets, unsigned int index) {
+	chash_buckets *next = __atomic_load_n(&buckets->next, __ATOMIC_ACQUIRE);
+	chash_stripe *stripe = &table->stripes[index & (table->stripe_count - 1)];
+
+	pthread_mutex_lock(&stripe->lock);
+
+	chash_node *first = buckets->heads[index];
+	if (first == MOVED) {
+		pthread_mutex_unlock(&stripe->lock);
+		return true;
+	}
+
+	chash_node *low = NULL, *high = NULL, *last = NULL;
+	unsigned int count = 0;
+
+	chash_node *node = NULL;
+	for (node = first; node != NULL; node = node->next) {
+		size_t size = sizeof(chash_node) + node->key_length + 1;
+
+		chash_node *copy = malloc(size);
+		if (copy == NULL) {
+			while (low != NULL) {
+				chash_node *following = low->next;
+				free(low);
+				low = following;
+			}
+
+			while (high != NULL) {
+				chash_node *following = high->next;
+				free(high);
+				high = following;
+			}
+
+			pthread_mutex_unlock(&stripe->lock);
+			return false;
+		}
+
+		memcpy(copy, node, size);
+
+		if ((node->hash & buckets->count) == 0) {
+			copy->next = low;
+			low = copy;
+		} else {
+			copy->next = high;
+			high = copy;
+		}
+
+		node->garbage_next = node->next;
+		last = node;
+		count++;
+	}
+
+	__atomic_store_n(&next->heads[index], low, __ATOMIC_RELEASE);
+	__atomic_store_n(&next->heads[index + buckets->count], high, __ATOMIC_RELEASE);
+	__atomic_store_n(&buckets->heads[index], MOVED, __ATOMIC_RELEASE);
+
+	pthread_mutex_unlock(&stripe->lock);
+
+	if (first != NULL) {
+		_chash_retire(table, first, last, count, false);
+	}
+
+	if (__atomic_add_fetch(&buckets->migrated, 1, __ATOMIC_ACQ_REL) == buckets->count) {
+		__atomic_store_n(&table->buckets, next, __ATOMIC_RELEASE);
+		_chash_retire_buckets(table, buckets);
+	}
+
+	return true;
+}
+
+/* Private: Moves a chunk of buckets of a growing table to the next
+ *          bucket array. If a bucket can't be moved, the chunk is
+ *          handed back so that a later writer retries it.
+ *
+ * table - The table that may be growing.
+ *
+ * Returns nothing.
+ */
+void _chash_help_resize(chash_table *table) {
+	chash_thread *thread = _chash_enter();
+	if (thread == NULL) {
+		return;
+	}
+
+	chash_buckets *buckets = __atomic_load_n(&table->buckets, __ATOMIC_ACQUIRE);
+	if (__atomic_load_n(&buckets->next, __ATOMIC_ACQUIRE) != NULL &&
+		__atomic_load_n(&buckets->migrate_index, __ATOMIC_RELAXED) < buckets->count) {
+		unsigned int start = __atomic_fetch_add(&buckets->migrate_index, MIGRATE_CHUNK, __ATOMIC_ACQ_REL);
+
+		unsigned int i = 0;
+		for (i = start; i < start + MIGRATE_CHUNK && i < buckets->count; i++) {
+			if (!_chash_migrate_bucket(table, buckets, i)) {
+				unsigned int index = __atomic_load_n(&buckets->migrate_index, __ATOMIC_RELAXED);
+				while (index > i && !__atomic_compare_exchange_n(&buckets->migrate_index, &index, i, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+				}
+
+				break;
+			}
+		}
+	}
+
+	_chash_leave(thread);
+}
+
+/* Private: Finds the bucket a key belongs in, following moved
+ *          buckets into the next array. The caller must hold the
+ *          key's stripe lock, so the bucket can't move until the
+ *          lock is released.
+ *
+ * table - The table to search.
+ * hash - The key's hash.
+ * buckets - Set to the array the bucket is in.
+ *
+ * Returns a pointer to the head of the bucket.
+ */
+chash_node **_chash_locked_bucket(chash_table *table, uint64_t hash, chash_buckets **buckets) {
+	chash_buckets *current = __atomic_load_n(&table->buckets, __ATOMIC_ACQUIRE);
+	while (true) {
+		chash_node **head = &current->heads[hash & (current->count - 1)];
+		if (__atomic_load_n(head, __ATOMIC_ACQUIRE) != MOVED) {
+			*buckets = current;
+			return head;
+		}
+
+		current = __atomic_load_n(&current->next, __ATOMIC_ACQUIRE);
+	}
+}
+
+/* Public: Creates a new concurrent hash table, which may be read and
+ *         written by any number of threads at once.
+ *
+ * Returns the new hash table, or NULL if it couldn't be created.
+ */
+chash_table *chash_table_new() {
+	return chash_table_new_with_capacity(0);
+}
+
+/* Public: Creates a new concurrent hash table sized to hold a number
+ *         of items without resizing.
+ *
+ * capacity - The number of items the table should hold.
+ *
+ * Returns the new hash table, or NULL if it couldn't be created.
+ */
+chash_table *chash_table_new_with_capacity(unsigned int capacity) {
+	chash_table *table = malloc(sizeof(chash_table));
+	if (table == NULL) {
+		return NULL;
+	}
+
+	unsigned int count = STRIPE_COUNT;
+	while (((double)capacity) / ((double)count) >= MAX_LOAD_FACTOR) {
+		count *= 2;
+	}
+
+	table->buckets = _chash_buckets_new(count);
+	if (table->buckets == NULL) {
+		free(table);
+		return NULL;
+	}
+
+	void *stripes = NULL;
+	if (posix_memalign(&stripes, CACHE_LINE_SIZE, STRIPE_COUNT * sizeof(chash_stripe)) != 0) {
+		free(table->buckets);
+		free(table);
+		return NULL;
+	}
+
+	table->stripes = stripes;
+	table->stripe_count = STRIPE_COUNT;
+
+	unsigned int i = 0;
+	for (i = 0; i < STRIPE_COUNT; i++) {
+		pthread_mutex_init(&table->stripes[i].lock, NULL);
+		table->stripes[i].length = 0;
+	}
+
+	table->hash_function = &hash_fast;
+	table->seed = 0;
+	table->garbage_nodes = NULL;
+	table->garbage_buckets = NULL;
+	table->garbage_count = 0;
+	pthread_mutex_init(&table->garbage_lock, NULL);
+
+	return table;
+}
+
+/* Public: Sets the value of a key in a concurrent hash table,
+ *         starting to grow the table if it is too full.
+ *
+ * table - The table to set the value in.
+ * elem - The element to set as the value of key.
+ * key - The key to set the value of.
+ * release_function - A function to call when elem is removed
+ *                    from the table, or NULL to call no function.
+ *
+ * Returns true if the element was added successfully;
+ * otherwise, false is returned and the table is unchanged.
+ */
+bool chash_table_set(chash_table *table, void *elem, char *key, void (*release_function)(void *)) {
+	return chash_table_set_bytes(table, elem, key, strlen(key), release_function);
+}
+
+/* Public: Sets the value of a key of arbitrary bytes in a concurrent
+ *         hash table, starting to grow the table if it is too full.
+ *         Writers to keys in different stripes don't block each
+ *         other, and writers never block readers.
+ *
+ * table - The table to set the value in.
+ * elem - The element to set as the value of key.
+ * key - The key to set the value of.
+ * length - The length of the key in bytes.
+ * release_function - A function to call when elem is removed
+ *                    from the table, or NULL to call no function.
+ *
+ * Returns true if the element was added successfully;
+ * otherwise, false is returned and the table is unchanged.
+ */
+bool chash_table_set_bytes(chash_table *table, void *elem, const void *key, size_t length, void (*release_function)(void *)) {
+	uint64_t hash = table->hash_function(key, length, table->seed);
+	chash_stripe *stripe = &table->stripes[hash & (table->stripe_count - 1)];
+
+	chash_thread *thread = _chash_enter();
+	if (thread == NULL) {
+		return false;
+	}
+
+	pthread_mutex_lock(&stripe->lock);
+
+	chash_buckets *buckets = NULL;
+	chash_node **head = _chash_locked_bucket(table, hash, &buckets);
+
+	chash_node *node = NULL;
+	for (node = *head; node != NULL; node = node->next) {
+		if (node->hash == hash && node->key_length == length && memcmp(key, node->key, length) == 0) {
+			__atomic_store_n(&node->value, elem, __ATOMIC_RELEASE);
+
+			pthread_mutex_unlock(&stripe->lock);
+			_chash_leave(thread);
+
+			return true;
+		}
+	}
+
+	node = malloc(sizeof(chash_node) + length + 1);
+	if (node == NULL) {
+		pthread_mutex_unlock(&stripe->lock);
+		_chash_leave(thread);
+
+		return false;
+	}
+
+	memcpy(node->key, key, length);
+	node->key[length] = '\0';
+	node->key_length = length;
+	node->hash = hash;
+	node->value = elem;
+	node->release_function = release_function;
+	node->next = *head;
+
+	__atomic_store_n(head, node, __ATOMIC_RELEASE);
+
+	unsigned long stripe_length = stripe->length + 1;
+	__atomic_store_n(&stripe->length, stripe_length, __ATOMIC_RELAXED);
+
+	if (buckets == __atomic_load_n(&table->buckets, __ATOMIC_ACQUIRE) &&
+		__atomic_load_n(&buckets->next, __ATOMIC_ACQUIRE) == NULL &&
+		((double)stripe_length) * table->stripe_count / buckets->count >= MAX_LOAD_FACTOR) {
+		chash_buckets *next = _chash_buckets_new(buckets->count * 2);
+		chash_buckets *expected = NULL;
+		if (next != NULL && !__atomic_compare_exchange_n(&buckets->next, &expected, next, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+			free(next);
+		}
+	}
+
+	pthread_mutex_unlock(&stripe->lock);
+	_chash_leave(thread);
+
+	_chash_help_resize(table);
+
+	return true;
+}
+
+/* Public: Gets the value of a key in a concurrent hash table.
+ *
+ * table - The table to get the value from.
+ * key - The key to get the value of.
+ *
+ * Returns the value of key in table, or NULL if
+ * the element couldn't be found.
+ */
+void *chash_table_get(chash_table *table, char *key) {
+	return chash_table_get_bytes(table, key, strlen(key));
+}
+
+/* Public: Gets the value of a key of arbitrary bytes in a concurrent
+ *         hash table. Reads take no locks and never wait for writers.
+ *
+ * table - The table to get the value from.
+ * key - The key to get the value of.
+ * length - The length of the key in bytes.
+ *
+ * Returns the value of key in table, or NULL if
+ * the element couldn't be found.
+ */
+void *chash_table_get_bytes(chash_table *table, const void *key, size_t length) {
+	uint64_t hash = table->hash_function(key, length, table->seed);
+
+	chash_thread *thread = _chash_enter();
+	if (thread == NULL) {
+		return NULL;
+	}
+
+	chash_buckets *buckets = __atomic_load_n(&table->buckets, __ATOMIC_ACQUIRE);
+	chash_node *node = NULL;
+	while ((node = __atomic_load_n(&buckets->heads[hash & (buckets->count - 1)], __ATOMIC_ACQUIRE)) == MOVED) {
+		buckets = __atomic_load_n(&buckets->next, __ATOMIC_ACQUIRE);
+	}
+
+	void *value = NULL;
+	for (; node != NULL; node = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE)) {
+		if (node->hash == hash && node->key_length == length && memcmp(key, node->key, length) == 0) {
+			value = __atomic_load_n(&node->value, __ATOMIC_ACQUIRE);
+			break;
+		}
+	}
+
+	_chash_leave(thread);
+
+	return value;
+}
+
+/* Public: Removes a key from a concurrent hash table.
+ *
+ * table - The table to remove the key from.
+ * key - The key to remove.
+ *
+ * Returns true if the key was found and removed.
+ */
+bool chash_table_remove(chash_table *table, char *key) {
+	return chash_table_remove_bytes(table, key, strlen(key));
+}
+
+/* Public: Removes a key of arbitrary bytes from a concurrent hash
+ *         table. The key's release function is called once no
+ *         lookup that started before the removal is still running,
+ *         which may be during a later call by any thread. Callers
+ *         that keep values after a lookup returns must make sure
+ *         they outlive that use.
+ *
+ * table - The table to remove the key from.
+ * key - The key to remove.
+ * length - The length of the key in bytes.
+ *
+ * Returns true if the key was found and removed.
+ */
+bool chash_table_remove_bytes(chash_table *table, const void *key, size_t length) {
+	uint64_t hash = table->hash_function(key, length, table->seed);
+	chash_stripe *stripe = &table->stripes[hash & (table->stripe_count - 1)];
+
+	chash_thread *thread = _chash_enter();
+	if (thread == NULL) {
+		return false;
+	}
+
+	pthread_mutex_lock(&stripe->lock);
+
+	chash_buckets *buckets = NULL;
+	chash_node **link = _chash_locked_bucket(table, hash, &buckets);
+
+	chash_node *node = NULL;
+	for (node = *link; node != NULL; node = node->next) {
+		if (node->hash == hash && node->key_length == length && memcmp(key, node->key, length) == 0) {
+			break;
+		}
+
+		link = &node->next;
+	}
+
+	if (node != NULL) {
+		__atomic_store_n(link, node->next, __ATOMIC_RELEASE);
+		__atomic_store_n(&stripe->length, stripe->length - 1, __ATOMIC_RELAXED);
+	}
+
+	pthread_mutex_unlock(&stripe->lock);
+
+	if (node != NULL) {
+		_chash_retire(table, node, node, 1, true);
+	}
+
+	_chash_leave(thread);
+
+	return node != NULL;
+}
+
+/* Public: Gets the number of items in a concurrent hash table. If
+ *         other threads are writing, the result may be out of date
+ *         by the time it is returned.
+ *
+ * table - The table to measure.
+ *
+ * Returns the number of items.
+ */
+unsigned long chash_table_length(chash_table *table) {
+	unsigned long length = 0;
+
+	unsigned int i = 0;
+	for (i = 0; i < table->stripe_count; i++) {
+		length += __atomic_load_n(&table->stripes[i].length, __ATOMIC_RELAXED);
+	}
+
+	return length;
+}
+
+/* Public: Clears and frees memory associated with a concurrent hash
+ *         table. No other thread may be using the table.
+ *
+ * table - The table to free.
+ *
+ * Returns nothing.
+ */
+void chash_table_free(chash_table *table) {
+	_chash_free_chains(table->buckets);
+	free(table->buckets);
+
+	chash_node *node = table->garbage_nodes;
+	while (node != NULL) {
+		chash_node *next = node->garbage_next;
+		if (node->release_on_free && node->release_function != NULL) {
+			node->release_function(node->value);
+		}
+
+		free(node);
+		node = next;
+	}
+
+	chash_buckets *buckets = table->garbage_buckets;
+	while (buckets != NULL) {
+		chash_buckets *next = buckets->garbage_next;
+		free(buckets);
+		buckets = next;
+	}
+
+	unsigned int i = 0;
+	for (i = 0; i < table->stripe_count; i++) {
+		pthread_mutex_destroy(&table->stripes[i].lock);
+	}
+
+	pthread_mutex_destroy(&table->garbage_lock);
+	free(table->stripes);
+	free(table);
+}
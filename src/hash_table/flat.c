@@ -0,0 +1,618 @@
+/*
+ *  flat.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include "hash_table_private.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+/* Slots are probed in groups of GROUP_WIDTH, each group being
+ * one 16-byte load of control bytes. A control byte is either
+ * CONTROL_EMPTY, CONTROL_DELETED for a slot whose item has been
+ * removed, or, for a full slot, the low seven bits of the hash of
+ * the slot's key. Only full slots have the high bit clear.
+ * Probes stop at a group with an empty slot, but not at one with
+ * only deleted slots, since the key may have been placed past
+ * the group while the deleted slot was full.
+ */
+#define GROUP_WIDTH 16
+#define CONTROL_EMPTY ((signed char)-128)
+#define CONTROL_DELETED ((signed char)-2)
+#define MAX_LOAD_NUMERATOR 7
+#define MAX_LOAD_DENOMINATOR 8
+
+/* A bit mask with one bit set for each matching slot in a group.
+ * The NEON comparison is narrowed to four bits per slot rather
+ * than one, so lane numbers are recovered with a shift.
+ */
+typedef uint64_t control_mask;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MASK_LANE_SHIFT 2
+#else
+#define MASK_LANE_SHIFT 0
+#endif
+
+#if (1 << HASH_TABLE_EPOCH_SHIFT) % GROUP_WIDTH != 0
+#error "_hash_table_flat_group resets whole groups"
+#endif
+
+hash_table_item *_hash_table_flat_find(hash_table *table, const void *key, size_t length, uint64_t hash);
+size_t _hash_table_flat_find_free(hash_table *table, uint64_t hash);
+
+/* Private: Finds the slots in a group whose control bytes are
+ *          equal to a value.
+ *
+ * control - The control bytes of the group.
+ * value - The control byte to look for.
+ *
+ * Returns a mask of the matching slots.
+ */
+static inline control_mask _group_match(const signed char *control, signed char value) {
+#if defined(__SSE2__)
+	__m128i group = _mm_loadu_si128((const __m128i *)control);
+	return (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(value)));
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	uint8x16_t equal = vceqq_s8(vld1q_s8(control), vdupq_n_s8(value));
+	uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(equal), 4);
+	return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ULL;
+#else
+	control_mask mask = 0;
+
+	int i = 0;
+	for (i = 0; i < GROUP_WIDTH; i++) {
+		if (control[i] == value) {
+			mask |= ((control_mask)1) << i;
+		}
+	}
+
+	return mask;
+#endif
+}
+
+/* Private: Finds the slots in a group that are empty or deleted.
+ *
+ * control - The control bytes of the group.
+ *
+ * Returns a mask of the free slots.
+ */
+static inline control_mask _group_match_free(const signed char *control) {
+#if defined(__SSE2__)
+	return (uint16_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)control));
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	uint8x16_t negative = vcltq_s8(vld1q_s8(control), vdupq_n_s8(0));
+	uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(negative), 4);
+	return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ULL;
+#else
+	control_mask mask = 0;
+
+	int i = 0;
+	for (i = 0; i < GROUP_WIDTH; i++) {
+		if (control[i] < 0) {
+			mask |= ((control_mask)1) << i;
+		}
+	}
+
+	return mask;
+#endif
+}
+
+/* Private: Gets the control bytes of a group of a flat table,
+ *          first resetting them if the table has been cleared since
+ *          the group was last used.
+ *
+ * table - The table to read.
+ * group - The index of the group.
+ *
+ * Returns the group's control bytes.
+ */
+static inline signed char *_hash_table_flat_group(hash_table *table, size_t group) {
+	_hash_table_epoch_touch(table, group * GROUP_WIDTH);
+
+	return table->control + group * GROUP_WIDTH;
+}
+
+/* Private: Gets the index within its group of the first slot in
+ *          a non-empty mask.
+ *
+ * mask - The mask to read.
+ *
+ * Returns the index of the slot.
+ */
+static inline unsigned int _group_mask_lane(control_mask mask) {
+	return __builtin_ctzll(mask) >> MASK_LANE_SHIFT;
+}
+
+/* Private: Finds the slot holding a key in a flat table.
+ *
+ * table - The table to search.
+ * key - The key to look for.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ *
+ * Returns the key's item, or NULL if it isn't in the table.
+ */
+hash_table_item *_hash_table_flat_find(hash_table *table, const void *key, size_t length, uint64_t hash) {
+	size_t group_mask = table->bucket_count / GROUP_WIDTH - 1;
+	size_t group = (hash >> 7) & group_mask;
+	signed char tag = hash & 0x7f;
+
+	HASH_TABLE_COUNT(table, searches, 1);
+
+	size_t step = 0;
+	while (true) {
+		signed char *control = _hash_table_flat_group(table, group);
+
+		control_mask matches = _group_match(control, tag);
+		while (matches != 0) {
+			hash_table_item *item = &table->slots[group * GROUP_WIDTH + _group_mask_lane(matches)];
+			HASH_TABLE_COUNT(table, comparisons, 1);
+			if (_hash_table_item_matches(item, key, length, hash)) {
+				return item;
+			}
+
+			matches &= matches - 1;
+		}
+
+		if (_group_match(control, CONTROL_EMPTY) != 0 || step == group_mask) {
+			return NULL;
+		}
+
+		step++;
+		group = (group + step) & group_mask;
+	}
+}
+
+/* Private: Finds the first empty or deleted slot along the probe
+ *          sequence of a hash. The table must have at least one
+ *          free slot.
+ *
+ * table - The table to search.
+ * hash - The hash to find a slot for.
+ *
+ * Returns the index of the free slot.
+ */
+size_t _hash_table_flat_find_free(hash_table *table, uint64_t hash) {
+	size_t group_mask = table->bucket_count / GROUP_WIDTH - 1;
+	size_t group = (hash >> 7) & group_mask;
+
+	size_t step = 0;
+	while (true) {
+		control_mask free_slots = _group_match_free(_hash_table_flat_group(table, group));
+		if (free_slots != 0) {
+			return group * GROUP_WIDTH + _group_mask_lane(free_slots);
+		}
+
+		step++;
+		group = (group + step) & group_mask;
+	}
+}
+
+/* Private: Gets the number of slots a flat table needs to hold a
+ *          number of items without growing.
+ *
+ * capacity - The number of items the table should hold.
+ *
+ * Returns the number of slots, which is a power of two number
+ * of groups.
+ */
+unsigned int _hash_table_flat_size_for_capacity(unsigned int capacity) {
+	unsigned int slot_count = GROUP_WIDTH;
+	while (((uint64_t)capacity) * MAX_LOAD_DENOMINATOR > ((uint64_t)slot_count) * MAX_LOAD_NUMERATOR) {
+		slot_count *= 2;
+	}
+
+	return slot_count;
+}
+
+/* Private: Allocates empty storage for a flat table.
+ *
+ * table - The table to initialize.
+ * size - The minimum number of slots to allocate, which is
+ *        rounded up to a power of two number of groups.
+ *
+ * Returns true if the storage could be allocated; otherwise,
+ * false is returned and the table is unchanged.
+ */
+bool _hash_table_flat_init(hash_table *table, unsigned int size) {
+	unsigned int slot_count = GROUP_WIDTH;
+	while (slot_count < size) {
+		slot_count *= 2;
+	}
+
+	signed char *control = malloc(slot_count * sizeof(signed char));
+	if (control == NULL) {
+		return false;
+	}
+
+	hash_table_item *slots = malloc(slot_count * sizeof(hash_table_item));
+	if (slots == NULL) {
+		free(control);
+		return false;
+	}
+
+	memset(control, CONTROL_EMPTY, slot_count * sizeof(signed char));
+
+	table->control = control;
+	table->slots = slots;
+	table->bucket_count = slot_count;
+	table->occupied_buckets = 0;
+
+	return true;
+}
+
+/* Private: Moves every item of a flat table into new storage,
+ *          dropping any deleted slots. Keys are not compared,
+ *          since they are known to be unique.
+ *
+ * table - The table to resize.
+ * size - The minimum number of slots in the new storage.
+ *
+ * Returns true if the resizing succeeded; otherwise, false is
+ * returned and the table is unchanged.
+ */
+bool _hash_table_flat_resize(hash_table *table, unsigned int size) {
+	HASH_TABLE_RESIZE_START();
+	_hash_table_epoch_settle(table);
+
+	signed char *old_control = table->control;
+	hash_table_item *old_slots = table->slots;
+	unsigned int old_count = table->bucket_count;
+
+	if (!_hash_table_flat_init(table, size)) {
+		return false;
+	}
+
+	unsigned int i = 0;
+	for (i = 0; i < old_count; i++) {
+		if (old_control[i] < 0) {
+			continue;
+		}
+
+		uint64_t hash = old_slots[i].hash;
+		size_t index = _hash_table_flat_find_free(table, hash);
+
+		table->control[index] = hash & 0x7f;
+		table->slots[index] = old_slots[i];
+		table->occupied_buckets++;
+	}
+
+	free(old_control);
+	free(old_slots);
+
+	HASH_TABLE_RESIZE_END(table);
+
+	return true;
+}
+
+/* Private: Finds the item of a key in a flat table, adding it
+ *          with a NULL value if it isn't there and doubling the
+ *          table if it would pass its maximum load factor.
+ *
+ * table - The table to find the key in.
+ * key - The key to find.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ * inserted - Set to whether the key was added.
+ *
+ * Returns the key's item, or NULL if it couldn't be added, in
+ * which case the table is unchanged.
+ */
+hash_table_item *_hash_table_flat_insert(hash_table *table, const void *key, size_t length, uint64_t hash, bool *inserted) {
+	*inserted = false;
+
+	hash_table_item *item = _hash_table_flat_find(table, key, length, hash);
+	if (item != NULL) {
+		return item;
+	}
+
+	if ((table->occupied_buckets + 1) * MAX_LOAD_DENOMINATOR > table->bucket_count * MAX_LOAD_NUMERATOR) {
+		/* If the table is full of deleted slots and would be at
+		 * most half its maximum load without them, dropping them
+		 * makes enough room without growing.
+		 */
+		unsigned int size = table->bucket_count * 2;
+		if ((table->length + 1) * MAX_LOAD_DENOMINATOR * 2 <= table->bucket_count * MAX_LOAD_NUMERATOR) {
+			size = table->bucket_count;
+		}
+
+		if (!_hash_table_flat_resize(table, size)) {
+			return NULL;
+		}
+	}
+
+	size_t index = _hash_table_flat_find_free(table, hash);
+	if (!_hash_table_item_init(table, &table->slots[index], NULL, key, length, hash, NULL)) {
+		return NULL;
+	}
+
+	if (table->control[index] == CONTROL_EMPTY) {
+		table->occupied_buckets++;
+	}
+
+	table->control[index] = hash & 0x7f;
+	table->length++;
+	*inserted = true;
+
+	return &table->slots[index];
+}
+
+/* Private: Gets the value of a key in a flat table.
+ *
+ * table - The table to get the value from.
+ * key - The key to get the value of.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ *
+ * Returns the value of key in table, or NULL if
+ * the element couldn't be found.
+ */
+void *_hash_table_flat_get(hash_table *table, const void *key, size_t length, uint64_t hash) {
+	hash_table_item *item = _hash_table_flat_find(table, key, length, hash);
+	if (item == NULL) {
+		return NULL;
+	}
+
+	return item->value;
+}
+
+/* Private: Removes a key from a flat table, marking its slot as
+ *          deleted. The slot can be reused by a later insertion,
+ *          and is dropped when the table is next resized.
+ *
+ * table - The table to remove the key from.
+ * key - The key to remove.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ *
+ * Returns true if the key was found and removed.
+ */
+bool _hash_table_flat_remove(hash_table *table, const void *key, size_t length, uint64_t hash) {
+	hash_table_item *item = _hash_table_flat_find(table, key, length, hash);
+	if (item == NULL) {
+		return false;
+	}
+
+	_hash_table_item_release(table, item);
+
+	table->control[item - table->slots] = CONTROL_DELETED;
+	table->length--;
+
+	return true;
+}
+
+/* Private: Measures how many groups are probed to find each item
+ *          of a flat table.
+ *
+ * table - The table to measure.
+ * max - Set to the number of groups probed to find the furthest
+ *       item.
+ * total - Set to the total number of groups probed to find every
+ *         item.
+ * histogram - The number of items found with each number of probes,
+ *             which is added to, or NULL.
+ *
+ * Returns nothing.
+ */
+void _hash_table_flat_probe_lengths(hash_table *table, unsigned int *max, uint64_t *total, unsigned long *histogram) {
+	size_t group_mask = table->bucket_count / GROUP_WIDTH - 1;
+
+	unsigned int i = 0;
+	for (i = 0; i < table->bucket_count; i++) {
+		if (table->control[i] < 0) {
+			continue;
+		}
+
+		size_t group = (table->slots[i].hash >> 7) & group_mask;
+		unsigned int probe_length = 1;
+		while (group != i / GROUP_WIDTH) {
+			group = (group + probe_length) & group_mask;
+			probe_length++;
+		}
+
+		if (probe_length > *max) {
+			*max = probe_length;
+		}
+
+		*total += probe_length;
+		_hash_table_count_length(histogram, probe_length - 1);
+	}
+}
+
+/* Private: Copies every item of a flat table into an array.
+ *
+ * table - The table to copy the items of.
+ * items - An array with room for every item.
+ *
+ * Returns nothing.
+ */
+void _hash_table_flat_collect(hash_table *table, hash_table_item *items) {
+	unsigned int i = 0;
+	for (i = 0; i < table->bucket_count; i++) {
+		if (table->control[i] >= 0) {
+			*items++ = table->slots[i];
+		}
+	}
+}
+
+/* Private: Visits every item of a flat table whose probe sequence
+ *          starts at the group a cursor points to, then advances
+ *          the cursor to the next group. Such items can only have
+ *          been placed in groups up to the first one along the
+ *          sequence with an empty slot, since deleted slots never
+ *          become empty.
+ *
+ * table - The table to visit the items of.
+ * cursor - The cursor, as described by hash_table_scan.
+ * visit - The function to call with each item's key, key length,
+ *         value, and context.
+ * context - The pointer to pass to visit.
+ *
+ * Returns the number of items visited.
+ */
+unsigned int _hash_table_flat_scan(hash_table *table, unsigned long *cursor, void (*visit)(const char *, size_t, void *, void *), void *context) {
+	size_t group_mask = table->bucket_count / GROUP_WIDTH - 1;
+	size_t home = *cursor & group_mask;
+	size_t group = home;
+	unsigned int visited = 0;
+
+	*cursor = _hash_table_next_cursor(*cursor, group_mask);
+
+	size_t step = 0;
+	while (true) {
+		signed char *control = _hash_table_flat_group(table, group);
+
+		int i = 0;
+		for (i = 0; i < GROUP_WIDTH; i++) {
+			hash_table_item *item = &table->slots[group * GROUP_WIDTH + i];
+			if (control[i] >= 0 && ((item->hash >> 7) & group_mask) == home) {
+				visit(item->key, item->key_length, item->value, context);
+				visited++;
+			}
+		}
+
+		if (_group_match(control, CONTROL_EMPTY) != 0 || step == group_mask) {
+			return visited;
+		}
+
+		step++;
+		group = (group + step) & group_mask;
+	}
+}
+
+/* Private: Visits every item of a flat table in one pass over its
+ *          slots.
+ *
+ * table - The table to visit the items of.
+ * visit - The function to call with each item's key, key length,
+ *         value, and context.
+ * context - The pointer to pass to visit.
+ *
+ * Returns nothing.
+ */
+void _hash_table_flat_foreach(hash_table *table, void (*visit)(const char *, size_t, void *, void *), void *context) {
+	unsigned int i = 0;
+	for (i = 0; i < table->bucket_count; i++) {
+		if (table->control[i] >= 0) {
+			visit(table->slots[i].key, table->slots[i].key_length, table->slots[i].value, context);
+		}
+	}
+}
+
+/* Private: Releases every item of a flat table, if any of them
+ *          have anything to free, without changing its storage.
+ *
+ * table - The table to release the items of.
+ *
+ * Returns nothing.
+ */
+static void _hash_table_flat_release_items(hash_table *table) {
+	if (!table->arena || table->releases_values) {
+		_hash_table_epoch_settle(table);
+
+		unsigned int i = 0;
+		for (i = 0; i < table->bucket_count; i++) {
+			if (table->control[i] >= 0) {
+				_hash_table_item_release(table, &table->slots[i]);
+			}
+		}
+	}
+}
+
+/* Private: Releases every item of a flat table, keeping its
+ *          storage. The control bytes are left for hash_table_clear
+ *          to reset.
+ *
+ * table - The table to clear.
+ *
+ * Returns nothing.
+ */
+void _hash_table_flat_clear(hash_table *table) {
+	_hash_table_flat_release_items(table);
+
+	table->occupied_buckets = 0;
+}
+
+/* Private: Empties a run of the slots of a flat table by resetting
+ *          their control bytes.
+ *
+ * table - The table to change.
+ * start - The index of the first slot.
+ * count - The number of slots.
+ *
+ * Returns nothing.
+ */
+void _hash_table_flat_reset(hash_table *table, unsigned int start, unsigned int count) {
+	memset(table->control + start, CONTROL_EMPTY, count * sizeof(signed char));
+}
+
+/* Private: Releases every item of a flat table and frees its
+ *          storage, but not the table itself or its arena. Items
+ *          are only visited if they have anything to free.
+ *
+ * table - The table to clear.
+ *
+ * Returns nothing.
+ */
+void _hash_table_flat_free(hash_table *table) {
+	_hash_table_flat_release_items(table);
+
+	free(table->control);
+	free(table->slots);
+}
+
+/* Private: Gets the values of a batch of keys in a flat table.
+ *          Each pass over the batch prefetches what the next pass
+ *          reads for every key, so the cache misses of the whole
+ *          batch overlap instead of being taken one at a time:
+ *          first each key's control group, then the slot its tag
+ *          matches, then that slot's stored key.
+ *
+ * table - The table to get the values from.
+ * keys - The keys to get the values of.
+ * lengths - The length of each key in bytes.
+ * hashes - The hash of each key, from _hash_table_hash.
+ * count - The number of keys, at most HASH_TABLE_BATCH_SIZE.
+ * values - Set to the value of each key, or NULL for keys that
+ *          couldn't be found.
+ *
+ * Returns nothing.
+ */
+void _hash_table_flat_get_many(hash_table *table, const void **keys, const size_t *lengths, const uint64_t *hashes, size_t count, void **values) {
+	size_t group_mask = table->bucket_count / GROUP_WIDTH - 1;
+	hash_table_item *candidates[HASH_TABLE_BATCH_SIZE];
+
+	size_t i = 0;
+	for (i = 0; i < count; i++) {
+		__builtin_prefetch(table->control + ((hashes[i] >> 7) & group_mask) * GROUP_WIDTH);
+	}
+
+	for (i = 0; i < count; i++) {
+		size_t group = (hashes[i] >> 7) & group_mask;
+		control_mask matches = _group_match(_hash_table_flat_group(table, group), hashes[i] & 0x7f);
+
+		candidates[i] = NULL;
+		if (matches != 0) {
+			candidates[i] = &table->slots[group * GROUP_WIDTH + _group_mask_lane(matches)];
+			__builtin_prefetch(candidates[i]);
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		if (candidates[i] != NULL && candidates[i]->hash == hashes[i]) {
+			__builtin_prefetch(candidates[i]->key);
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		values[i] = _hash_table_flat_get(table, keys[i], lengths[i], hashes[i]);
+	}
+}
@@ -0,0 +1,577 @@
+/*
+ *  frozen.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <sys/mman.h>
+
+#include "hash_table_private.h"
+
+/* Frozen tables find each key's slot with a minimal perfect hash
+ * built the way PTHash builds one. Keys are split into buckets of
+ * about KEYS_PER_BUCKET keys each, and every bucket is given a
+ * pilot: the first number that, mixed into the hashes of the
+ * bucket's keys, sends each of them to a position no other key
+ * has taken. There are a few more positions than keys, which
+ * makes pilots quick to find; positions past the last slot are
+ * remapped to the slots no key was sent to, so every slot is full.
+ */
+#define KEYS_PER_BUCKET 4
+#define EXTRA_POSITIONS_PER_100 3
+#define MAX_PILOT UINT16_MAX
+#define MAX_BUILD_ATTEMPTS 16
+#define MAX_INLINE_ENTRY_SIZE 64
+
+bool _hash_table_frozen_build(hash_table_frozen *frozen, hash_table_item *items, unsigned int count, uint32_t *positions);
+
+/* Private: Scrambles the bits of a 64-bit number.
+ *
+ * x - The number to scramble.
+ *
+ * Returns the scrambled number.
+ */
+static inline uint64_t _frozen_mix(uint64_t x) {
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+
+	return x;
+}
+
+/* Private: Maps a 64-bit number evenly onto a range without a
+ *          division.
+ *
+ * x - The number to map.
+ * range - The size of the range.
+ *
+ * Returns a number less than range.
+ */
+static inline unsigned int _frozen_reduce(uint64_t x, unsigned int range) {
+	return (unsigned int)(((__uint128_t)x * range) >> 64);
+}
+
+/* Private: Gets the bucket of a key's hash.
+ */
+static inline unsigned int _frozen_bucket(const hash_table_frozen *frozen, uint64_t hash) {
+	return _frozen_reduce(_frozen_mix(hash ^ frozen->seed), frozen->bucket_count);
+}
+
+/* Private: Gets the position a pilot sends a key's hash to.
+ */
+static inline unsigned int _frozen_position(const hash_table_frozen *frozen, uint64_t hash, unsigned int pilot) {
+	return _frozen_reduce(_frozen_mix(hash ^ frozen->seed ^ ((pilot + 1) * 0x9e3779b97f4a7c15ULL)), frozen->position_count);
+}
+
+/* Private: Gets the slot holding the only key that could match a
+ *          hash in a frozen table.
+ *
+ * table - The table to search, which must not be empty.
+ * hash - The key's hash, from _hash_table_hash.
+ *
+ * Returns the index of the slot.
+ */
+static inline unsigned int _frozen_slot(hash_table *table, uint64_t hash) {
+	hash_table_frozen *frozen = table->frozen;
+
+	unsigned int position = _frozen_position(frozen, hash, frozen->pilots[_frozen_bucket(frozen, hash)]);
+	if (position >= table->length) {
+		position = frozen->remap[position - table->length];
+	}
+
+	return position;
+}
+
+/* Private: Finds pilots that send every item to a different
+ *          position. Buckets are given pilots from largest to
+ *          smallest, while most positions are still free.
+ *
+ * frozen - The structure to fill in, with its seed and counts set.
+ * items - The items to place.
+ * count - The number of items.
+ * positions - Set to the position of each item.
+ *
+ * Returns true if pilots were found; otherwise, false is returned
+ * and a different seed should be tried.
+ */
+bool _hash_table_frozen_build(hash_table_frozen *frozen, hash_table_item *items, unsigned int count, uint32_t *positions) {
+	unsigned int bucket_count = frozen->bucket_count;
+	bool built = false;
+
+	uint32_t *starts = calloc(bucket_count + 1, sizeof(uint32_t));
+	uint32_t *members = malloc((count + 1) * sizeof(uint32_t));
+	uint32_t *order = malloc(bucket_count * sizeof(uint32_t));
+	uint64_t *taken = calloc(frozen->position_count / 64 + 1, sizeof(uint64_t));
+	if (starts == NULL || members == NULL || order == NULL || taken == NULL) {
+		goto done;
+	}
+
+	/* Sort the items by bucket, then the buckets by size.
+	 */
+	unsigned int i = 0, max_size = 0;
+	for (i = 0; i < count; i++) {
+		starts[_frozen_bucket(frozen, items[i].hash) + 1]++;
+	}
+
+	for (i = 0; i < bucket_count; i++) {
+		if (starts[i + 1] > max_size) {
+			max_size = starts[i + 1];
+		}
+
+		starts[i + 1] += starts[i];
+	}
+
+	uint32_t *fill = malloc((bucket_count + max_size + 2) * sizeof(uint32_t));
+	if (fill == NULL) {
+		goto done;
+	}
+
+	memcpy(fill, starts, bucket_count * sizeof(uint32_t));
+	for (i = 0; i < count; i++) {
+		members[fill[_frozen_bucket(frozen, items[i].hash)]++] = i;
+	}
+
+	uint32_t *size_starts = fill;
+	memset(size_starts, 0, (max_size + 2) * sizeof(uint32_t));
+	for (i = 0; i < bucket_count; i++) {
+		size_starts[max_size - (starts[i + 1] - starts[i]) + 1]++;
+	}
+
+	for (i = 0; i <= max_size; i++) {
+		size_starts[i + 1] += size_starts[i];
+	}
+
+	for (i = 0; i < bucket_count; i++) {
+		order[size_starts[max_size - (starts[i + 1] - starts[i])]++] = i;
+	}
+
+	free(fill);
+
+	for (i = 0; i < bucket_count; i++) {
+		unsigned int bucket = order[i];
+		unsigned int start = starts[bucket], size = starts[bucket + 1] - start;
+		if (size == 0) {
+			frozen->pilots[bucket] = 0;
+			continue;
+		}
+
+		unsigned int pilot = 0;
+		for (pilot = 0; pilot <= MAX_PILOT; pilot++) {
+			unsigned int j = 0;
+			for (j = 0; j < size; j++) {
+				unsigned int position = _frozen_position(frozen, items[members[start + j]].hash, pilot);
+				if ((taken[position / 64] >> (position % 64)) & 1) {
+					break;
+				}
+
+				taken[position / 64] |= ((uint64_t)1) << (position % 64);
+				positions[members[start + j]] = position;
+			}
+
+			if (j == size) {
+				break;
+			}
+
+			/* Free the positions this pilot took before colliding.
+			 */
+			while (j > 0) {
+				j--;
+				unsigned int position = positions[members[start + j]];
+				taken[position / 64] &= ~(((uint64_t)1) << (position % 64));
+			}
+		}
+
+		if (pilot > MAX_PILOT) {
+			goto done;
+		}
+
+		frozen->pilots[bucket] = pilot;
+	}
+
+	/* Remap the positions past the last slot to the empty slots.
+	 */
+	unsigned int free_slot = 0, position = 0;
+	for (position = count; position < frozen->position_count; position++) {
+		if ((taken[position / 64] >> (position % 64)) & 1) {
+			while ((taken[free_slot / 64] >> (free_slot % 64)) & 1) {
+				free_slot++;
+			}
+
+			frozen->remap[position - count] = free_slot++;
+		} else {
+			frozen->remap[position - count] = 0;
+		}
+	}
+
+	built = true;
+
+done:
+	free(starts);
+	free(members);
+	free(order);
+	free(taken);
+
+	return built;
+}
+
+/* Private: Gets the key of an entry of a frozen table.
+ */
+static inline const char *_frozen_key(const hash_table_frozen *frozen, const hash_table_frozen_entry *entry) {
+	return frozen->keys_inline ? entry->key : frozen->keys + entry->key_offset;
+}
+
+/* Private: Checks whether an entry of a frozen table holds a key.
+ */
+static inline bool _frozen_matches(const hash_table_frozen *frozen, const hash_table_frozen_entry *entry, const void *key, size_t length, uint64_t hash) {
+	return entry->hash == hash && entry->key_length == length && memcmp(key, _frozen_key(frozen, entry), length) == 0;
+}
+
+/* Private: Builds the perfect hash and entries of a set of items,
+ *          copying their keys but leaving the items unchanged.
+ *
+ * items - The items to build from.
+ * count - The number of items.
+ * releases_values - Whether any item has a release function that
+ *                   must be kept.
+ * value_size - The size of each item's value, which is copied into
+ *              one array in slot order, or zero to keep the values
+ *              as they are.
+ *
+ * Returns the new structure, or NULL if it couldn't be built.
+ */
+hash_table_frozen *_hash_table_frozen_new(hash_table_item *items, unsigned int count, bool releases_values, size_t value_size) {
+	hash_table_frozen *frozen = calloc(1, sizeof(hash_table_frozen));
+	uint32_t *positions = malloc((count + 1) * sizeof(uint32_t));
+	if (frozen == NULL || positions == NULL) {
+		goto fail;
+	}
+
+	frozen->bucket_count = count / KEYS_PER_BUCKET + 1;
+	frozen->position_count = count + count * EXTRA_POSITIONS_PER_100 / 100;
+	frozen->pilots = malloc(frozen->bucket_count * sizeof(uint16_t));
+	frozen->remap = malloc((frozen->position_count - count + 1) * sizeof(uint32_t));
+	if (frozen->pilots == NULL || frozen->remap == NULL) {
+		goto fail;
+	}
+
+	size_t max_length = 0, keys_size = 0;
+	unsigned int i = 0;
+	for (i = 0; i < count; i++) {
+		if (items[i].key_length > max_length) {
+			max_length = items[i].key_length;
+		}
+
+		keys_size += items[i].key_length + 1;
+	}
+
+	/* Keys are stored in their entries if every entry still fits
+	 * in a cache line.
+	 */
+	size_t entry_size = sizeof(hash_table_frozen_entry) + max_length + 1;
+	entry_size = (entry_size + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+
+	frozen->keys_inline = entry_size <= MAX_INLINE_ENTRY_SIZE;
+	if (frozen->keys_inline) {
+		frozen->entry_size = entry_size;
+	} else {
+		if (keys_size > UINT32_MAX) {
+			goto fail;
+		}
+
+		frozen->entry_size = sizeof(hash_table_frozen_entry);
+		frozen->keys = malloc(keys_size);
+		frozen->keys_size = keys_size;
+		if (frozen->keys == NULL) {
+			goto fail;
+		}
+	}
+
+	frozen->entries = malloc((count + 1) * frozen->entry_size);
+	if (frozen->entries == NULL) {
+		goto fail;
+	}
+
+	size_t value_stride = (value_size + HASH_TABLE_VALUE_ALIGNMENT - 1) & ~(HASH_TABLE_VALUE_ALIGNMENT - 1);
+	if (value_size > 0) {
+		frozen->values = malloc((count + 1) * value_stride);
+		if (frozen->values == NULL) {
+			goto fail;
+		}
+	}
+
+	if (releases_values) {
+		frozen->release_functions = malloc((count + 1) * sizeof(frozen->release_functions[0]));
+		if (frozen->release_functions == NULL) {
+			goto fail;
+		}
+	}
+
+	/* A pilot can only be found if no two keys in a bucket share
+	 * their whole hash, which only other seeds can fix.
+	 */
+	int attempt = 0;
+	for (attempt = 0; attempt < MAX_BUILD_ATTEMPTS; attempt++) {
+		frozen->seed = _frozen_mix(attempt + 1);
+		if (_hash_table_frozen_build(frozen, items, count, positions)) {
+			break;
+		}
+	}
+
+	if (attempt == MAX_BUILD_ATTEMPTS) {
+		goto fail;
+	}
+
+	size_t offset = 0;
+	for (i = 0; i < count; i++) {
+		unsigned int slot = positions[i];
+		if (slot >= count) {
+			slot = frozen->remap[slot - count];
+		}
+
+		hash_table_frozen_entry *entry = _hash_table_frozen_entry(frozen, slot);
+		entry->hash = items[i].hash;
+		entry->value = (value_size > 0) ? (uint64_t)slot * value_stride : (uintptr_t)items[i].value;
+		entry->key_length = items[i].key_length;
+		entry->key_offset = offset;
+
+		char *key = entry->key;
+		if (!frozen->keys_inline) {
+			key = frozen->keys + offset;
+			offset += items[i].key_length + 1;
+		}
+
+		memcpy(key, items[i].key, items[i].key_length + 1);
+
+		if (value_size > 0) {
+			memcpy(frozen->values + entry->value, items[i].value, value_size);
+		}
+
+		if (frozen->release_functions != NULL) {
+			frozen->release_functions[slot] = items[i].release_function;
+		}
+	}
+
+	free(positions);
+
+	return frozen;
+
+fail:
+	if (frozen != NULL) {
+		_hash_table_frozen_destroy(frozen);
+	}
+
+	free(positions);
+
+	return NULL;
+}
+
+/* Private: Frees the perfect hash and entries of a frozen table,
+ *          or unmaps them if they were loaded from a file, without
+ *          releasing any values.
+ *
+ * frozen - The structure to free.
+ *
+ * Returns nothing.
+ */
+void _hash_table_frozen_destroy(hash_table_frozen *frozen) {
+	if (frozen->mapping != NULL) {
+		munmap(frozen->mapping, frozen->mapping_size);
+	} else {
+		free(frozen->pilots);
+		free(frozen->remap);
+		free(frozen->entries);
+		free(frozen->keys);
+		free(frozen->values);
+	}
+
+	free(frozen->release_functions);
+	free(frozen);
+}
+
+/* Public: Compiles a hash table into an immutable form for fast
+ *         lookups, using a minimal perfect hash of its keys. Every
+ *         key is found with a single probe into an array holding
+ *         exactly one entry per key; short keys are stored in
+ *         their entries, and long keys one after another. Values
+ *         keep their release functions. Afterwards, hash_table_get
+ *         and related functions behave as before, but the table
+ *         can no longer be changed.
+ *
+ * table - The table to freeze.
+ *
+ * Returns true if the table was frozen; otherwise, false is
+ * returned and the table is unchanged.
+ */
+bool hash_table_freeze(hash_table *table) {
+	if (table->layout == HASH_TABLE_FROZEN) {
+		return true;
+	}
+
+	unsigned int count = table->length;
+
+	hash_table_item *items = malloc((count + 1) * sizeof(hash_table_item));
+	if (items == NULL) {
+		return false;
+	}
+
+	_hash_table_collect_items(table, items);
+
+	hash_table_frozen *frozen = _hash_table_frozen_new(items, count, table->releases_values, table->value_size);
+	if (frozen == NULL) {
+		free(items);
+		return false;
+	}
+
+	_hash_table_discard_storage(table, items, count);
+
+	table->layout = HASH_TABLE_FROZEN;
+	table->bucket_count = count;
+	table->occupied_buckets = count;
+	table->frozen = frozen;
+
+	free(items);
+
+	return true;
+}
+
+/* Private: Gets the value of a key in a frozen table.
+ *
+ * table - The table to get the value from.
+ * key - The key to get the value of.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ *
+ * Returns the value of key in table, or NULL if
+ * the element couldn't be found.
+ */
+void *_hash_table_frozen_get(hash_table *table, const void *key, size_t length, uint64_t hash) {
+	if (table->length == 0) {
+		return NULL;
+	}
+
+	HASH_TABLE_COUNT(table, searches, 1);
+	HASH_TABLE_COUNT(table, comparisons, 1);
+
+	hash_table_frozen_entry *entry = _hash_table_frozen_entry(table->frozen, _frozen_slot(table, hash));
+	if (!_frozen_matches(table->frozen, entry, key, length, hash)) {
+		return NULL;
+	}
+
+	return _hash_table_frozen_value(table->frozen, entry);
+}
+
+/* Private: Gets the values of a batch of keys in a frozen table,
+ *          prefetching the entry of every key before resolving any
+ *          of them.
+ *
+ * table - The table to get the values from.
+ * keys - The keys to get the values of.
+ * lengths - The length of each key in bytes.
+ * hashes - The hash of each key, from _hash_table_hash.
+ * count - The number of keys, at most HASH_TABLE_BATCH_SIZE.
+ * values - Set to the value of each key, or NULL for keys that
+ *          couldn't be found.
+ *
+ * Returns nothing.
+ */
+void _hash_table_frozen_get_many(hash_table *table, const void **keys, const size_t *lengths, const uint64_t *hashes, size_t count, void **values) {
+	hash_table_frozen *frozen = table->frozen;
+	hash_table_frozen_entry *entries[HASH_TABLE_BATCH_SIZE];
+
+	if (table->length == 0) {
+		memset(values, 0, count * sizeof(void *));
+		return;
+	}
+
+	size_t i = 0;
+	for (i = 0; i < count; i++) {
+		entries[i] = _hash_table_frozen_entry(frozen, _frozen_slot(table, hashes[i]));
+		__builtin_prefetch(entries[i]);
+	}
+
+	if (!frozen->keys_inline) {
+		for (i = 0; i < count; i++) {
+			if (entries[i]->hash == hashes[i]) {
+				__builtin_prefetch(frozen->keys + entries[i]->key_offset);
+			}
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		values[i] = _frozen_matches(frozen, entries[i], keys[i], lengths[i], hashes[i]) ? _hash_table_frozen_value(frozen, entries[i]) : NULL;
+	}
+}
+
+/* Private: Visits items of a frozen table in slot order, starting
+ *          from a cursor. Frozen tables never change, so the cursor
+ *          is simply the next slot to visit.
+ *
+ * table - The table to visit the items of.
+ * cursor - The slot to start from.
+ * count - The number of items to visit, at least one.
+ * visit - The function to call with each item's key, key length,
+ *         value, and context.
+ * context - The pointer to pass to visit.
+ *
+ * Returns the slot to continue from, or zero once every item has
+ * been visited.
+ */
+unsigned long _hash_table_frozen_scan(hash_table *table, unsigned long cursor, unsigned int count, void (*visit)(const char *, size_t, void *, void *), void *context) {
+	hash_table_frozen *frozen = table->frozen;
+	if (cursor >= table->length) {
+		return 0;
+	}
+
+	unsigned long end = (count < table->length - cursor) ? cursor + count : table->length;
+	for (; cursor < end; cursor++) {
+		hash_table_frozen_entry *entry = _hash_table_frozen_entry(frozen, cursor);
+		visit(_frozen_key(frozen, entry), entry->key_length, _hash_table_frozen_value(frozen, entry), context);
+	}
+
+	return (cursor < table->length) ? cursor : 0;
+}
+
+/* Public: Gets the size of the perfect hash of a frozen table,
+ *         not counting its entries and keys.
+ *
+ * table - The table to measure.
+ *
+ * Returns the number of bits used per key, or zero if the table
+ * isn't frozen or is empty.
+ */
+double hash_table_frozen_bits_per_key(hash_table *table) {
+	if (table->layout != HASH_TABLE_FROZEN || table->length == 0) {
+		return 0;
+	}
+
+	hash_table_frozen *frozen = table->frozen;
+	size_t bytes = frozen->bucket_count * sizeof(uint16_t) + (frozen->position_count - table->length) * sizeof(uint32_t);
+
+	return ((double)bytes) * 8 / table->length;
+}
+
+/* Private: Releases every value of a frozen table and frees its
+ *          storage, but not the table itself.
+ *
+ * table - The table to clear.
+ *
+ * Returns nothing.
+ */
+void _hash_table_frozen_free(hash_table *table) {
+	hash_table_frozen *frozen = table->frozen;
+
+	if (frozen->release_functions != NULL) {
+		unsigned int i = 0;
+		for (i = 0; i < table->length; i++) {
+			if (frozen->release_functions[i] != NULL) {
+				frozen->release_functions[i](_hash_table_frozen_value(frozen, _hash_table_frozen_entry(frozen, i)));
+			}
+		}
+	}
+
+	_hash_table_frozen_destroy(frozen);
+}
@@ -0,0 +1,665 @@
+/*
+ *  hash_set.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/18/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <limits.h>
+
+#include "hash_set.h"
+
+/* Keys are stored in one flat array of slots, probed linearly from
+ * each key's home slot. A slot holds the high 32 bits of its key's
+ * hash (its tag, with the low bit set so that a tag of zero marks
+ * an empty slot), the key's length, and either the key itself, if
+ * it is short enough, or its offset in the set's key storage.
+ *
+ * The home slot is taken from the top bits of the tag, so keys are
+ * never rehashed when a set grows, and every set ordered by the
+ * same hash function keeps its keys in the same order. Set
+ * operations walk both sets front to back together, and build
+ * their results front to back, without hashing any keys.
+ *
+ * Removal shifts later keys back rather than leaving a marker, so
+ * probes only ever stop at empty slots.
+ */
+#define INITIAL_SIZE 16
+#define MAX_LOAD_NUMERATOR 3
+#define MAX_LOAD_DENOMINATOR 4
+#define MIN_KEYS_SIZE 256
+
+/* Key storage is compacted once at least this many bytes, and half
+ * of the storage, are no longer used
+ */
+#define MIN_UNUSED_KEYS_SIZE 4096
+
+typedef struct hash_set_slot {
+	uint32_t tag;
+	uint32_t length;
+	char key[];
+} hash_set_slot;
+
+unsigned int _hash_set_size_for_capacity(unsigned int capacity);
+hash_set *_hash_set_new_like(const hash_set *set, unsigned int capacity);
+bool _hash_set_resize(hash_set *set, unsigned int size);
+hash_set_slot *_hash_set_find(const hash_set *set, const void *key, size_t length, uint32_t tag);
+bool _hash_set_insert_tag(hash_set *set, const void *key, size_t length, uint32_t tag);
+uint32_t _hash_set_tag_from(const hash_set *set, const hash_set *from, const hash_set_slot *slot, const char *key);
+
+/* Private: Gets the slot at an index.
+ *
+ * set - The set to get the slot from.
+ * index - The index of the slot.
+ *
+ * Returns the slot.
+ */
+static inline hash_set_slot *_hash_set_slot(const hash_set *set, size_t index) {
+	return (hash_set_slot *)(set->slots + index * set->slot_size);
+}
+
+/* Private: Gets the key held by a full slot.
+ *
+ * set - The set the slot belongs to.
+ * slot - The slot.
+ *
+ * Returns the key, which is followed by a zero byte.
+ */
+static inline const char *_hash_set_key(const hash_set *set, const hash_set_slot *slot) {
+	if (slot->length <= set->inline_key_size) {
+		return slot->key;
+	}
+
+	uint64_t offset = 0;
+	memcpy(&offset, slot->key, sizeof(offset));
+
+	return set->keys + offset;
+}
+
+/* Private: Gets the tag of a key.
+ *
+ * set - The set whose hash function to use.
+ * key - The key.
+ * length - The length of the key in bytes.
+ *
+ * Returns the tag, which is never zero.
+ */
+static inline uint32_t _hash_set_tag(const hash_set *set, const void *key, size_t length) {
+	return (uint32_t)(set->hash_function(key, length, set->seed) >> 32) | 1;
+}
+
+/* Private: Gets the home slot of a tag.
+ *
+ * set - The set the tag belongs to.
+ * tag - The tag.
+ *
+ * Returns the index of the home slot.
+ */
+static inline size_t _hash_set_home(const hash_set *set, uint32_t tag) {
+	return tag >> (32 - __builtin_ctz(set->bucket_count));
+}
+
+/* Private: Gets whether two sets hash keys the same way, so that
+ *          tags from one can be used in the other.
+ *
+ * set - A set.
+ * other - Another set.
+ *
+ * Returns true if the sets give every key the same tag.
+ */
+static inline bool _hash_set_same_hash(const hash_set *set, const hash_set *other) {
+	return set->hash_function == other->hash_function && set->seed == other->seed;
+}
+
+/* Private: Gets the number of slots needed to hold a number of keys
+ *          without growing.
+ *
+ * capacity - The number of keys to hold.
+ *
+ * Returns the number of slots, a power of two, or zero if it would
+ * be too large.
+ */
+unsigned int _hash_set_size_for_capacity(unsigned int capacity) {
+	unsigned int size = INITIAL_SIZE;
+	while ((uint64_t)size * MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR < capacity) {
+		if (size > UINT_MAX / 2) {
+			return 0;
+		}
+
+		size *= 2;
+	}
+
+	return size;
+}
+
+/* Private: Creates an empty set that hashes and stores keys the
+ *          same way as another.
+ *
+ * set - The set to copy the settings of.
+ * capacity - The number of keys the new set should hold.
+ *
+ * Returns the new set, or NULL if it couldn't be created.
+ */
+hash_set *_hash_set_new_like(const hash_set *set, unsigned int capacity) {
+	unsigned int size = _hash_set_size_for_capacity(capacity);
+	if (size == 0) {
+		return NULL;
+	}
+
+	hash_set *result = malloc(sizeof(hash_set));
+	if (result == NULL) {
+		return NULL;
+	}
+
+	result->hash_function = set->hash_function;
+	result->seed = set->seed;
+	result->bucket_count = 0;
+	result->length = 0;
+	result->slots = NULL;
+	result->slot_size = set->slot_size;
+	result->inline_key_size = set->inline_key_size;
+	result->keys = NULL;
+	result->keys_used = 0;
+	result->keys_size = 0;
+	result->keys_unused = 0;
+
+	if (!_hash_set_resize(result, size)) {
+		free(result);
+		return NULL;
+	}
+
+	return result;
+}
+
+/* Private: Moves every key of a set to a new array of slots,
+ *          compacting its key storage on the way.
+ *
+ * set - The set to resize.
+ * size - The new number of slots, a power of two.
+ *
+ * Returns true if the set was resized; otherwise, false is
+ * returned and the set is unchanged.
+ */
+bool _hash_set_resize(hash_set *set, unsigned int size) {
+	char *slots = calloc(size, set->slot_size);
+	if (slots == NULL) {
+		return false;
+	}
+
+	size_t keys_used = set->keys_used - set->keys_unused;
+	char *keys = set->keys;
+	if (set->keys_unused > 0) {
+		keys = keys_used > 0 ? malloc(keys_used) : NULL;
+		if (keys_used > 0 && keys == NULL) {
+			free(slots);
+			return false;
+		}
+	}
+
+	char *old_slots = set->slots;
+	char *old_keys = set->keys;
+	unsigned int old_size = set->bucket_count;
+
+	set->slots = slots;
+	set->bucket_count = size;
+
+	size_t mask = size - 1;
+	size_t used = 0;
+	unsigned int i = 0;
+	for (i = 0; i < old_size; i++) {
+		hash_set_slot *old_slot = (hash_set_slot *)(old_slots + i * set->slot_size);
+		if (old_slot->tag == 0) {
+			continue;
+		}
+
+		size_t index = _hash_set_home(set, old_slot->tag);
+		while (_hash_set_slot(set, index)->tag != 0) {
+			index = (index + 1) & mask;
+		}
+
+		hash_set_slot *slot = _hash_set_slot(set, index);
+		memcpy(slot, old_slot, set->slot_size);
+
+		if (keys != old_keys && slot->length > set->inline_key_size) {
+			uint64_t offset = 0;
+			memcpy(&offset, slot->key, sizeof(offset));
+			memcpy(keys + used, old_keys + offset, slot->length + 1);
+
+			offset = used;
+			memcpy(slot->key, &offset, sizeof(offset));
+			used += slot->length + 1;
+		}
+	}
+
+	free(old_slots);
+
+	if (keys != old_keys) {
+		free(old_keys);
+		set->keys = keys;
+		set->keys_used = keys_used;
+		set->keys_size = keys_used;
+		set->keys_unused = 0;
+	}
+
+	return true;
+}
+
+/* Private: Finds the slot holding a key, or the empty slot where it
+ *          would be placed.
+ *
+ * set - The set to search.
+ * key - The key to look for.
+ * length - The length of the key in bytes.
+ * tag - The key's tag in the set.
+ *
+ * Returns the slot, whose tag is either zero or the key's tag.
+ */
+hash_set_slot *_hash_set_find(const hash_set *set, const void *key, size_t length, uint32_t tag) {
+	size_t mask = set->bucket_count - 1;
+	size_t index = _hash_set_home(set, tag);
+
+	while (true) {
+		hash_set_slot *slot = _hash_set_slot(set, index);
+		if (slot->tag == 0) {
+			return slot;
+		}
+
+		if (slot->tag == tag && slot->length == length && memcmp(_hash_set_key(set, slot), key, length) == 0) {
+			return slot;
+		}
+
+		index = (index + 1) & mask;
+	}
+}
+
+/* Private: Adds a key to a set whose tag is already known.
+ *
+ * set - The set to add the key to.
+ * key - The key to add.
+ * length - The length of the key in bytes.
+ * tag - The key's tag in the set.
+ *
+ * Returns true if the key is in the set; otherwise, false is
+ * returned and the set is unchanged.
+ */
+bool _hash_set_insert_tag(hash_set *set, const void *key, size_t length, uint32_t tag) {
+	if (length >= UINT32_MAX) {
+		return false;
+	}
+
+	hash_set_slot *slot = _hash_set_find(set, key, length, tag);
+	if (slot->tag != 0) {
+		return true;
+	}
+
+	if ((uint64_t)(set->length + 1) * MAX_LOAD_DENOMINATOR > (uint64_t)set->bucket_count * MAX_LOAD_NUMERATOR) {
+		if (set->bucket_count > UINT_MAX / 2 || !_hash_set_resize(set, set->bucket_count * 2)) {
+			return false;
+		}
+
+		slot = _hash_set_find(set, key, length, tag);
+	}
+
+	if (length <= set->inline_key_size) {
+		memcpy(slot->key, key, length);
+		slot->key[length] = '\0';
+	} else {
+		if (set->keys_size - set->keys_used < length + 1) {
+			size_t size = set->keys_size * 2;
+			if (size < set->keys_used + length + 1) {
+				size = set->keys_used + length + 1;
+			}
+
+			if (size < MIN_KEYS_SIZE) {
+				size = MIN_KEYS_SIZE;
+			}
+
+			char *keys = realloc(set->keys, size);
+			if (keys == NULL) {
+				return false;
+			}
+
+			set->keys = keys;
+			set->keys_size = size;
+		}
+
+		uint64_t offset = set->keys_used;
+		memcpy(set->keys + offset, key, length);
+		set->keys[offset + length] = '\0';
+		set->keys_used += length + 1;
+
+		memcpy(slot->key, &offset, sizeof(offset));
+	}
+
+	slot->tag = tag;
+	slot->length = (uint32_t)length;
+	set->length++;
+
+	return true;
+}
+
+/* Private: Gets the tag in one set of a key held by another.
+ *
+ * set - The set to get the tag in.
+ * from - The set holding the key.
+ * slot - The slot holding the key in from.
+ * key - The key.
+ *
+ * Returns the tag, reusing the key's tag in from if the sets hash
+ * keys the same way.
+ */
+uint32_t _hash_set_tag_from(const hash_set *set, const hash_set *from, const hash_set_slot *slot, const char *key) {
+	if (_hash_set_same_hash(set, from)) {
+		return slot->tag;
+	}
+
+	return _hash_set_tag(set, key, slot->length);
+}
+
+/* Public: Creates a new, empty set.
+ *
+ * Returns the new set, or NULL if it couldn't be created.
+ */
+hash_set *hash_set_new() {
+	hash_set_options options = { .hash = HASH_TABLE_HASH_FAST };
+	return hash_set_new_with_options(&options);
+}
+
+/* Public: Creates a new, empty set with the given options.
+ *
+ * options - The hash function, initial capacity, and longest
+ *           inline key of the set.
+ *
+ * Returns the new set, or NULL if it couldn't be created.
+ */
+hash_set *hash_set_new_with_options(const hash_set_options *options) {
+	hash_set settings;
+
+	if (options->hash == HASH_TABLE_HASH_KEYED) {
+		settings.hash_function = &hash_keyed;
+		settings.seed = hash_random_seed();
+	} else {
+		settings.hash_function = &hash_fast;
+		settings.seed = 0;
+	}
+
+	/* A slot can always hold a key offset, so keys that would fit in
+	 * its place are kept inline too.
+	 */
+	settings.inline_key_size = options->inline_key_size > 0 ? options->inline_key_size : HASH_SET_INLINE_KEY_SIZE;
+	if (settings.inline_key_size < sizeof(uint64_t) - 1) {
+		settings.inline_key_size = sizeof(uint64_t) - 1;
+	}
+
+	size_t key_size = ((size_t)settings.inline_key_size + 1 + 7) & ~(size_t)7;
+	settings.slot_size = sizeof(hash_set_slot) + key_size;
+	settings.inline_key_size = key_size - 1;
+
+	return _hash_set_new_like(&settings, options->capacity);
+}
+
+/* Public: Adds a string key to a set.
+ *
+ * set - The set to add the key to.
+ * key - The key to add.
+ *
+ * Returns true if the key is in the set; otherwise, false is
+ * returned and the set is unchanged.
+ */
+bool hash_set_insert(hash_set *set, char *key) {
+	return hash_set_insert_bytes(set, key, strlen(key));
+}
+
+/* Public: Adds a key to a set.
+ *
+ * set - The set to add the key to.
+ * key - The bytes of the key, which are copied.
+ * length - The length of the key in bytes.
+ *
+ * Returns true if the key is in the set; otherwise, false is
+ * returned and the set is unchanged.
+ */
+bool hash_set_insert_bytes(hash_set *set, const void *key, size_t length) {
+	return _hash_set_insert_tag(set, key, length, _hash_set_tag(set, key, length));
+}
+
+/* Public: Checks whether a set contains a string key.
+ *
+ * set - The set to search.
+ * key - The key to look for.
+ *
+ * Returns true if the key is in the set.
+ */
+bool hash_set_contains(const hash_set *set, char *key) {
+	return hash_set_contains_bytes(set, key, strlen(key));
+}
+
+/* Public: Checks whether a set contains a key.
+ *
+ * set - The set to search.
+ * key - The bytes of the key to look for.
+ * length - The length of the key in bytes.
+ *
+ * Returns true if the key is in the set.
+ */
+bool hash_set_contains_bytes(const hash_set *set, const void *key, size_t length) {
+	return _hash_set_find(set, key, length, _hash_set_tag(set, key, length))->tag != 0;
+}
+
+/* Public: Removes a string key from a set.
+ *
+ * set - The set to remove the key from.
+ * key - The key to remove.
+ *
+ * Returns true if the key was removed, or false if it wasn't in
+ * the set.
+ */
+bool hash_set_remove(hash_set *set, char *key) {
+	return hash_set_remove_bytes(set, key, strlen(key));
+}
+
+/* Public: Removes a key from a set. The keys after it in its run of
+ *         full slots are shifted back into the gap, unless that
+ *         would move them before their home slots.
+ *
+ * set - The set to remove the key from.
+ * key - The bytes of the key to remove.
+ * length - The length of the key in bytes.
+ *
+ * Returns true if the key was removed, or false if it wasn't in
+ * the set.
+ */
+bool hash_set_remove_bytes(hash_set *set, const void *key, size_t length) {
+	hash_set_slot *slot = _hash_set_find(set, key, length, _hash_set_tag(set, key, length));
+	if (slot->tag == 0) {
+		return false;
+	}
+
+	if (slot->length > set->inline_key_size) {
+		set->keys_unused += slot->length + 1;
+	}
+
+	size_t mask = set->bucket_count - 1;
+	size_t gap = ((char *)slot - set->slots) / set->slot_size;
+	size_t index = gap;
+
+	while (true) {
+		index = (index + 1) & mask;
+
+		hash_set_slot *next = _hash_set_slot(set, index);
+		if (next->tag == 0) {
+			break;
+		}
+
+		/* A key can fill the gap if its home is not after the gap,
+		 * going around from the key's slot.
+		 */
+		size_t home = _hash_set_home(set, next->tag);
+		if (((index - home) & mask) >= ((index - gap) & mask)) {
+			memcpy(_hash_set_slot(set, gap), next, set->slot_size);
+			gap = index;
+		}
+	}
+
+	memset(_hash_set_slot(set, gap), 0, set->slot_size);
+	set->length--;
+
+	/* Compacting the key storage can fail harmlessly, leaving it as
+	 * it is.
+	 */
+	if (set->keys_unused >= MIN_UNUSED_KEYS_SIZE && set->keys_unused * 2 >= set->keys_used) {
+		_hash_set_resize(set, set->bucket_count);
+	}
+
+	return true;
+}
+
+/* Public: Creates a set of the keys in either of two sets. The new
+ *         set hashes and stores keys the same way as the first.
+ *
+ * set - The first set.
+ * other - The second set.
+ *
+ * Returns the new set, or NULL if it couldn't be created.
+ */
+hash_set *hash_set_union(const hash_set *set, const hash_set *other) {
+	unsigned int capacity = set->length;
+	if (other->length > UINT_MAX - capacity) {
+		return NULL;
+	}
+
+	hash_set *result = _hash_set_new_like(set, capacity + other->length);
+	if (result == NULL) {
+		return NULL;
+	}
+
+	const hash_set *sources[2] = { set, other };
+	int s = 0;
+	for (s = 0; s < 2; s++) {
+		const hash_set *source = sources[s];
+
+		unsigned int i = 0;
+		for (i = 0; i < source->bucket_count; i++) {
+			hash_set_slot *slot = _hash_set_slot(source, i);
+			if (slot->tag == 0) {
+				continue;
+			}
+
+			const char *key = _hash_set_key(source, slot);
+			if (!_hash_set_insert_tag(result, key, slot->length, _hash_set_tag_from(result, source, slot, key))) {
+				hash_set_free(result);
+				return NULL;
+			}
+		}
+	}
+
+	return result;
+}
+
+/* Public: Creates a set of the keys in both of two sets. The new
+ *         set hashes and stores keys the same way as the first.
+ *
+ * set - The first set.
+ * other - The second set.
+ *
+ * Returns the new set, or NULL if it couldn't be created.
+ */
+hash_set *hash_set_intersection(const hash_set *set, const hash_set *other) {
+	const hash_set *smaller = set->length <= other->length ? set : other;
+	const hash_set *larger = smaller == set ? other : set;
+
+	hash_set *result = _hash_set_new_like(set, smaller->length);
+	if (result == NULL) {
+		return NULL;
+	}
+
+	unsigned int i = 0;
+	for (i = 0; i < smaller->bucket_count; i++) {
+		hash_set_slot *slot = _hash_set_slot(smaller, i);
+		if (slot->tag == 0) {
+			continue;
+		}
+
+		const char *key = _hash_set_key(smaller, slot);
+		if (_hash_set_find(larger, key, slot->length, _hash_set_tag_from(larger, smaller, slot, key))->tag == 0) {
+			continue;
+		}
+
+		if (!_hash_set_insert_tag(result, key, slot->length, _hash_set_tag_from(result, smaller, slot, key))) {
+			hash_set_free(result);
+			return NULL;
+		}
+	}
+
+	return result;
+}
+
+/* Public: Creates a set of the keys in one set but not in another.
+ *         The new set hashes and stores keys the same way as the
+ *         first.
+ *
+ * set - The set to take keys from.
+ * other - The set of keys to leave out.
+ *
+ * Returns the new set, or NULL if it couldn't be created.
+ */
+hash_set *hash_set_difference(const hash_set *set, const hash_set *other) {
+	hash_set *result = _hash_set_new_like(set, set->length);
+	if (result == NULL) {
+		return NULL;
+	}
+
+	unsigned int i = 0;
+	for (i = 0; i < set->bucket_count; i++) {
+		hash_set_slot *slot = _hash_set_slot(set, i);
+		if (slot->tag == 0) {
+			continue;
+		}
+
+		const char *key = _hash_set_key(set, slot);
+		if (_hash_set_find(other, key, slot->length, _hash_set_tag_from(other, set, slot, key))->tag != 0) {
+			continue;
+		}
+
+		if (!_hash_set_insert_tag(result, key, slot->length, slot->tag)) {
+			hash_set_free(result);
+			return NULL;
+		}
+	}
+
+	return result;
+}
+
+/* Public: Calls a function with every key of a set, in no
+ *         particular order. The set must not be changed until
+ *         this returns.
+ *
+ * set - The set whose keys to visit.
+ * visit - The function to call with each key, its length, and
+ *         context; keys are followed by a zero byte.
+ * context - A pointer passed to every call of visit.
+ *
+ * Returns nothing.
+ */
+void hash_set_foreach(const hash_set *set, void (*visit)(const char *key, size_t length, void *context), void *context) {
+	unsigned int i = 0;
+	for (i = 0; i < set->bucket_count; i++) {
+		hash_set_slot *slot = _hash_set_slot(set, i);
+		if (slot->tag != 0) {
+			visit(_hash_set_key(set, slot), slot->length, context);
+		}
+	}
+}
+
+/* Public: Frees memory associated with a set.
+ *
+ * set - The set to free.
+ *
+ * Returns nothing.
+ */
+void hash_set_free(hash_set *set) {
+	free(set->slots);
+	free(set->keys);
+	free(set);
+}
@@ -7,155 +7,614 @@
  */
 
 #include "hash_table.h"
+#include "hash_table_private.h"
 
 #define INITIAL_SIZE 4
-#define BUCKET_SIZE sizeof(ll_dlist *)
+#define BUCKET_SIZE sizeof(hash_table_node *)
+#define MAX_LOAD_FACTOR 0.67
 
-typedef struct {
-	char *key;
-	void *value;
-	void (*release_function)(void *);
-} hash_table_item;
+/* The number of non-empty buckets moved by each step of an
+ * incremental resize, and the number of empty buckets that may
+ * be skipped for each of them
+ */
+#define REHASH_STEP 4
+#define REHASH_EMPTY_VISITS 10
+
+/* The false positive rate of filters added by hash_table_add_filter,
+ * and the fewest keys a new filter has room for
+ */
+#define FILTER_FALSE_POSITIVE_RATE 0.001
+#define FILTER_MIN_CAPACITY 1024
+
+void _hash_table_node_free(hash_table *table, hash_table_node *node);
+void _hash_table_free_chains(hash_table *table, hash_table_node **buckets, unsigned int bucket_count);
+hash_table_node *_hash_table_find(hash_table *table, const void *key, size_t length, uint64_t hash);
+hash_table_item *_hash_table_insert(hash_table *table, const void *key, size_t length, uint64_t hash, bool *inserted);
+hash_table_node *_hash_table_unlink(hash_table_node **buckets, unsigned int index, const void *key, size_t length, uint64_t hash);
+void _hash_table_rehash_step(hash_table *table, unsigned int steps);
+void _hash_table_get_many(hash_table *table, const void **keys, const size_t *lengths, const uint64_t *hashes, size_t count, void **values);
+bool _hash_table_resize(hash_table *table, unsigned int size, bool incremental);
+bool _hash_table_filter_build(hash_table *table, size_t capacity);
+void _hash_table_filter_add(hash_table *table, uint64_t hash);
+void _hash_table_measure(hash_table *table, unsigned int *max, uint64_t *total, unsigned long *probe_histogram, unsigned long *chain_histogram);
+void _hash_table_reset_slots(hash_table *table, unsigned int start, unsigned int count);
+void _hash_table_epoch_advance(hash_table *table);
+unsigned int _hash_table_visit_chain(hash_table_node *node, void (*visit)(const char *, size_t, void *, void *), void *context);
+
+/* Private: Allocates memory for a key or node of a hash_table,
+ *          from the table's arena if it has one.
+ *
+ * table - The table the memory belongs to.
+ * size - The number of bytes to allocate.
+ *
+ * Returns the memory, or NULL if it couldn't be allocated.
+ */
+void *_hash_table_alloc(hash_table *table, size_t size) {
+	if (table->arena) {
+		return _hash_table_arena_alloc(table, size);
+	}
+	
+	return malloc(size);
+}
+
+/* Private: Frees memory from _hash_table_alloc. Memory from an
+ *          arena is left in place until the arena is freed.
+ *
+ * table - The table the memory belongs to.
+ * memory - The memory to free.
+ *
+ * Returns nothing.
+ */
+void _hash_table_dealloc(hash_table *table, void *memory) {
+	if (!table->arena) {
+		free(memory);
+	}
+}
 
-unsigned int default_hash_function(char *key);
-void _hash_table_item_free(hash_table_item *item);
-bool _initialize_buckets(ll_dlist **array, size_t item_count);
-bool _hash_table_grow(hash_table *table);
-hash_table *_hash_table_new_with_size(unsigned int size, unsigned int (*hash_function)(char *));
+/* Private: Stores a value in an item of a hash_table, copying it
+ *          into the item's storage if the table has a value size.
+ *
+ * table - The table the item belongs to.
+ * item - The item to store the value in.
+ * elem - The value, or for a table with a value size, a pointer to
+ *        the bytes of the value, or NULL to zero them.
+ *
+ * Returns nothing.
+ */
+static inline void _hash_table_item_store(hash_table *table, hash_table_item *item, void *elem) {
+	if (table->value_size == 0) {
+		item->value = elem;
+	} else if (elem != NULL) {
+		memmove(item->value, elem, table->value_size);
+	} else {
+		memset(item->value, 0, table->value_size);
+	}
+}
 
-/* Private: Hashes the provided key.
+/* Private: Fills in an item to be stored in a hash_table,
+ *          copying its key.
  *
- * key - The key to be hashed.
+ * table - The table the item belongs to.
+ * item - The item to fill in.
+ * elem - The item's value.
+ * key - The item's key.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ * release_function - A function to call when elem is removed
+ *                    from the table, or NULL to call no function.
  *
- * Returns the key's hash.
+ * Returns true if the key could be copied; otherwise, false is
+ * returned and the item is unchanged.
  */
-unsigned int default_hash_function(char *key) {
-	unsigned int hash = 0;
+bool _hash_table_item_init(hash_table *table, hash_table_item *item, void *elem, const void *key, size_t length, uint64_t hash, void (*release_function)(void *)) {
+	char *copy = _hash_table_alloc(table, _hash_table_key_size(table, length));
+	if (copy == NULL) {
+		return false;
+	}
+	
+	memcpy(copy, key, length);
+	copy[length] = '\0';
+	
+	item->key = copy;
+	item->value = (table->value_size > 0) ? copy + _hash_table_value_offset(length) : NULL;
+	_hash_table_item_store(table, item, elem);
+	item->release_function = release_function;
+	item->hash = hash;
+	item->key_length = length;
 	
-	char *i = key;
-	while (*i != '\0') {
-		hash += 3 * (*i) - 19;
-		i++;
+	if (release_function != NULL) {
+		table->releases_values = true;
 	}
 	
-	return hash;
+	return true;
 }
 
-/* Private: Frees an item in a hash_table.
+/* Private: Releases the value and key of an item in a hash_table,
+ *          without freeing the item itself.
  *
- * item - The item to free.
+ * table - The table the item belongs to.
+ * item - The item to release.
  *
  * Returns nothing.
  */
-void _hash_table_item_free(hash_table_item *item) {
+void _hash_table_item_release(hash_table *table, hash_table_item *item) {
 	if (item->release_function != NULL) {
 		item->release_function(item->value);
 	}
 	
-	free(item->key);
-	free(item);
+	_hash_table_dealloc(table, item->key);
 }
 
-/* Private: Initializes buckets for a hash table.
+/* Private: Copies every item of a hash_table into an array.
  *
- * array - The array of bucket lists to initialize.
- *         All contents are assumed to be NULL or freed.
- * item_count - The number of buckets to initialize.
+ * table - The table to copy the items of.
+ * items - An array with room for every item.
  *
- * Returns the new array, or NULL if it couldn't be created.
+ * Returns nothing.
  */
-bool _initialize_buckets(ll_dlist **array, size_t item_count) {
-	int i = 0;
-	for (i = 0; i < item_count; i++) {
-		array[i] = dll_new();
-		if (array[i] == NULL) {
-			int j = 0;
-			for (j = 0; j < i; j++) {
-				dll_free(array[j]);
+void _hash_table_collect_items(hash_table *table, hash_table_item *items) {
+	_hash_table_epoch_settle(table);
+	
+	if (table->small) {
+		_hash_table_small_collect(table, items);
+		return;
+	}
+	
+	if (table->layout == HASH_TABLE_FLAT) {
+		_hash_table_flat_collect(table, items);
+		return;
+	}
+	
+	if (table->layout == HASH_TABLE_ROBIN_HOOD) {
+		_hash_table_robin_hood_collect(table, items);
+		return;
+	}
+	
+	if (table->layout == HASH_TABLE_ORDERED) {
+		_hash_table_ordered_collect(table, items);
+		return;
+	}
+	
+	hash_table_node **buckets = table->items;
+	unsigned int bucket_count = table->bucket_count;
+	
+	while (buckets != NULL) {
+		unsigned int i = 0;
+		for (i = 0; i < bucket_count; i++) {
+			hash_table_node *node = NULL;
+			for (node = buckets[i]; node != NULL; node = node->next) {
+				*items++ = node->item;
+			}
+		}
+		
+		buckets = (buckets == table->items) ? table->old_items : NULL;
+		bucket_count = table->old_bucket_count;
+	}
+}
+
+/* Private: Frees the storage of a hash_table and the keys of its
+ *          items, without releasing their values, so the items
+ *          can be moved to other storage.
+ *
+ * table - The table to free the storage of.
+ * items - Every item of the table, from _hash_table_collect_items.
+ * count - The number of items.
+ *
+ * Returns nothing.
+ */
+void _hash_table_discard_storage(hash_table *table, hash_table_item *items, unsigned int count) {
+	unsigned int i = 0;
+	for (i = 0; i < count; i++) {
+		_hash_table_dealloc(table, items[i].key);
+	}
+	
+	hash_table_node **buckets = table->items;
+	unsigned int bucket_count = table->bucket_count;
+	
+	while (buckets != NULL) {
+		for (i = 0; i < bucket_count; i++) {
+			hash_table_node *node = buckets[i];
+			while (node != NULL) {
+				hash_table_node *next = node->next;
+				_hash_table_dealloc(table, node);
+				node = next;
 			}
-			
-			return false;
 		}
+		
+		buckets = (buckets == table->items) ? table->old_items : NULL;
+		bucket_count = table->old_bucket_count;
 	}
 	
-	return true;
+	free(table->items);
+	free(table->old_items);
+	free(table->control);
+	free(table->distances);
+	free(table->slots);
+	free(table->index);
+	_hash_table_arena_free(table);
+	
+	table->items = NULL;
+	table->old_items = NULL;
+	table->old_bucket_count = 0;
+	table->rehash_index = 0;
+	table->control = NULL;
+	table->distances = NULL;
+	table->slots = NULL;
+	table->index = NULL;
+	table->entry_count = 0;
+	table->entry_capacity = 0;
+	table->small = false;
+	table->arena = false;
 }
 
-/* Private: Increases the size of a hash table by a factor of 1.5.
- *          Copies all elements of the old table to a new one, then
- *          disposes of the old table.
+/* Private: Frees a node of a chained hash_table.
  *
- * table - The table to resize.
+ * table - The table the node belongs to.
+ * node - The node to free.
  *
- * Returns true if the resizing succeeded; otherwise, false is
- * returned and the table is unchanged.
+ * Returns nothing.
+ */
+void _hash_table_node_free(hash_table *table, hash_table_node *node) {
+	_hash_table_item_release(table, &node->item);
+	_hash_table_dealloc(table, node);
+}
+
+/* Private: Frees every node in an array of buckets.
+ *
+ * table - The table the buckets belong to.
+ * buckets - The buckets to clear.
+ * bucket_count - The number of buckets in the array.
+ *
+ * Returns nothing.
+ */
+void _hash_table_free_chains(hash_table *table, hash_table_node **buckets, unsigned int bucket_count) {
+	unsigned int i = 0;
+	for (i = 0; i < bucket_count; i++) {
+		hash_table_node *node = buckets[i];
+		while (node != NULL) {
+			hash_table_node *next = node->next;
+			_hash_table_node_free(table, node);
+			node = next;
+		}
+	}
+}
+
+/* Private: Finds the node holding a key in a chained table,
+ *          searching both bucket arrays during a resize.
+ *
+ * table - The table to search.
+ * key - The key to look for.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ *
+ * Returns the key's node, or NULL if it isn't in the table.
  */
-bool _hash_table_grow(hash_table *table) {
-	ll_dlist **list = table->items;
+hash_table_node *_hash_table_find(hash_table *table, const void *key, size_t length, uint64_t hash) {
+	HASH_TABLE_COUNT(table, searches, 1);
 	
-	unsigned int new_size = ceil(((double)table->bucket_count) * 1.5);
-	unsigned int old_size = table->bucket_count;
+	_hash_table_epoch_touch(table, hash & (table->bucket_count - 1));
+	hash_table_node *node = table->items[hash & (table->bucket_count - 1)];
+	while (node != NULL) {
+		HASH_TABLE_COUNT(table, comparisons, 1);
+		if (_hash_table_item_matches(&node->item, key, length, hash)) {
+			return node;
+		}
+		
+		node = node->next;
+	}
 	
-	ll_dlist **new_items = calloc(new_size, BUCKET_SIZE);
-	if (new_items == NULL) {
-		return false;
+	if (table->old_items != NULL) {
+		unsigned int index = hash & (table->old_bucket_count - 1);
+		if (index >= table->rehash_index) {
+			node = table->old_items[index];
+			while (node != NULL) {
+				HASH_TABLE_COUNT(table, comparisons, 1);
+				if (_hash_table_item_matches(&node->item, key, length, hash)) {
+					return node;
+				}
+				
+				node = node->next;
+			}
+		}
 	}
 	
-	if (!_initialize_buckets(new_items, new_size)) {
-		free(new_items);
+	return NULL;
+}
+
+/* Private: Unlinks the node holding a key from a bucket's chain.
+ *
+ * buckets - The bucket array to search.
+ * index - The index of the key's bucket.
+ * key - The key to look for.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ *
+ * Returns the unlinked node, or NULL if it isn't in the bucket.
+ */
+hash_table_node *_hash_table_unlink(hash_table_node **buckets, unsigned int index, const void *key, size_t length, uint64_t hash) {
+	hash_table_node **link = &buckets[index];
+	while (*link != NULL) {
+		hash_table_node *node = *link;
+		if (_hash_table_item_matches(&node->item, key, length, hash)) {
+			*link = node->next;
+			return node;
+		}
 		
-		return false;
+		link = &node->next;
 	}
 	
-	table->items = new_items;
-	table->bucket_count = new_size;
-	table->length = 0;
+	return NULL;
+}
+
+/* Private: Moves buckets of a resizing chained table from its old
+ *          bucket array to its new one, in order, and frees the old
+ *          array once the last bucket has been moved.
+ *
+ * table - The table being resized.
+ * steps - The maximum number of non-empty buckets to move. At most
+ *         REHASH_EMPTY_VISITS empty buckets are skipped for each.
+ *
+ * Returns nothing.
+ */
+void _hash_table_rehash_step(hash_table *table, unsigned int steps) {
+	unsigned int empty_visits = steps * REHASH_EMPTY_VISITS;
+	if (empty_visits / REHASH_EMPTY_VISITS != steps) {
+		empty_visits = UINT_MAX;
+	}
 	
-	int i = 0;
-	for (i = 0; i < old_size; i++) {
-		ll_dlist *bucket = list[i];
-		if (bucket->length == 0) {
+	while (steps > 0 && table->rehash_index < table->old_bucket_count) {
+		hash_table_node *node = table->old_items[table->rehash_index];
+		table->old_items[table->rehash_index] = NULL;
+		table->rehash_index++;
+		
+		if (node == NULL) {
+			if (--empty_visits == 0) {
+				break;
+			}
+			
 			continue;
 		}
 		
-		ll_delement *elem = bucket->first;
+		table->occupied_buckets--;
+		steps--;
 		
-		while (elem != NULL) {
-			hash_table_item *item = elem->data;
-			hash_table_set(table, item->value, item->key, item->release_function);
-			
-			free(item->key);
-			free(item);
+		while (node != NULL) {
+			hash_table_node *next = node->next;
 			
-			ll_delement *next = elem->next;
+			unsigned int index = node->item.hash & (table->bucket_count - 1);
+			if (table->items[index] == NULL) {
+				table->occupied_buckets++;
+			}
 			
-			free(elem);
+			node->next = table->items[index];
+			table->items[index] = node;
 			
-			elem = next;
+			node = next;
+		}
+	}
+	
+	if (table->rehash_index >= table->old_bucket_count) {
+		free(table->old_items);
+		table->old_items = NULL;
+		table->old_bucket_count = 0;
+		table->rehash_index = 0;
+	}
+}
+
+/* Private: Gets the values of a batch of keys in a chained table.
+ *          Each pass over the batch prefetches what the next pass
+ *          reads for every key, so the cache misses of the whole
+ *          batch overlap instead of being taken one at a time:
+ *          first each key's bucket, then the first node of its
+ *          chain, then that node's key.
+ *
+ * table - The table to get the values from.
+ * keys - The keys to get the values of.
+ * lengths - The length of each key in bytes.
+ * hashes - The hash of each key, from _hash_table_hash.
+ * count - The number of keys, at most HASH_TABLE_BATCH_SIZE.
+ * values - Set to the value of each key, or NULL for keys that
+ *          couldn't be found.
+ *
+ * Returns nothing.
+ */
+void _hash_table_get_many(hash_table *table, const void **keys, const size_t *lengths, const uint64_t *hashes, size_t count, void **values) {
+	unsigned int mask = table->bucket_count - 1;
+	hash_table_node *heads[HASH_TABLE_BATCH_SIZE];
+	
+	size_t i = 0;
+	for (i = 0; i < count; i++) {
+		__builtin_prefetch(&table->items[hashes[i] & mask]);
+	}
+	
+	for (i = 0; i < count; i++) {
+		_hash_table_epoch_touch(table, hashes[i] & mask);
+		heads[i] = table->items[hashes[i] & mask];
+		if (heads[i] != NULL) {
+			__builtin_prefetch(heads[i]);
+		}
+	}
+	
+	for (i = 0; i < count; i++) {
+		if (heads[i] != NULL && heads[i]->item.hash == hashes[i]) {
+			__builtin_prefetch(heads[i]->item.key);
 		}
 	}
 	
-	free(list);
+	for (i = 0; i < count; i++) {
+		hash_table_node *node = _hash_table_find(table, keys[i], lengths[i], hashes[i]);
+		values[i] = (node != NULL) ? node->item.value : NULL;
+	}
+}
+
+/* Private: Gets the number of buckets a table needs to hold a
+ *          number of items without growing.
+ *
+ * layout - The layout of the table.
+ * capacity - The number of items the table should hold.
+ *
+ * Returns the number of buckets, which is a power of two and
+ * at least INITIAL_SIZE.
+ */
+unsigned int _hash_table_size_for_capacity(hash_table_layout layout, unsigned int capacity) {
+	if (layout == HASH_TABLE_FLAT) {
+		return _hash_table_flat_size_for_capacity(capacity);
+	}
+	
+	if (layout == HASH_TABLE_ROBIN_HOOD) {
+		return _hash_table_robin_hood_size_for_capacity(capacity);
+	}
+	
+	if (layout == HASH_TABLE_ORDERED) {
+		return _hash_table_ordered_size_for_capacity(capacity);
+	}
+	
+	unsigned int size = INITIAL_SIZE;
+	while (((double)capacity) / ((double)size) >= MAX_LOAD_FACTOR) {
+		size *= 2;
+	}
+	
+	return size;
+}
+
+/* Private: Moves the items of a chained table into a new bucket
+ *          array. Incremental resizes keep the old bucket array
+ *          alongside the new one and move its items over in later
+ *          calls; otherwise, every item is moved before returning.
+ *
+ * table - The table to resize.
+ * size - The number of buckets in the new array, which must be
+ *        a power of two.
+ * incremental - Whether to resize incrementally.
+ *
+ * Returns true if the resizing succeeded; otherwise, false is
+ * returned and the table is unchanged.
+ */
+bool _hash_table_resize(hash_table *table, unsigned int size, bool incremental) {
+	HASH_TABLE_RESIZE_START();
+	_hash_table_epoch_settle(table);
+	
+	if (table->old_items != NULL) {
+		_hash_table_rehash_step(table, UINT_MAX);
+	}
+	
+	hash_table_node **new_items = calloc(size, BUCKET_SIZE);
+	if (new_items == NULL) {
+		return false;
+	}
+	
+	table->old_items = table->items;
+	table->old_bucket_count = table->bucket_count;
+	table->rehash_index = 0;
+	
+	table->items = new_items;
+	table->bucket_count = size;
+	
+	if (!incremental) {
+		_hash_table_rehash_step(table, UINT_MAX);
+	}
+	
+	HASH_TABLE_RESIZE_END(table);
 	
 	return true;
 }
 
 /* Private: Creates a new hash table with the specified
- *          number of buckets and hash function.
+ *          number of buckets and options.
  *
  * size - The number of buckets to be included in the new
- *        hash table.
- * hash_function - The hash function to use for the new
- *                 hash table.
+ *        hash table, which must be a power of two.
+ * options - The options to build the new hash table with.
  *
  * Returns the new hash table, or NULL if it couldn't be created.
  */
-hash_table *_hash_table_new_with_size(unsigned int size, unsigned int (*hash_function)(char *)) {
+hash_table *_hash_table_new_with_size(unsigned int size, const hash_table_options *options) {
+	hash_table_layout layout = options->layout;
+	
 	hash_table *table = malloc(sizeof(hash_table));
 	if (table == NULL) {
 		return NULL;
 	}
 	
+	if (options->hash == HASH_TABLE_HASH_KEYED) {
+		table->hash_function = &hash_keyed;
+		table->seed = hash_random_seed();
+	} else {
+		table->hash_function = &hash_fast;
+		table->seed = 0;
+	}
+	
+	table->layout = layout;
+	table->incremental_resize = options->incremental_resize;
+	table->value_size = options->value_size;
+	table->length = 0;
+	table->items = NULL;
+	table->old_items = NULL;
+	table->old_bucket_count = 0;
+	table->rehash_index = 0;
+	table->control = NULL;
+	table->slots = NULL;
+	table->distances = NULL;
+	table->epochs = NULL;
+	table->epoch = 0;
+	table->index = NULL;
+	table->index_width = 0;
+	table->entry_count = 0;
+	table->entry_capacity = 0;
+	table->frozen = NULL;
+	table->small = layout != HASH_TABLE_FROZEN && options->capacity <= HASH_TABLE_SMALL_SIZE;
+	memset(table->small_tags, 0, sizeof(table->small_tags));
+	table->arena = options->arena;
+	table->slabs = NULL;
+	table->releases_values = false;
+	table->filter = NULL;
+	table->filter_pending = false;
+	
+#ifdef HASH_TABLE_STATS
+	memset(&table->counters, 0, sizeof(table->counters));
+#endif
+	
+	if (table->small) {
+		table->bucket_count = 0;
+		table->min_bucket_count = size;
+		table->occupied_buckets = 0;
+		
+		return table;
+	}
+	
+	if (layout == HASH_TABLE_FLAT) {
+		if (!_hash_table_flat_init(table, size)) {
+			free(table);
+			return NULL;
+		}
+		
+		table->min_bucket_count = table->bucket_count;
+		
+		return table;
+	}
+	
+	if (layout == HASH_TABLE_ROBIN_HOOD) {
+		if (!_hash_table_robin_hood_init(table, size)) {
+			free(table);
+			return NULL;
+		}
+		
+		table->min_bucket_count = table->bucket_count;
+		
+		return table;
+	}
+	
+	if (layout == HASH_TABLE_ORDERED) {
+		if (!_hash_table_ordered_init(table, size)) {
+			free(table);
+			return NULL;
+		}
+		
+		table->min_bucket_count = table->bucket_count;
+		
+		return table;
+	}
+	
 	table->items = calloc(size, BUCKET_SIZE);
 	if (table->items == NULL) {
 		free(table);
@@ -163,15 +622,8 @@ hash_table *_hash_table_new_with_size(unsigned int size, unsigned int (*hash_fun
 	}
 	
 	table->bucket_count = size;
+	table->min_bucket_count = size;
 	table->occupied_buckets = 0;
-	table->length = 0;
-	table->hash_function = hash_function;
-	
-	if (!_initialize_buckets(table->items, size)) {
-		free(table->items);
-		free(table);
-		return NULL;
-	}
 	
 	return table;
 }
@@ -181,109 +633,1287 @@ hash_table *_hash_table_new_with_size(unsigned int size, unsigned int (*hash_fun
  * Returns the new hash table, or NULL if it couldn't be created.
  */
 hash_table *hash_table_new() {
-	return _hash_table_new_with_size(INITIAL_SIZE, &default_hash_function);
+	hash_table_options options = { 0 };
+	
+	return _hash_table_new_with_size(INITIAL_SIZE, &options);
 }
 
-/* Public: Sets the value of a key in a hash table, resizing
- *         the table to maintain an appropriate load factor
- *         if necessary.
+/* Public: Creates a new hash table sized to hold a number
+ *         of items without resizing.
  *
- * table - The table to set the value in.
- * key - The key to set the value of.
- * elem - The element to set as the value of key.
- * release_function - A function to call when elem is removed
- *                    from the table, or NULL to call no function.
+ * capacity - The number of items the table should hold.
  *
- * Returns true if the element was added successfully;
- * otherwise, false is returned and the table is unchanged.
+ * Returns the new hash table, or NULL if it couldn't be created.
  */
-bool hash_table_set(hash_table *table, void *elem, char *key, void (*release_function)(void *)) {
-	int index = table->hash_function(key) % table->bucket_count;
-	ll_dlist *bucket = table->items[index];
-	unsigned int item_count = bucket->length;
-	
-	hash_table_item *item = NULL;
-	if (item_count != 0) {
-		hash_table_item *curr = NULL;
-		int i = 0;
-		for (i = 0; i < item_count; i++) {
-			curr = dll_get(bucket, i);
-			if (strcmp(key, curr->key) == 0) {
-				item = curr;
-				break;
-			}
-		}
-	} else {
-		table->occupied_buckets++;
-		if (((double)table->occupied_buckets) / ((double)table->bucket_count) >= 0.67) {
-			_hash_table_grow(table);
-			return hash_table_set(table, elem, key, release_function);
-		}
-	}
-	
-	if (item == NULL) {
-		item = malloc(sizeof(hash_table_item));
-		if (item == NULL) {
-			return false;
-		}
-		
-		item->key = malloc(strlen(key)*sizeof(char));
-		if (item->key == NULL) {
-			free(item);
-			return false;
-		}
-		
-		item->key = strcpy(item->key, key);
-		item->value = elem;
-		item->release_function = release_function;
-		
-		return dll_insert(bucket, item, item_count, (void (*)(void *))_hash_table_item_free);
-	} else {
-		item->value = elem;
-	}
-	
-	table->length++;
+hash_table *hash_table_new_with_capacity(unsigned int capacity) {
+	hash_table_options options = { .capacity = capacity };
 	
-	return true;
+	return hash_table_new_with_options(&options);
 }
 
-/* Public: Gets the value of a key in a hash table.
+/* Public: Creates a new hash table whose values are copied into
+ *         it, each stored next to its key. A value is set by
+ *         passing a pointer to its bytes, and getting a key gives a
+ *         pointer to the table's copy, which stays valid until the
+ *         key is removed or the table is compacted or frozen, so
+ *         values of a few bytes need no allocation of their own.
  *
- * table - The table to get the value from.
- * key - The key to get the value of.
+ * value_size - The size of each value in bytes.
  *
- * Returns the value of key in table, or NULL if
- * the element couldn't be found.
+ * Returns the new hash table, or NULL if it couldn't be created.
  */
-void *hash_table_get(hash_table *table, char *key) {
-	unsigned int index = table->hash_function(key) % table->bucket_count;
-	ll_dlist *bucket = table->items[index];
-	unsigned int item_count = bucket->length;
+hash_table *hash_table_new_with_value_size(size_t value_size) {
+	hash_table_options options = { .value_size = value_size };
 	
-	int i = 0;
-	for (i = 0; i < item_count; i++) {
-		hash_table_item *item = dll_get(bucket, i);
-		if (strcmp(key, item->key) == 0) {
-			return item->value;
-		}
-	}
+	return hash_table_new_with_options(&options);
+}
+
+/* Public: Creates a new hash table with the specified options.
+ *
+ * options - The options to use for the new table. Fields left
+ *           zeroed take their default values, so a zeroed
+ *           struct gives the same table as hash_table_new.
+ *
+ * Returns the new hash table, or NULL if it couldn't be created.
+ */
+hash_table *hash_table_new_with_options(const hash_table_options *options) {
+	unsigned int size = _hash_table_size_for_capacity(options->layout, options->capacity);
 	
-	return NULL;
+	return _hash_table_new_with_size(size, options);
 }
 
-/* Public: Clears and frees memory associated with a hash table.
+/* Public: Grows a hash table, if needed, so that it can hold a
+ *         number of items without resizing again. Any resizing
+ *         is done before returning, even for tables that
+ *         otherwise resize incrementally.
  *
- * table - The table to free.
+ * table - The table to grow.
+ * capacity - The number of items the table should hold.
  *
- * Returns nothing.
+ * Returns true if the table can hold capacity items; otherwise,
+ * false is returned and the table is unchanged.
  */
-void hash_table_free(hash_table *table) {
-	int i = 0;
-	for (i = 0; i < table->bucket_count; i++) {
-		dll_clear(table->items[i]);
-		dll_free(table->items[i]);
+bool hash_table_reserve(hash_table *table, unsigned int capacity) {
+	if (table->small) {
+		return capacity <= HASH_TABLE_SMALL_SIZE || _hash_table_small_grow(table, capacity);
 	}
 	
-	free(table->items);
+	unsigned int size = _hash_table_size_for_capacity(table->layout, capacity);
+	if (size <= table->bucket_count) {
+		return true;
+	}
+	
+	if (table->layout == HASH_TABLE_FLAT) {
+		return _hash_table_flat_resize(table, size);
+	}
+	
+	if (table->layout == HASH_TABLE_ROBIN_HOOD) {
+		return _hash_table_robin_hood_resize(table, size);
+	}
+	
+	if (table->layout == HASH_TABLE_ORDERED) {
+		return _hash_table_ordered_resize(table, size);
+	}
+	
+	if (table->layout == HASH_TABLE_FROZEN) {
+		return false;
+	}
+	
+	return _hash_table_resize(table, size, false);
+}
+
+/* Public: Sets the value of a key in a hash table, resizing
+ *         the table to maintain an appropriate load factor
+ *         if necessary.
+ *
+ * table - The table to set the value in.
+ * key - The key to set the value of.
+ * elem - The element to set as the value of key, or for a table
+ *        with a value size, a pointer to the bytes to copy.
+ * release_function - A function to call when elem is removed
+ *                    from the table, or NULL to call no function.
+ *
+ * Returns true if the element was added successfully;
+ * otherwise, false is returned and the table is unchanged.
+ */
+bool hash_table_set(hash_table *table, void *elem, char *key, void (*release_function)(void *)) {
+	return hash_table_set_bytes(table, elem, key, strlen(key), release_function);
+}
+
+/* Private: Sets the value of a key in a hash table, resizing
+ *          the table if necessary, without updating its filter.
+ *
+ * table - The table to set the value in.
+ * elem - The element to set as the value of key.
+ * key - The key to set the value of.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ * release_function - A function to call when elem is removed
+ *                    from the table, or NULL to call no function.
+ *
+ * Returns true if the element was added successfully;
+ * otherwise, false is returned and the table is unchanged.
+ */
+bool _hash_table_set(hash_table *table, void *elem, const void *key, size_t length, uint64_t hash, void (*release_function)(void *)) {
+	bool inserted = false;
+	
+	hash_table_item *item = _hash_table_insert(table, key, length, hash, &inserted);
+	if (item == NULL) {
+		return false;
+	}
+	
+	_hash_table_item_store(table, item, elem);
+	
+	if (inserted && release_function != NULL) {
+		item->release_function = release_function;
+		table->releases_values = true;
+	}
+	
+	return true;
+}
+
+/* Private: Finds the item of a key in a hash table, adding it
+ *          with a NULL value if it isn't there and resizing the
+ *          table if necessary, without updating its filter.
+ *
+ * table - The table to find the key in.
+ * key - The key to find.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ * inserted - Set to whether the key was added.
+ *
+ * Returns the key's item, or NULL if it couldn't be added, in
+ * which case the table is unchanged.
+ */
+hash_table_item *_hash_table_insert(hash_table *table, const void *key, size_t length, uint64_t hash, bool *inserted) {
+	*inserted = false;
+	
+	if (table->small) {
+		hash_table_item *item = _hash_table_small_insert(table, key, length, inserted);
+		if (item != NULL || table->length < HASH_TABLE_SMALL_SIZE) {
+			return item;
+		}
+		
+		if (!_hash_table_small_grow(table, HASH_TABLE_SMALL_SIZE + 1)) {
+			return NULL;
+		}
+		
+		hash = _hash_table_hash(table, key, length);
+	}
+	
+	if (table->layout == HASH_TABLE_FLAT) {
+		return _hash_table_flat_insert(table, key, length, hash, inserted);
+	}
+	
+	if (table->layout == HASH_TABLE_ROBIN_HOOD) {
+		return _hash_table_robin_hood_insert(table, key, length, hash, inserted);
+	}
+	
+	if (table->layout == HASH_TABLE_ORDERED) {
+		return _hash_table_ordered_insert(table, key, length, hash, inserted);
+	}
+	
+	if (table->layout == HASH_TABLE_FROZEN) {
+		return NULL;
+	}
+	
+	if (table->old_items != NULL) {
+		_hash_table_rehash_step(table, REHASH_STEP);
+	}
+	
+	hash_table_node *node = _hash_table_find(table, key, length, hash);
+	if (node != NULL) {
+		return &node->item;
+	}
+	
+	if (((double)table->length + 1) / ((double)table->bucket_count) >= MAX_LOAD_FACTOR) {
+		_hash_table_resize(table, table->bucket_count * 2, table->incremental_resize);
+	}
+	
+	node = _hash_table_alloc(table, sizeof(hash_table_node));
+	if (node == NULL) {
+		return NULL;
+	}
+	
+	if (!_hash_table_item_init(table, &node->item, NULL, key, length, hash, NULL)) {
+		_hash_table_dealloc(table, node);
+		return NULL;
+	}
+	
+	unsigned int index = hash & (table->bucket_count - 1);
+	if (table->items[index] == NULL) {
+		table->occupied_buckets++;
+	}
+	
+	node->next = table->items[index];
+	table->items[index] = node;
+	
+	table->length++;
+	*inserted = true;
+	
+	return &node->item;
+}
+
+/* Public: Sets the value of a key of arbitrary bytes in a hash
+ *         table, resizing the table to maintain an appropriate
+ *         load factor if necessary. The key may contain zero
+ *         bytes, and is copied into the table with a terminating
+ *         zero byte added.
+ *
+ * table - The table to set the value in.
+ * elem - The element to set as the value of key, or for a table
+ *        with a value size, a pointer to the bytes to copy.
+ * key - The key to set the value of.
+ * length - The length of the key in bytes.
+ * release_function - A function to call when elem is removed
+ *                    from the table, or NULL to call no function.
+ *
+ * Returns true if the element was added successfully;
+ * otherwise, false is returned and the table is unchanged.
+ */
+bool hash_table_set_bytes(hash_table *table, void *elem, const void *key, size_t length, void (*release_function)(void *)) {
+	uint64_t hash = table->small ? 0 : _hash_table_hash(table, key, length);
+	unsigned int old_length = table->length;
+	
+	if (!_hash_table_set(table, elem, key, length, hash, release_function)) {
+		return false;
+	}
+	
+	if ((table->filter != NULL || table->filter_pending) && table->length > old_length) {
+		_hash_table_filter_add(table, hash);
+	}
+	
+	return true;
+}
+
+/* Public: Finds the value of a key in a hash table, adding the
+ *         key with a NULL value if it isn't there, so that a value
+ *         can be read and then changed in place with one lookup.
+ *         Added keys have no release function.
+ *
+ * table - The table to find the key in.
+ * key - The key to find.
+ * inserted - Set to whether the key was added, or NULL.
+ *
+ * Returns a pointer to the key's value, which stays valid until
+ * the table is next changed, or NULL if the key couldn't be
+ * added. In a table with a value size, the value is a pointer to
+ * the table's copy, zeroed if the key was added.
+ */
+void **hash_table_get_or_insert(hash_table *table, char *key, bool *inserted) {
+	return hash_table_get_or_insert_bytes(table, key, strlen(key), inserted);
+}
+
+/* Public: Finds the value of a key of arbitrary bytes in a hash
+ *         table, adding the key with a NULL value if it isn't
+ *         there. Added keys have no release function.
+ *
+ * table - The table to find the key in.
+ * key - The key to find.
+ * length - The length of the key in bytes.
+ * inserted - Set to whether the key was added, or NULL.
+ *
+ * Returns a pointer to the key's value, which stays valid until
+ * the table is next changed, or NULL if the key couldn't be
+ * added.
+ */
+void **hash_table_get_or_insert_bytes(hash_table *table, const void *key, size_t length, bool *inserted) {
+	uint64_t hash = table->small ? 0 : _hash_table_hash(table, key, length);
+	bool added = false;
+	
+	hash_table_item *item = _hash_table_insert(table, key, length, hash, &added);
+	if (item == NULL) {
+		return NULL;
+	}
+	
+	if (added && (table->filter != NULL || table->filter_pending)) {
+		_hash_table_filter_add(table, hash);
+	}
+	
+	HASH_TABLE_COUNT(table, gets, 1);
+	HASH_TABLE_COUNT(table, hits, !added);
+	
+	if (inserted != NULL) {
+		*inserted = added;
+	}
+	
+	return &item->value;
+}
+
+/* Public: Gets the value of a key in a hash table.
+ *
+ * table - The table to get the value from.
+ * key - The key to get the value of.
+ *
+ * Returns the value of key in table, or for a table with a value
+ * size, a pointer to the table's copy of it, or NULL if the
+ * element couldn't be found.
+ */
+void *hash_table_get(hash_table *table, char *key) {
+	return hash_table_get_bytes(table, key, strlen(key));
+}
+
+/* Public: Gets the value of a key of arbitrary bytes in a hash
+ *         table.
+ *
+ * table - The table to get the value from.
+ * key - The key to get the value of.
+ * length - The length of the key in bytes.
+ *
+ * Returns the value of key in table, or for a table with a value
+ * size, a pointer to the table's copy of it, or NULL if the
+ * element couldn't be found.
+ */
+void *hash_table_get_bytes(hash_table *table, const void *key, size_t length) {
+	return _hash_table_get(table, key, length, table->small ? 0 : _hash_table_hash(table, key, length));
+}
+
+/* Private: Gets the value of a key in a hash table whose hash is
+ *          already known.
+ *
+ * table - The table to get the value from.
+ * key - The key to get the value of.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ *
+ * Returns the value of key in table, or NULL if
+ * the element couldn't be found.
+ */
+void *_hash_table_get(hash_table *table, const void *key, size_t length, uint64_t hash) {
+	void *value = NULL;
+	
+	if (table->small) {
+		value = _hash_table_small_get(table, key, length);
+	} else if (table->filter != NULL && !cuckoo_filter_contains_hash(table->filter, hash)) {
+		value = NULL;
+	} else if (table->layout == HASH_TABLE_FLAT) {
+		value = _hash_table_flat_get(table, key, length, hash);
+	} else if (table->layout == HASH_TABLE_ROBIN_HOOD) {
+		value = _hash_table_robin_hood_get(table, key, length, hash);
+	} else if (table->layout == HASH_TABLE_ORDERED) {
+		value = _hash_table_ordered_get(table, key, length, hash);
+	} else if (table->layout == HASH_TABLE_FROZEN) {
+		value = _hash_table_frozen_get(table, key, length, hash);
+	} else {
+		if (table->old_items != NULL) {
+			_hash_table_rehash_step(table, REHASH_STEP);
+		}
+		
+		hash_table_node *node = _hash_table_find(table, key, length, hash);
+		if (node != NULL) {
+			value = node->item.value;
+		}
+	}
+	
+	HASH_TABLE_COUNT(table, gets, 1);
+	HASH_TABLE_COUNT(table, hits, value != NULL);
+	
+	return value;
+}
+
+/* Public: Gets the values of many keys in a hash table at once.
+ *         This is faster than calling hash_table_get for each key
+ *         when the table is much larger than the CPU's caches,
+ *         since the lookups of several keys are overlapped.
+ *
+ * table - The table to get the values from.
+ * keys - The keys to get the values of.
+ * count - The number of keys.
+ * values - An array of count values, each set to the value of
+ *          the key at the same index, or NULL if the key couldn't
+ *          be found.
+ *
+ * Returns nothing.
+ */
+void hash_table_get_many(hash_table *table, char **keys, size_t count, void **values) {
+	size_t lengths[HASH_TABLE_BATCH_SIZE];
+	uint64_t hashes[HASH_TABLE_BATCH_SIZE];
+	
+	size_t start = 0;
+	for (start = 0; start < count; start += HASH_TABLE_BATCH_SIZE) {
+		size_t batch = count - start;
+		if (batch > HASH_TABLE_BATCH_SIZE) {
+			batch = HASH_TABLE_BATCH_SIZE;
+		}
+		
+		size_t i = 0;
+		for (i = start + batch; i < count && i < start + 2 * HASH_TABLE_BATCH_SIZE; i++) {
+			__builtin_prefetch(keys[i]);
+		}
+		
+		if (table->small) {
+			for (i = 0; i < batch; i++) {
+				values[start + i] = _hash_table_small_get(table, keys[start + i], strlen(keys[start + i]));
+			}
+			
+			continue;
+		}
+		
+		for (i = 0; i < batch; i++) {
+			lengths[i] = strlen(keys[start + i]);
+			hashes[i] = _hash_table_hash(table, keys[start + i], lengths[i]);
+		}
+		
+		if (table->layout == HASH_TABLE_FLAT) {
+			_hash_table_flat_get_many(table, (const void **)(keys + start), lengths, hashes, batch, values + start);
+			continue;
+		}
+		
+		if (table->layout == HASH_TABLE_ROBIN_HOOD) {
+			_hash_table_robin_hood_get_many(table, (const void **)(keys + start), lengths, hashes, batch, values + start);
+			continue;
+		}
+		
+		if (table->layout == HASH_TABLE_ORDERED) {
+			_hash_table_ordered_get_many(table, (const void **)(keys + start), lengths, hashes, batch, values + start);
+			continue;
+		}
+		
+		if (table->layout == HASH_TABLE_FROZEN) {
+			_hash_table_frozen_get_many(table, (const void **)(keys + start), lengths, hashes, batch, values + start);
+			continue;
+		}
+		
+		if (table->old_items != NULL) {
+			_hash_table_rehash_step(table, REHASH_STEP);
+		}
+		
+		_hash_table_get_many(table, (const void **)(keys + start), lengths, hashes, batch, values + start);
+	}
+	
+#ifdef HASH_TABLE_STATS
+	size_t i = 0;
+	for (i = 0; i < count; i++) {
+		HASH_TABLE_COUNT(table, gets, 1);
+		HASH_TABLE_COUNT(table, hits, values[i] != NULL);
+	}
+#endif
+}
+
+/* Private: Removes a key from a hash table, calling the release
+ *          function of its value, without shrinking the table.
+ *
+ * table - The table to remove the key from.
+ * key - The key to remove.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ *
+ * Returns true if the key was found and removed.
+ */
+bool _hash_table_remove(hash_table *table, const void *key, size_t length, uint64_t hash) {
+	if (table->small) {
+		return _hash_table_small_remove(table, key, length);
+	}
+	
+	if (table->layout == HASH_TABLE_FLAT) {
+		return _hash_table_flat_remove(table, key, length, hash);
+	}
+	
+	if (table->layout == HASH_TABLE_ROBIN_HOOD) {
+		return _hash_table_robin_hood_remove(table, key, length, hash);
+	}
+	
+	if (table->layout == HASH_TABLE_ORDERED) {
+		return _hash_table_ordered_remove(table, key, length, hash);
+	}
+	
+	if (table->layout == HASH_TABLE_FROZEN) {
+		return false;
+	}
+	
+	if (table->old_items != NULL) {
+		_hash_table_rehash_step(table, REHASH_STEP);
+	}
+	
+	hash_table_node **buckets = table->items;
+	unsigned int index = hash & (table->bucket_count - 1);
+	_hash_table_epoch_touch(table, index);
+	hash_table_node *node = _hash_table_unlink(buckets, index, key, length, hash);
+	
+	if (node == NULL && table->old_items != NULL) {
+		buckets = table->old_items;
+		index = hash & (table->old_bucket_count - 1);
+		if (index >= table->rehash_index) {
+			node = _hash_table_unlink(buckets, index, key, length, hash);
+		}
+	}
+	
+	if (node == NULL) {
+		return false;
+	}
+	
+	if (buckets[index] == NULL) {
+		table->occupied_buckets--;
+	}
+	
+	_hash_table_node_free(table, node);
+	table->length--;
+	
+	return true;
+}
+
+/* Private: Shrinks a table once a quarter of its buckets could
+ *          hold all of its items. It shrinks to twice the number
+ *          of buckets its items need, leaving it about half as
+ *          full as it may get, so its length must roughly double
+ *          before it grows again or halve before it shrinks again.
+ *          Tables don't shrink below the size they were created
+ *          with, or while a chained table is being resized. If
+ *          the new storage can't be allocated, the table is left
+ *          as it is.
+ *
+ * table - The table to shrink.
+ *
+ * Returns nothing.
+ */
+void _hash_table_shrink(hash_table *table) {
+	if (table->small || table->bucket_count <= table->min_bucket_count || table->old_items != NULL) {
+		return;
+	}
+	
+	unsigned int size = _hash_table_size_for_capacity(table->layout, table->length);
+	if (size > table->bucket_count / 4) {
+		return;
+	}
+	
+	size *= 2;
+	if (size < table->min_bucket_count) {
+		size = table->min_bucket_count;
+	}
+	
+	if (table->layout == HASH_TABLE_FLAT) {
+		_hash_table_flat_resize(table, size);
+	} else if (table->layout == HASH_TABLE_ROBIN_HOOD) {
+		_hash_table_robin_hood_resize(table, size);
+	} else if (table->layout == HASH_TABLE_ORDERED) {
+		_hash_table_ordered_resize(table, size);
+	} else {
+		_hash_table_resize(table, size, table->incremental_resize);
+	}
+}
+
+/* Public: Removes a key from a hash table, calling the release
+ *         function of its value. The table shrinks once it is
+ *         sparse enough; see _hash_table_shrink.
+ *
+ * table - The table to remove the key from.
+ * key - The key to remove.
+ *
+ * Returns true if the key was found and removed.
+ */
+bool hash_table_remove(hash_table *table, char *key) {
+	return hash_table_remove_bytes(table, key, strlen(key));
+}
+
+/* Public: Removes a key of arbitrary bytes from a hash table,
+ *         calling the release function of its value. The table
+ *         shrinks once it is sparse enough; see _hash_table_shrink.
+ *
+ * table - The table to remove the key from.
+ * key - The key to remove.
+ * length - The length of the key in bytes.
+ *
+ * Returns true if the key was found and removed.
+ */
+bool hash_table_remove_bytes(hash_table *table, const void *key, size_t length) {
+	uint64_t hash = table->small ? 0 : _hash_table_hash(table, key, length);
+	
+	if (!_hash_table_remove(table, key, length, hash)) {
+		return false;
+	}
+	
+	if (table->filter != NULL) {
+		cuckoo_filter_remove_hash(table->filter, hash);
+	}
+	
+	_hash_table_shrink(table);
+	
+	return true;
+}
+
+/* Private: Empties a run of the slots of a hash table by resetting
+ *          their metadata, without looking at their items.
+ *
+ * table - The table to change, which must not be small or frozen.
+ * start - The index of the first slot.
+ * count - The number of slots.
+ *
+ * Returns nothing.
+ */
+void _hash_table_reset_slots(hash_table *table, unsigned int start, unsigned int count) {
+	if (table->layout == HASH_TABLE_FLAT) {
+		_hash_table_flat_reset(table, start, count);
+	} else if (table->layout == HASH_TABLE_ROBIN_HOOD) {
+		_hash_table_robin_hood_reset(table, start, count);
+	} else if (table->layout == HASH_TABLE_ORDERED) {
+		_hash_table_ordered_reset(table, start, count);
+	} else {
+		memset(table->items + start, 0, count * BUCKET_SIZE);
+	}
+}
+
+/* Private: Resets the chunk of a cleared table holding a slot, and
+ *          marks it as current.
+ *
+ * table - The table the slot belongs to.
+ * slot - The index of the slot.
+ *
+ * Returns nothing.
+ */
+void _hash_table_epoch_refresh(hash_table *table, size_t slot) {
+	size_t chunk = slot >> HASH_TABLE_EPOCH_SHIFT;
+	unsigned int start = chunk << HASH_TABLE_EPOCH_SHIFT;
+	unsigned int count = table->bucket_count - start;
+	if (count > (1U << HASH_TABLE_EPOCH_SHIFT)) {
+		count = 1U << HASH_TABLE_EPOCH_SHIFT;
+	}
+	
+	_hash_table_reset_slots(table, start, count);
+	table->epochs[chunk] = table->epoch;
+}
+
+/* Private: Resets every chunk of a cleared table that is still
+ *          stale, so its metadata can be read without
+ *          _hash_table_epoch_touch, as it must be before the table
+ *          is resized or walked in full.
+ *
+ * table - The table to settle.
+ *
+ * Returns nothing.
+ */
+void _hash_table_epoch_settle(hash_table *table) {
+	if (table->epochs == NULL) {
+		return;
+	}
+	
+	size_t chunk_count = ((size_t)table->bucket_count + (1U << HASH_TABLE_EPOCH_SHIFT) - 1) >> HASH_TABLE_EPOCH_SHIFT;
+	size_t chunk = 0;
+	for (chunk = 0; chunk < chunk_count; chunk++) {
+		if (table->epochs[chunk] != table->epoch) {
+			_hash_table_epoch_refresh(table, chunk << HASH_TABLE_EPOCH_SHIFT);
+		}
+	}
+	
+	free(table->epochs);
+	table->epochs = NULL;
+}
+
+/* Private: Marks every slot of a table as empty by starting a new
+ *          epoch, so each chunk is reset when it is next used. A
+ *          table of only one chunk, or whose chunk epochs can't be
+ *          allocated, is reset at once instead.
+ *
+ * table - The table to empty, which must not be small or frozen.
+ *
+ * Returns nothing.
+ */
+void _hash_table_epoch_advance(hash_table *table) {
+	size_t chunk_count = ((size_t)table->bucket_count + (1U << HASH_TABLE_EPOCH_SHIFT) - 1) >> HASH_TABLE_EPOCH_SHIFT;
+	
+	if (table->epochs == NULL) {
+		if (chunk_count > 1) {
+			table->epochs = calloc(chunk_count, sizeof(unsigned char));
+		}
+		
+		if (table->epochs == NULL) {
+			_hash_table_reset_slots(table, 0, table->bucket_count);
+			return;
+		}
+		
+		table->epoch = 1;
+	} else if (++table->epoch == 0) {
+		/* Every chunk is stale once the epochs are zeroed, whichever
+		 * epoch it was last used in.
+		 */
+		memset(table->epochs, 0, chunk_count * sizeof(unsigned char));
+		table->epoch = 1;
+	}
+}
+
+/* Public: Removes every key from a hash table, calling the release
+ *         functions of their values, while keeping its storage, so a
+ *         table reused for many short jobs needn't be freed and made
+ *         again or regrow each time. A table with an arena whose
+ *         values have no release functions is cleared in constant
+ *         time: its items aren't visited, its newest slab is kept
+ *         for the keys that follow, and the metadata of its slots is
+ *         only reset a chunk at a time as later operations reach it.
+ *         Other tables visit every item to free it. A filter is
+ *         dropped rather than emptied, and built again once the
+ *         table holds as many keys as a new filter has room for.
+ *
+ * table - The table to clear.
+ *
+ * Returns true if the table was cleared, or false for a frozen
+ * table, which is left unchanged.
+ */
+bool hash_table_clear(hash_table *table) {
+	if (table->layout == HASH_TABLE_FROZEN) {
+		return false;
+	}
+	
+	if (table->small) {
+		_hash_table_small_clear(table);
+	} else if (table->layout == HASH_TABLE_FLAT) {
+		_hash_table_flat_clear(table);
+	} else if (table->layout == HASH_TABLE_ROBIN_HOOD) {
+		_hash_table_robin_hood_clear(table);
+	} else if (table->layout == HASH_TABLE_ORDERED) {
+		_hash_table_ordered_clear(table);
+	} else {
+		if (!table->arena || table->releases_values) {
+			_hash_table_epoch_settle(table);
+			_hash_table_free_chains(table, table->items, table->bucket_count);
+			
+			if (table->old_items != NULL) {
+				_hash_table_free_chains(table, table->old_items, table->old_bucket_count);
+			}
+		}
+		
+		free(table->old_items);
+		
+		table->old_items = NULL;
+		table->old_bucket_count = 0;
+		table->rehash_index = 0;
+		table->occupied_buckets = 0;
+	}
+	
+	if (!table->small) {
+		_hash_table_epoch_advance(table);
+	}
+	
+	table->length = 0;
+	table->releases_values = false;
+	_hash_table_arena_reset(table);
+	
+	/* Emptying the filter would cost as much as its size, so it is
+	 * dropped instead and built again from the keys that follow.
+	 */
+	if (table->filter != NULL) {
+		cuckoo_filter_free(table->filter);
+		table->filter = NULL;
+		table->filter_pending = true;
+	}
+	
+	return true;
+}
+
+/* Public: Shrinks a hash table's storage to the smallest size that
+ *         holds its items at the layout's maximum load factor,
+ *         finishing any incremental resize and dropping the deleted
+ *         slots of flat tables. Tables with an arena have their
+ *         live keys and nodes copied into one new slab, so that the
+ *         memory of removed items is given back. Frozen tables are
+ *         already compact and are left unchanged.
+ *
+ * table - The table to compact.
+ *
+ * Returns true if the table was compacted; otherwise, false is
+ * returned and the table still holds all of its items, though it
+ * may have been compacted in part.
+ */
+bool hash_table_compact(hash_table *table) {
+	if (table->layout == HASH_TABLE_FROZEN) {
+		return true;
+	}
+	
+	if (table->small) {
+		return !table->arena || _hash_table_arena_compact(table);
+	}
+	
+	unsigned int size = _hash_table_size_for_capacity(table->layout, table->length);
+	bool resized = true;
+	
+	if (table->layout == HASH_TABLE_FLAT) {
+		resized = _hash_table_flat_resize(table, size);
+	} else if (table->layout == HASH_TABLE_ROBIN_HOOD) {
+		/* Not every item may fit close enough to its home slot in
+		 * the smallest table, so larger ones are tried in turn.
+		 */
+		while (!(resized = _hash_table_robin_hood_resize(table, size)) && size < table->bucket_count) {
+			size *= 2;
+		}
+	} else if (table->layout == HASH_TABLE_ORDERED) {
+		resized = _hash_table_ordered_resize(table, size);
+	} else if (size != table->bucket_count || table->old_items != NULL) {
+		resized = _hash_table_resize(table, size, false);
+	}
+	
+	if (!resized) {
+		return false;
+	}
+	
+	return !table->arena || _hash_table_arena_compact(table);
+}
+
+/* Private: Replaces the filter of a table with a new one holding
+ *          the hashes of all of its keys.
+ *
+ * table - The table to build the filter of.
+ * capacity - The number of keys the new filter should hold.
+ *
+ * Returns true if the filter was built; otherwise, false is
+ * returned and the table is unchanged.
+ */
+bool _hash_table_filter_build(hash_table *table, size_t capacity) {
+	cuckoo_filter *filter = cuckoo_filter_new(capacity, FILTER_FALSE_POSITIVE_RATE);
+	if (filter == NULL) {
+		return false;
+	}
+	
+	bool added = true;
+	unsigned int i = 0;
+	
+	if (table->layout == HASH_TABLE_FROZEN) {
+		for (i = 0; i < table->length && added; i++) {
+			added = cuckoo_filter_add_hash(filter, _hash_table_frozen_entry(table->frozen, i)->hash);
+		}
+	} else {
+		hash_table_item *items = malloc(table->length * sizeof(hash_table_item));
+		if (items == NULL && table->length > 0) {
+			cuckoo_filter_free(filter);
+			return false;
+		}
+		
+		_hash_table_collect_items(table, items);
+		
+		for (i = 0; i < table->length && added; i++) {
+			added = cuckoo_filter_add_hash(filter, items[i].hash);
+		}
+		
+		free(items);
+	}
+	
+	if (!added) {
+		cuckoo_filter_free(filter);
+		return false;
+	}
+	
+	if (table->filter != NULL) {
+		cuckoo_filter_free(table->filter);
+	}
+	
+	table->filter = filter;
+	
+	return true;
+}
+
+/* Private: Adds the hash of a new key to a table's filter, building
+ *          a filter twice the size if it is full. If that can't be
+ *          done, the filter is dropped, since it must hold every key.
+ *          A filter dropped by hash_table_clear is built again once
+ *          the table holds FILTER_MIN_CAPACITY keys.
+ *
+ * table - The table the key was added to.
+ * hash - The key's hash, from _hash_table_hash.
+ *
+ * Returns nothing.
+ */
+void _hash_table_filter_add(hash_table *table, uint64_t hash) {
+	if (table->filter == NULL) {
+		if (table->length >= FILTER_MIN_CAPACITY) {
+			table->filter_pending = false;
+			_hash_table_filter_build(table, (size_t)table->length * 2);
+		}
+		
+		return;
+	}
+	
+	if (cuckoo_filter_add_hash(table->filter, hash)) {
+		return;
+	}
+	
+	if (!_hash_table_filter_build(table, (size_t)table->length * 2)) {
+		cuckoo_filter_free(table->filter);
+		table->filter = NULL;
+	}
+}
+
+/* Public: Puts a cuckoo filter of a table's keys in front of its
+ *         lookups, so that most gets of missing keys return without
+ *         touching the table. This helps most for tables where
+ *         misses are common and lookups are slow, such as large
+ *         tables or those mapped from files. The filter is kept up
+ *         to date as keys are set and removed, and grows with the
+ *         table; fewer than 0.1% of misses still reach the table.
+ *
+ * table - The table to add the filter to.
+ *
+ * Returns true if the filter was added; otherwise, false is
+ * returned and the table is unchanged.
+ */
+bool hash_table_add_filter(hash_table *table) {
+	if (table->small && !_hash_table_small_grow(table, HASH_TABLE_SMALL_SIZE + 1)) {
+		return false;
+	}
+	
+	size_t capacity = (size_t)table->length * 2;
+	if (capacity < FILTER_MIN_CAPACITY) {
+		capacity = FILTER_MIN_CAPACITY;
+	}
+	
+	if (!_hash_table_filter_build(table, capacity)) {
+		return false;
+	}
+	
+	table->filter_pending = false;
+	return true;
+}
+
+/* Private: Adds one to the entry of a histogram for a length,
+ *          or the last entry for lengths past the end.
+ *
+ * histogram - The histogram, with HASH_TABLE_STATS_HISTOGRAM_SIZE
+ *             entries, or NULL to do nothing.
+ * length - The length to count.
+ *
+ * Returns nothing.
+ */
+void _hash_table_count_length(unsigned long *histogram, unsigned int length) {
+	if (histogram != NULL) {
+		histogram[(length < HASH_TABLE_STATS_HISTOGRAM_SIZE) ? length : HASH_TABLE_STATS_HISTOGRAM_SIZE - 1]++;
+	}
+}
+
+/* Private: Measures the number of probes needed to find each item
+ *          of a hash table.
+ *
+ * table - The table to measure.
+ * max - Set to the longest probe, if it is longer.
+ * total - Added to with the total length of the probes for every
+ *         item.
+ * probe_histogram - The number of items found with each number of
+ *                   probes, starting at one, which is added to,
+ *                   or NULL.
+ * chain_histogram - For chained tables, the number of buckets of
+ *                   each length, starting at zero, which is added
+ *                   to, or NULL.
+ *
+ * Returns nothing.
+ */
+void _hash_table_measure(hash_table *table, unsigned int *max, uint64_t *total, unsigned long *probe_histogram, unsigned long *chain_histogram) {
+	if (table->small || table->layout == HASH_TABLE_FROZEN) {
+		if (table->length > 0 && *max < 1) {
+			*max = 1;
+		}
+		
+		*total += table->length;
+		if (probe_histogram != NULL) {
+			probe_histogram[0] += table->length;
+		}
+		
+		return;
+	}
+	
+	_hash_table_epoch_settle(table);
+	
+	if (table->layout == HASH_TABLE_FLAT) {
+		_hash_table_flat_probe_lengths(table, max, total, probe_histogram);
+		return;
+	}
+	
+	if (table->layout == HASH_TABLE_ROBIN_HOOD) {
+		_hash_table_robin_hood_probe_lengths(table, max, total, probe_histogram);
+		return;
+	}
+	
+	if (table->layout == HASH_TABLE_ORDERED) {
+		_hash_table_ordered_probe_lengths(table, max, total, probe_histogram);
+		return;
+	}
+	
+	hash_table_node **buckets = table->items;
+	unsigned int bucket_count = table->bucket_count;
+	
+	while (buckets != NULL) {
+		unsigned int i = 0;
+		for (i = 0; i < bucket_count; i++) {
+			unsigned int probe_length = 0;
+			
+			hash_table_node *node = NULL;
+			for (node = buckets[i]; node != NULL; node = node->next) {
+				_hash_table_count_length(probe_histogram, probe_length);
+				probe_length++;
+				*total += probe_length;
+			}
+			
+			if (probe_length > *max) {
+				*max = probe_length;
+			}
+			
+			if (buckets == table->items || i >= table->rehash_index) {
+				_hash_table_count_length(chain_histogram, probe_length);
+			}
+		}
+		
+		buckets = (buckets == table->items) ? table->old_items : NULL;
+		bucket_count = table->old_bucket_count;
+	}
+}
+
+#ifdef HASH_TABLE_STATS
+/* Public: Gets statistics about the shape and use of a hash table.
+ *         The histograms are found by visiting every item, while
+ *         the counters are kept as the table is used. Only
+ *         available when built with HASH_TABLE_STATS defined.
+ *
+ * table - The table to get statistics about.
+ * stats - Set to the statistics.
+ *
+ * Returns nothing.
+ */
+void hash_table_get_stats(hash_table *table, hash_table_stats *stats) {
+	memset(stats, 0, sizeof(hash_table_stats));
+	
+	stats->layout = table->layout;
+	stats->length = table->length;
+	stats->bucket_count = table->bucket_count + ((table->old_items != NULL) ? table->old_bucket_count : 0);
+	stats->occupied_buckets = table->occupied_buckets;
+	stats->load_factor = (stats->bucket_count > 0) ? ((double)table->length) / stats->bucket_count : 0;
+	stats->counters = table->counters;
+	
+	uint64_t total = 0;
+	_hash_table_measure(table, &stats->max_probe_length, &total, stats->probe_lengths, stats->chain_lengths);
+	stats->mean_probe_length = (table->length > 0) ? ((double)total) / table->length : 0;
+}
+
+/* Public: Writes the statistics of a hash table as text, one
+ *         "name value" pair per line, with a line for each
+ *         non-empty histogram entry. Only available when built
+ *         with HASH_TABLE_STATS defined.
+ *
+ * table - The table to describe.
+ * file - The file to write to.
+ *
+ * Returns nothing.
+ */
+void hash_table_print_stats(hash_table *table, FILE *file) {
+	hash_table_stats stats;
+	hash_table_get_stats(table, &stats);
+	
+	hash_table_counters *counters = &stats.counters;
+	
+	fprintf(file, "layout %d\n", stats.layout);
+	fprintf(file, "length %u\n", stats.length);
+	fprintf(file, "buckets %u\n", stats.bucket_count);
+	fprintf(file, "occupied_buckets %u\n", stats.occupied_buckets);
+	fprintf(file, "load_factor %.3f\n", stats.load_factor);
+	fprintf(file, "max_probe_length %u\n", stats.max_probe_length);
+	fprintf(file, "mean_probe_length %.3f\n", stats.mean_probe_length);
+	
+	int i = 0;
+	for (i = 0; i < HASH_TABLE_STATS_HISTOGRAM_SIZE; i++) {
+		if (stats.probe_lengths[i] > 0) {
+			fprintf(file, "probe_length_%d%s %lu\n", i + 1, (i == HASH_TABLE_STATS_HISTOGRAM_SIZE - 1) ? "+" : "", stats.probe_lengths[i]);
+		}
+	}
+	
+	for (i = 0; i < HASH_TABLE_STATS_HISTOGRAM_SIZE; i++) {
+		if (stats.chain_lengths[i] > 0) {
+			fprintf(file, "chain_length_%d%s %lu\n", i, (i == HASH_TABLE_STATS_HISTOGRAM_SIZE - 1) ? "+" : "", stats.chain_lengths[i]);
+		}
+	}
+	
+	fprintf(file, "gets %llu\n", (unsigned long long)counters->gets);
+	fprintf(file, "hits %llu\n", (unsigned long long)counters->hits);
+	fprintf(file, "misses %llu\n", (unsigned long long)(counters->gets - counters->hits));
+	fprintf(file, "searches %llu\n", (unsigned long long)counters->searches);
+	fprintf(file, "comparisons_per_search %.3f\n", (counters->searches > 0) ? ((double)counters->comparisons) / counters->searches : 0);
+	fprintf(file, "resizes %llu\n", (unsigned long long)counters->resizes);
+	fprintf(file, "resize_seconds %.6f\n", counters->resize_seconds);
+}
+#endif
+
+/* Public: Measures how long the probes to find the items of a hash
+ *         table are: the number of nodes visited in a bucket for
+ *         chained tables, of groups for flat tables, and of slots
+ *         for Robin Hood tables.
+ *
+ * table - The table to measure.
+ * max - Set to the length of the longest probe.
+ * mean - Set to the mean probe length over every item, or zero
+ *        for an empty table.
+ *
+ * Returns nothing.
+ */
+void hash_table_probe_lengths(hash_table *table, unsigned int *max, double *mean) {
+	uint64_t total = 0;
+	*max = 0;
+	
+	_hash_table_measure(table, max, &total, NULL, NULL);
+	
+	*mean = (table->length > 0) ? ((double)total) / table->length : 0;
+}
+
+/* Private: Visits every item in a chain of nodes.
+ *
+ * node - The first node of the chain, or NULL.
+ * visit - The function to call with each item's key, key length,
+ *         value, and context.
+ * context - The pointer to pass to visit.
+ *
+ * Returns the number of items visited.
+ */
+unsigned int _hash_table_visit_chain(hash_table_node *node, void (*visit)(const char *, size_t, void *, void *), void *context) {
+	unsigned int visited = 0;
+	
+	for (; node != NULL; node = node->next) {
+		visit(node->item.key, node->item.key_length, node->item.value, context);
+		visited++;
+	}
+	
+	return visited;
+}
+
+/* Public: Visits some of the items of a hash table, continuing
+ *         from where the last call left off. A scan starts with a
+ *         cursor of zero and ends when zero is returned. Every item
+ *         in the table for the whole scan is visited at least once,
+ *         even if the table grows or is rehashed between calls;
+ *         items may be visited more than once if it does. The table
+ *         must not be changed by visit. Nothing is allocated.
+ *
+ * The cursor counts through the home buckets of items with its
+ * bits reversed, so that after the table grows, the buckets
+ * already visited are exactly those whose low bits were visited
+ * before. While a chained table is being resized, each bucket of
+ * the smaller bucket array is visited together with every bucket
+ * of the larger one that it maps to. A table in its small form
+ * has no buckets and is visited whole by the first call.
+ *
+ * table - The table to scan.
+ * cursor - Zero to start a scan, or the value returned by the
+ *          last call to continue one.
+ * count - The number of items to try to visit; at least one home
+ *         bucket is always visited, and all of its items are.
+ * visit - The function to call with each item's key, key length,
+ *         value, and context.
+ * context - The pointer to pass to visit.
+ *
+ * Returns the cursor to continue the scan from, or zero once it
+ * is complete.
+ */
+unsigned long hash_table_scan(hash_table *table, unsigned long cursor, unsigned int count, void (*visit)(const char *key, size_t length, void *value, void *context), void *context) {
+	if (table->layout == HASH_TABLE_FROZEN) {
+		return _hash_table_frozen_scan(table, cursor, (count > 0) ? count : 1, visit, context);
+	}
+	
+	if (table->small) {
+		_hash_table_small_foreach(table, visit, context);
+		return 0;
+	}
+	
+	unsigned int visited = 0;
+	do {
+		if (table->layout == HASH_TABLE_FLAT) {
+			visited += _hash_table_flat_scan(table, &cursor, visit, context);
+		} else if (table->layout == HASH_TABLE_ROBIN_HOOD) {
+			visited += _hash_table_robin_hood_scan(table, &cursor, visit, context);
+		} else if (table->layout == HASH_TABLE_ORDERED) {
+			visited += _hash_table_ordered_scan(table, &cursor, visit, context);
+		} else if (table->old_items == NULL) {
+			unsigned long mask = table->bucket_count - 1;
+			_hash_table_epoch_touch(table, cursor & mask);
+			visited += _hash_table_visit_chain(table->items[cursor & mask], visit, context);
+			cursor = _hash_table_next_cursor(cursor, mask);
+		} else {
+			hash_table_node **small = table->items, **large = table->old_items;
+			unsigned long small_mask = table->bucket_count - 1, large_mask = table->old_bucket_count - 1;
+			if (small_mask > large_mask) {
+				small = table->old_items;
+				large = table->items;
+				small_mask = table->old_bucket_count - 1;
+				large_mask = table->bucket_count - 1;
+			}
+			
+			visited += _hash_table_visit_chain(small[cursor & small_mask], visit, context);
+			
+			do {
+				visited += _hash_table_visit_chain(large[cursor & large_mask], visit, context);
+				cursor = _hash_table_next_cursor(cursor, large_mask);
+			} while ((cursor & (small_mask ^ large_mask)) != 0);
+		}
+	} while (cursor != 0 && visited < count);
+	
+	return cursor;
+}
+
+/* Public: Visits every item of a hash table in one pass over its
+ *         storage. The table must not be changed by visit.
+ *
+ * table - The table to visit the items of.
+ * visit - The function to call with each item's key, key length,
+ *         value, and context.
+ * context - The pointer to pass to visit.
+ *
+ * Returns nothing.
+ */
+void hash_table_foreach(hash_table *table, void (*visit)(const char *key, size_t length, void *value, void *context), void *context) {
+	_hash_table_epoch_settle(table);
+	
+	if (table->small) {
+		_hash_table_small_foreach(table, visit, context);
+	} else if (table->layout == HASH_TABLE_FLAT) {
+		_hash_table_flat_foreach(table, visit, context);
+	} else if (table->layout == HASH_TABLE_ROBIN_HOOD) {
+		_hash_table_robin_hood_foreach(table, visit, context);
+	} else if (table->layout == HASH_TABLE_ORDERED) {
+		_hash_table_ordered_foreach(table, visit, context);
+	} else if (table->layout == HASH_TABLE_FROZEN) {
+		_hash_table_frozen_scan(table, 0, table->length, visit, context);
+	} else {
+		unsigned int i = 0;
+		for (i = 0; i < table->bucket_count; i++) {
+			_hash_table_visit_chain(table->items[i], visit, context);
+		}
+		
+		if (table->old_items != NULL) {
+			for (i = table->rehash_index; i < table->old_bucket_count; i++) {
+				_hash_table_visit_chain(table->old_items[i], visit, context);
+			}
+		}
+	}
+}
+
+/* Public: Clears and frees memory associated with a hash table.
+ *         The items of a table using an arena are only visited if
+ *         any of them has a release function.
+ *
+ * table - The table to free.
+ *
+ * Returns nothing.
+ */
+void hash_table_free(hash_table *table) {
+	if (table->small) {
+		_hash_table_small_free(table);
+	} else if (table->layout == HASH_TABLE_FLAT) {
+		_hash_table_flat_free(table);
+	} else if (table->layout == HASH_TABLE_ROBIN_HOOD) {
+		_hash_table_robin_hood_free(table);
+	} else if (table->layout == HASH_TABLE_ORDERED) {
+		_hash_table_ordered_free(table);
+	} else if (table->layout == HASH_TABLE_FROZEN) {
+		_hash_table_frozen_free(table);
+	} else {
+		if (!table->arena || table->releases_values) {
+			_hash_table_epoch_settle(table);
+			_hash_table_free_chains(table, table->items, table->bucket_count);
+			
+			if (table->old_items != NULL) {
+				_hash_table_free_chains(table, table->old_items, table->old_bucket_count);
+			}
+		}
+		
+		free(table->items);
+		free(table->old_items);
+	}
+	
+	free(table->epochs);
+	
+	if (table->filter != NULL) {
+		cuckoo_filter_free(table->filter);
+	}
+	
+	_hash_table_arena_free(table);
 	free(table);
 }
@@ -0,0 +1,429 @@
+/*
+ *  hash_table_private.h
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#ifndef Data_Structures_hash_table_private_h
+#define Data_Structures_hash_table_private_h
+
+#include <limits.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "cuckoo_filter.h"
+#include "hash_table.h"
+
+/* The number of keys whose lookups hash_table_get_many overlaps
+ */
+#define HASH_TABLE_BATCH_SIZE 16
+
+/* Counting and timing for hash_table_get_stats, which compile to
+ * nothing unless HASH_TABLE_STATS is defined. A resize is timed
+ * from HASH_TABLE_RESIZE_START to HASH_TABLE_RESIZE_END, which
+ * must be in the same block.
+ */
+#ifdef HASH_TABLE_STATS
+#define HASH_TABLE_COUNT(table, counter, amount) ((table)->counters.counter += (amount))
+#define HASH_TABLE_RESIZE_START() double resize_start = _hash_table_now()
+#define HASH_TABLE_RESIZE_END(table) \
+	((table)->counters.resizes++, (table)->counters.resize_seconds += _hash_table_now() - resize_start)
+#else
+#define HASH_TABLE_COUNT(table, counter, amount) ((void)0)
+#define HASH_TABLE_RESIZE_START()
+#define HASH_TABLE_RESIZE_END(table) ((void)0)
+#endif
+
+typedef struct hash_table_item {
+	char *key;
+	void *value;
+	void (*release_function)(void *);
+	
+	/* The full hash of the key and its length in bytes, so keys
+	 * can be told apart and rehashed without reading them
+	 */
+	uint64_t hash;
+	size_t key_length;
+} hash_table_item;
+
+/* An item in the chain of items in a bucket of a chained table
+ */
+typedef struct hash_table_node {
+	hash_table_item item;
+	struct hash_table_node *next;
+} hash_table_node;
+
+/* A block of memory that keys and nodes are carved out of, for
+ * tables that use an arena
+ */
+typedef struct hash_table_slab {
+	struct hash_table_slab *next;
+	size_t size;
+	size_t used;
+	char data[];
+} hash_table_slab;
+
+/* The alignment of values stored in tables with a value size
+ */
+#define HASH_TABLE_VALUE_ALIGNMENT sizeof(uint64_t)
+
+/* The value offset of entries of mapped tables whose value is NULL
+ */
+#define HASH_TABLE_NULL_OFFSET UINT64_MAX
+
+/* Clearing a table doesn't reset the metadata of its slots, but
+ * starts a new epoch; each chunk of 1 << HASH_TABLE_EPOCH_SHIFT
+ * slots is reset the first time it is used after that, so a large
+ * table cleared and refilled with a few keys only pays for the
+ * chunks they land in
+ */
+#define HASH_TABLE_EPOCH_SHIFT 6
+
+/* An entry of a frozen table, followed by its key if keys are
+ * stored in entries
+ */
+typedef struct {
+	uint64_t hash;
+	
+	/* The value, or for a mapped table or one with a value size,
+	 * the offset of the value from the start of the table's values
+	 */
+	uint64_t value;
+	
+	uint32_t key_length;
+	
+	/* The offset of the key in the table's key storage, if keys
+	 * aren't stored in entries
+	 */
+	uint32_t key_offset;
+	
+	char key[];
+} hash_table_frozen_entry;
+
+/* The perfect hash and entries of a frozen table. The arrays are
+ * written as-is to files by hash_table_save, so hash_table_load
+ * can point them into a mapping of the file.
+ */
+typedef struct hash_table_frozen {
+	/* The seed mixed into every key's hash
+	 */
+	uint64_t seed;
+	
+	/* The number of buckets and their pilots
+	 */
+	unsigned int bucket_count;
+	uint16_t *pilots;
+	
+	/* The number of positions keys may be sent to, and for each
+	 * position from the number of slots onward, the slot it is
+	 * remapped to
+	 */
+	unsigned int position_count;
+	uint32_t *remap;
+	
+	/* The entries, one per slot, each entry_size bytes long
+	 */
+	char *entries;
+	size_t entry_size;
+	
+	/* Whether keys are stored in entries; if not, they are stored
+	 * one after another in keys
+	 */
+	bool keys_inline;
+	char *keys;
+	size_t keys_size;
+	
+	/* For a mapped table or one with a value size, the start of
+	 * its values, or NULL if entries hold the values themselves
+	 */
+	char *values;
+	
+	/* The mapping of the file a table was loaded from, or NULL
+	 */
+	void *mapping;
+	size_t mapping_size;
+	
+	/* The release function of the value in each slot, or NULL if
+	 * no value has one
+	 */
+	void (**release_functions)(void *);
+} hash_table_frozen;
+
+/* The header at the start of a file written by hash_table_save,
+ * which hash_table_load checks before pointing a frozen table into
+ * the file's mapping
+ */
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	
+	/* The table's hash function, as a hash_table_hash, and seed
+	 */
+	uint32_t hash;
+	uint64_t hash_seed;
+	
+	/* The fields of the table's hash_table_frozen
+	 */
+	uint64_t seed;
+	uint32_t length;
+	uint32_t bucket_count;
+	uint32_t position_count;
+	uint32_t keys_inline;
+	uint64_t entry_size;
+	
+	/* The offset and size in bytes of each array
+	 */
+	uint64_t pilots;
+	uint64_t remap;
+	uint64_t value_lengths;
+	uint64_t entries;
+	uint64_t keys;
+	uint64_t keys_size;
+	uint64_t values;
+	uint64_t values_size;
+	
+	/* The table's value size, or zero if its values vary in size,
+	 * in which case the length of each slot's value is stored in
+	 * value_lengths, and whether those values are strings ending
+	 * in a null byte
+	 */
+	uint64_t value_size;
+	uint32_t string_values;
+	
+	uint64_t file_size;
+} hash_table_file_header;
+
+#ifdef HASH_TABLE_STATS
+/* Private: Gets the current time from a monotonic clock.
+ *
+ * Returns the time in seconds.
+ */
+static inline double _hash_table_now() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+#endif
+
+/* Private: Hashes a key with a table's hash function and seed.
+ *
+ * table - The table the key belongs to.
+ * key - The key to hash.
+ * length - The length of the key in bytes.
+ *
+ * Returns the key's hash.
+ */
+static inline uint64_t _hash_table_hash(hash_table *table, const void *key, size_t length) {
+	return table->hash_function(key, length, table->seed);
+}
+
+/* Private: Gets the offset of an item's value from the start of
+ *          its key, in a table with a value size. Values follow
+ *          the key's terminating zero byte, aligned for any type.
+ *
+ * key_length - The length of the key in bytes.
+ *
+ * Returns the offset in bytes.
+ */
+static inline size_t _hash_table_value_offset(size_t key_length) {
+	return (key_length + HASH_TABLE_VALUE_ALIGNMENT) & ~(HASH_TABLE_VALUE_ALIGNMENT - 1);
+}
+
+/* Private: Gets the number of bytes allocated for an item's key,
+ *          including the value stored after it in a table with a
+ *          value size.
+ *
+ * table - The table the item belongs to.
+ * key_length - The length of the key in bytes.
+ *
+ * Returns the size in bytes.
+ */
+static inline size_t _hash_table_key_size(const hash_table *table, size_t key_length) {
+	if (table->value_size == 0) {
+		return key_length + 1;
+	}
+	
+	return _hash_table_value_offset(key_length) + table->value_size;
+}
+
+/* Private: Checks whether an item holds a key. The key's bytes
+ *          are only compared once its hash and length match.
+ *
+ * item - The item to check.
+ * key - The key to look for.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ *
+ * Returns true if the item holds the key.
+ */
+static inline bool _hash_table_item_matches(const hash_table_item *item, const void *key, size_t length, uint64_t hash) {
+	return item->hash == hash && item->key_length == length && memcmp(key, item->key, length) == 0;
+}
+
+/* Private: Gets the entry in a slot of a frozen table.
+ *
+ * frozen - The perfect hash and entries of the table.
+ * slot - The index of the slot.
+ *
+ * Returns the entry.
+ */
+static inline hash_table_frozen_entry *_hash_table_frozen_entry(const hash_table_frozen *frozen, unsigned int slot) {
+	return (hash_table_frozen_entry *)(frozen->entries + (size_t)slot * frozen->entry_size);
+}
+
+/* Private: Gets the value of an entry of a frozen table, which
+ *          for a mapped table or one with a value size is an offset
+ *          into its values.
+ *
+ * frozen - The perfect hash and entries of the table.
+ * entry - The entry to get the value of.
+ *
+ * Returns the value.
+ */
+static inline void *_hash_table_frozen_value(const hash_table_frozen *frozen, const hash_table_frozen_entry *entry) {
+	if (frozen->values != NULL) {
+		return (entry->value == HASH_TABLE_NULL_OFFSET) ? NULL : frozen->values + entry->value;
+	}
+	
+	return (void *)(uintptr_t)entry->value;
+}
+
+/* Private: Reverses the order of the bits of a number.
+ *
+ * bits - The number to reverse.
+ *
+ * Returns the reversed number.
+ */
+static inline unsigned long _hash_table_reverse_bits(unsigned long bits) {
+	unsigned int shift = sizeof(bits) * CHAR_BIT;
+	unsigned long mask = ~0UL;
+	
+	while ((shift >>= 1) > 0) {
+		mask ^= mask << shift;
+		bits = ((bits >> shift) & mask) | ((bits << shift) & ~mask);
+	}
+	
+	return bits;
+}
+
+/* Private: Advances a hash_table_scan cursor to the next home
+ *          bucket. The cursor's bits are incremented from the top
+ *          down, so buckets are visited in an order that stays
+ *          valid when the number of buckets doubles or halves: the
+ *          buckets an earlier one splits into or merges with are
+ *          either all visited or all still to come.
+ *
+ * cursor - The cursor, whose bits within mask give its bucket.
+ * mask - The number of home buckets, less one.
+ *
+ * Returns the next cursor, or zero after the last bucket.
+ */
+static inline unsigned long _hash_table_next_cursor(unsigned long cursor, unsigned long mask) {
+	cursor = _hash_table_reverse_bits(cursor | ~mask);
+	
+	return _hash_table_reverse_bits(cursor + 1);
+}
+
+extern hash_table *_hash_table_new_with_size(unsigned int size, const hash_table_options *options);
+extern unsigned int _hash_table_size_for_capacity(hash_table_layout layout, unsigned int capacity);
+extern bool _hash_table_set(hash_table *table, void *elem, const void *key, size_t length, uint64_t hash, void (*release_function)(void *));
+extern void *_hash_table_get(hash_table *table, const void *key, size_t length, uint64_t hash);
+extern bool _hash_table_remove(hash_table *table, const void *key, size_t length, uint64_t hash);
+extern void _hash_table_shrink(hash_table *table);
+extern bool _hash_table_item_init(hash_table *table, hash_table_item *item, void *elem, const void *key, size_t length, uint64_t hash, void (*release_function)(void *));
+extern void _hash_table_item_release(hash_table *table, hash_table_item *item);
+extern void *_hash_table_alloc(hash_table *table, size_t size);
+extern void _hash_table_dealloc(hash_table *table, void *memory);
+extern void _hash_table_collect_items(hash_table *table, hash_table_item *items);
+extern void _hash_table_count_length(unsigned long *histogram, unsigned int length);
+extern void _hash_table_discard_storage(hash_table *table, hash_table_item *items, unsigned int count);
+extern void _hash_table_epoch_refresh(hash_table *table, size_t slot);
+extern void _hash_table_epoch_settle(hash_table *table);
+
+/* Private: Resets the chunk of a cleared table holding a slot if
+ *          it hasn't been used since the table was cleared. Reads
+ *          of a slot's metadata must come after this, unless the
+ *          table has been settled by _hash_table_epoch_settle.
+ *
+ * table - The table the slot belongs to.
+ * slot - The index of the slot.
+ *
+ * Returns nothing.
+ */
+static inline void _hash_table_epoch_touch(hash_table *table, size_t slot) {
+	if (table->epochs != NULL && table->epochs[slot >> HASH_TABLE_EPOCH_SHIFT] != table->epoch) {
+		_hash_table_epoch_refresh(table, slot);
+	}
+}
+
+extern void *_hash_table_arena_alloc(hash_table *table, size_t size);
+extern void _hash_table_arena_free(hash_table *table);
+extern void _hash_table_arena_reset(hash_table *table);
+extern bool _hash_table_arena_compact(hash_table *table);
+
+extern hash_table_item *_hash_table_small_insert(hash_table *table, const void *key, size_t length, bool *inserted);
+extern void *_hash_table_small_get(hash_table *table, const void *key, size_t length);
+extern bool _hash_table_small_remove(hash_table *table, const void *key, size_t length);
+extern void _hash_table_small_collect(hash_table *table, hash_table_item *items);
+extern void _hash_table_small_foreach(hash_table *table, void (*visit)(const char *, size_t, void *, void *), void *context);
+extern bool _hash_table_small_grow(hash_table *table, unsigned int capacity);
+extern void _hash_table_small_clear(hash_table *table);
+extern void _hash_table_small_free(hash_table *table);
+
+extern unsigned int _hash_table_flat_size_for_capacity(unsigned int capacity);
+extern bool _hash_table_flat_init(hash_table *table, unsigned int size);
+extern bool _hash_table_flat_resize(hash_table *table, unsigned int size);
+extern hash_table_item *_hash_table_flat_insert(hash_table *table, const void *key, size_t length, uint64_t hash, bool *inserted);
+extern void *_hash_table_flat_get(hash_table *table, const void *key, size_t length, uint64_t hash);
+extern void _hash_table_flat_get_many(hash_table *table, const void **keys, const size_t *lengths, const uint64_t *hashes, size_t count, void **values);
+extern bool _hash_table_flat_remove(hash_table *table, const void *key, size_t length, uint64_t hash);
+extern void _hash_table_flat_probe_lengths(hash_table *table, unsigned int *max, uint64_t *total, unsigned long *histogram);
+extern void _hash_table_flat_collect(hash_table *table, hash_table_item *items);
+extern unsigned int _hash_table_flat_scan(hash_table *table, unsigned long *cursor, void (*visit)(const char *, size_t, void *, void *), void *context);
+extern void _hash_table_flat_foreach(hash_table *table, void (*visit)(const char *, size_t, void *, void *), void *context);
+extern void _hash_table_flat_clear(hash_table *table);
+extern void _hash_table_flat_reset(hash_table *table, unsigned int start, unsigned int count);
+extern void _hash_table_flat_free(hash_table *table);
+
+extern unsigned int _hash_table_robin_hood_size_for_capacity(unsigned int capacity);
+extern bool _hash_table_robin_hood_init(hash_table *table, unsigned int size);
+extern bool _hash_table_robin_hood_resize(hash_table *table, unsigned int size);
+extern hash_table_item *_hash_table_robin_hood_insert(hash_table *table, const void *key, size_t length, uint64_t hash, bool *inserted);
+extern void *_hash_table_robin_hood_get(hash_table *table, const void *key, size_t length, uint64_t hash);
+extern void _hash_table_robin_hood_get_many(hash_table *table, const void **keys, const size_t *lengths, const uint64_t *hashes, size_t count, void **values);
+extern bool _hash_table_robin_hood_remove(hash_table *table, const void *key, size_t length, uint64_t hash);
+extern void _hash_table_robin_hood_probe_lengths(hash_table *table, unsigned int *max, uint64_t *total, unsigned long *histogram);
+extern void _hash_table_robin_hood_collect(hash_table *table, hash_table_item *items);
+extern unsigned int _hash_table_robin_hood_scan(hash_table *table, unsigned long *cursor, void (*visit)(const char *, size_t, void *, void *), void *context);
+extern void _hash_table_robin_hood_foreach(hash_table *table, void (*visit)(const char *, size_t, void *, void *), void *context);
+extern void _hash_table_robin_hood_clear(hash_table *table);
+extern void _hash_table_robin_hood_reset(hash_table *table, unsigned int start, unsigned int count);
+extern void _hash_table_robin_hood_free(hash_table *table);
+
+extern unsigned int _hash_table_ordered_size_for_capacity(unsigned int capacity);
+extern bool _hash_table_ordered_init(hash_table *table, unsigned int size);
+extern bool _hash_table_ordered_resize(hash_table *table, unsigned int size);
+extern hash_table_item *_hash_table_ordered_insert(hash_table *table, const void *key, size_t length, uint64_t hash, bool *inserted);
+extern void *_hash_table_ordered_get(hash_table *table, const void *key, size_t length, uint64_t hash);
+extern void _hash_table_ordered_get_many(hash_table *table, const void **keys, const size_t *lengths, const uint64_t *hashes, size_t count, void **values);
+extern bool _hash_table_ordered_remove(hash_table *table, const void *key, size_t length, uint64_t hash);
+extern void _hash_table_ordered_probe_lengths(hash_table *table, unsigned int *max, uint64_t *total, unsigned long *histogram);
+extern void _hash_table_ordered_collect(hash_table *table, hash_table_item *items);
+extern unsigned int _hash_table_ordered_scan(hash_table *table, unsigned long *cursor, void (*visit)(const char *, size_t, void *, void *), void *context);
+extern void _hash_table_ordered_foreach(hash_table *table, void (*visit)(const char *, size_t, void *, void *), void *context);
+extern void _hash_table_ordered_clear(hash_table *table);
+extern void _hash_table_ordered_reset(hash_table *table, unsigned int start, unsigned int count);
+extern void _hash_table_ordered_free(hash_table *table);
+
+extern void *_hash_table_frozen_get(hash_table *table, const void *key, size_t length, uint64_t hash);
+extern void _hash_table_frozen_get_many(hash_table *table, const void **keys, const size_t *lengths, const uint64_t *hashes, size_t count, void **values);
+extern unsigned long _hash_table_frozen_scan(hash_table *table, unsigned long cursor, unsigned int count, void (*visit)(const char *, size_t, void *, void *), void *context);
+extern void _hash_table_frozen_free(hash_table *table);
+extern hash_table_frozen *_hash_table_frozen_new(hash_table_item *items, unsigned int count, bool releases_values, size_t value_size);
+extern void _hash_table_frozen_destroy(hash_table_frozen *frozen);
+
+#endif
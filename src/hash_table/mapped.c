@@ -0,0 +1,462 @@
+/*
+ *  mapped.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hash_table_private.h"
+
+/* Files hold a header followed by the arrays of a frozen table:
+ * its pilots, remapped positions, value lengths if its values vary
+ * in size, entries, keys and values, each at an offset from the
+ * start of the file. Nothing in a file is a
+ * pointer, so a file can be mapped anywhere and used in place.
+ * Entries start on a cache line boundary, and values on an
+ * ALIGNMENT boundary so they can hold any type.
+ */
+#define FILE_MAGIC "HTABLE\r\n"
+#define FILE_VERSION 3
+#define BYTE_ORDER_MARK 0x01020304
+#define ALIGNMENT sizeof(uint64_t)
+#define ENTRY_ALIGNMENT 64
+
+bool _hash_table_write(FILE *file, hash_table_frozen *frozen, unsigned int length, hash_table_file_header *header, size_t (*value_length)(void *));
+bool _hash_table_write_padding(FILE *file, uint64_t *offset, size_t alignment);
+bool _hash_table_header_valid(const hash_table_file_header *header, size_t size);
+bool _hash_table_offsets_valid(const hash_table_file_header *header, const char *mapping);
+
+/* Private: Gets the number of bytes of a value to write to a
+ *          file, which is the table's value size if it has one.
+ */
+static inline size_t _hash_table_value_length(void *value, size_t (*value_length)(void *), size_t value_size) {
+	if (value_size > 0) {
+		return value_size;
+	}
+
+	return (value_length != NULL) ? value_length(value) : strlen(value) + 1;
+}
+
+/* Private: Gets the size of a value, as written to a file.
+ */
+static inline size_t _hash_table_value_size(void *value, size_t (*value_length)(void *), size_t value_size) {
+	if (value == NULL) {
+		return 0;
+	}
+
+	size_t size = _hash_table_value_length(value, value_length, value_size);
+
+	return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+/* Private: Writes zeroes to a file until an offset is aligned.
+ *
+ * file - The file to write to.
+ * offset - The offset in the file, which is updated.
+ * alignment - The alignment to reach, a power of two.
+ *
+ * Returns true if the padding was written.
+ */
+bool _hash_table_write_padding(FILE *file, uint64_t *offset, size_t alignment) {
+	static const char zeroes[ENTRY_ALIGNMENT] = {0};
+
+	size_t padding = (alignment - (*offset & (alignment - 1))) & (alignment - 1);
+	*offset += padding;
+
+	return fwrite(zeroes, 1, padding, file) == padding;
+}
+
+/* Private: Writes the arrays of a frozen table to a file after its
+ *          header, which must have its offsets filled in.
+ *
+ * file - The file to write to, positioned after the header.
+ * frozen - The perfect hash and entries of the table.
+ * length - The number of items in the table.
+ * header - The header already written to the file.
+ * value_length - The function giving the size of each value.
+ *
+ * Returns true if every array was written.
+ */
+bool _hash_table_write(FILE *file, hash_table_frozen *frozen, unsigned int length, hash_table_file_header *header, size_t (*value_length)(void *)) {
+	uint64_t offset = sizeof(hash_table_file_header);
+	unsigned int i = 0;
+
+	if (!_hash_table_write_padding(file, &offset, ALIGNMENT) ||
+		fwrite(frozen->pilots, sizeof(uint16_t), header->bucket_count, file) != header->bucket_count) {
+		return false;
+	}
+
+	offset += header->bucket_count * sizeof(uint16_t);
+
+	size_t remapped = header->position_count - length;
+	if (!_hash_table_write_padding(file, &offset, ALIGNMENT) ||
+		fwrite(frozen->remap, sizeof(uint32_t), remapped, file) != remapped) {
+		return false;
+	}
+
+	offset += remapped * sizeof(uint32_t);
+
+	if (!_hash_table_write_padding(file, &offset, ALIGNMENT)) {
+		return false;
+	}
+
+	/* Values that vary in size have their lengths written, so that
+	 * hash_table_load can check that each one lies in the file.
+	 */
+	if (header->value_size == 0) {
+		for (i = 0; i < length; i++) {
+			void *value = _hash_table_frozen_value(frozen, _hash_table_frozen_entry(frozen, i));
+			uint64_t value_size = (value != NULL) ? _hash_table_value_length(value, value_length, 0) : 0;
+
+			if (fwrite(&value_size, sizeof(uint64_t), 1, file) != 1) {
+				return false;
+			}
+		}
+
+		offset += (uint64_t)length * sizeof(uint64_t);
+	}
+
+	if (!_hash_table_write_padding(file, &offset, ENTRY_ALIGNMENT)) {
+		return false;
+	}
+
+	/* Entries are written with the offsets of their values, which
+	 * follow one another in slot order.
+	 */
+	hash_table_frozen_entry *entry = malloc(frozen->entry_size);
+	if (entry == NULL) {
+		return false;
+	}
+
+	uint64_t value_offset = 0;
+	for (i = 0; i < length; i++) {
+		void *value = _hash_table_frozen_value(frozen, _hash_table_frozen_entry(frozen, i));
+
+		memcpy(entry, _hash_table_frozen_entry(frozen, i), frozen->entry_size);
+		entry->value = (value != NULL) ? value_offset : HASH_TABLE_NULL_OFFSET;
+		value_offset += _hash_table_value_size(value, value_length, header->value_size);
+
+		if (fwrite(entry, frozen->entry_size, 1, file) != 1) {
+			free(entry);
+			return false;
+		}
+	}
+
+	free(entry);
+	offset += (uint64_t)length * frozen->entry_size;
+
+	if (header->keys_size > 0 && fwrite(frozen->keys, 1, header->keys_size, file) != header->keys_size) {
+		return false;
+	}
+
+	offset += header->keys_size;
+
+	if (!_hash_table_write_padding(file, &offset, ALIGNMENT)) {
+		return false;
+	}
+
+	for (i = 0; i < length; i++) {
+		void *value = _hash_table_frozen_value(frozen, _hash_table_frozen_entry(frozen, i));
+		if (value == NULL) {
+			continue;
+		}
+
+		size_t size = _hash_table_value_length(value, value_length, header->value_size);
+		if (fwrite(value, 1, size, file) != size) {
+			return false;
+		}
+
+		offset += size;
+
+		if (!_hash_table_write_padding(file, &offset, ALIGNMENT)) {
+			return false;
+		}
+	}
+
+	return offset == header->file_size;
+}
+
+/* Public: Writes a hash table to a file that hash_table_load can
+ *         use in place. The file is written under a temporary name
+ *         and then renamed, so that a file being loaded is never
+ *         seen half-written. The table is unchanged; if it isn't
+ *         frozen, a perfect hash of its keys is built for the file.
+ *
+ * table - The table to write.
+ * path - The path of the file to write.
+ * value_length - A function giving the number of bytes of each
+ *                value to write, or NULL if every value is a
+ *                string ending in a null byte; it is not used for
+ *                tables with a value size.
+ *
+ * Returns true if the file was written.
+ */
+bool hash_table_save(hash_table *table, const char *path, size_t (*value_length)(void *value)) {
+	hash_table_file_header header;
+	memset(&header, 0, sizeof(header));
+
+	if (table->hash_function == &hash_keyed) {
+		header.hash = HASH_TABLE_HASH_KEYED;
+	} else if (table->hash_function == &hash_fast) {
+		header.hash = HASH_TABLE_HASH_FAST;
+	} else {
+		return false;
+	}
+
+	hash_table_frozen *frozen = table->frozen;
+	if (table->layout != HASH_TABLE_FROZEN) {
+		hash_table_item *items = malloc((table->length + 1) * sizeof(hash_table_item));
+		if (items == NULL) {
+			return false;
+		}
+
+		_hash_table_collect_items(table, items);
+		frozen = _hash_table_frozen_new(items, table->length, false, table->value_size);
+		free(items);
+
+		if (frozen == NULL) {
+			return false;
+		}
+	}
+
+	memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+	header.version = FILE_VERSION;
+	header.byte_order = BYTE_ORDER_MARK;
+	header.hash_seed = table->seed;
+	header.seed = frozen->seed;
+	header.length = table->length;
+	header.bucket_count = frozen->bucket_count;
+	header.position_count = frozen->position_count;
+	header.keys_inline = frozen->keys_inline;
+	header.entry_size = frozen->entry_size;
+	header.keys_size = frozen->keys_inline ? 0 : frozen->keys_size;
+	header.value_size = table->value_size;
+	header.string_values = table->value_size == 0 && value_length == NULL;
+
+	uint64_t offset = sizeof(hash_table_file_header);
+	offset = (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+	header.pilots = offset;
+	offset += header.bucket_count * sizeof(uint16_t);
+
+	offset = (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+	header.remap = offset;
+	offset += (header.position_count - header.length) * sizeof(uint32_t);
+
+	offset = (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+	header.value_lengths = offset;
+	if (header.value_size == 0) {
+		offset += (uint64_t)header.length * sizeof(uint64_t);
+	}
+
+	offset = (offset + ENTRY_ALIGNMENT - 1) & ~(ENTRY_ALIGNMENT - 1);
+	header.entries = offset;
+	offset += (uint64_t)header.length * header.entry_size;
+
+	header.keys = offset;
+	offset += header.keys_size;
+
+	offset = (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+	header.values = offset;
+
+	unsigned int i = 0;
+	for (i = 0; i < table->length; i++) {
+		header.values_size += _hash_table_value_size(_hash_table_frozen_value(frozen, _hash_table_frozen_entry(frozen, i)), value_length, header.value_size);
+	}
+
+	header.file_size = header.values + header.values_size;
+
+	bool written = false;
+	char *temporary_path = malloc(strlen(path) + sizeof(".tmp"));
+	if (temporary_path != NULL) {
+		sprintf(temporary_path, "%s.tmp", path);
+
+		FILE *file = fopen(temporary_path, "wb");
+		if (file != NULL) {
+			written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+				_hash_table_write(file, frozen, table->length, &header, value_length);
+			written = (fclose(file) == 0) && written;
+			written = written && rename(temporary_path, path) == 0;
+
+			if (!written) {
+				remove(temporary_path);
+			}
+		}
+
+		free(temporary_path);
+	}
+
+	if (frozen != table->frozen) {
+		_hash_table_frozen_destroy(frozen);
+	}
+
+	return written;
+}
+
+/* Private: Checks that an array of a file lies within it.
+ */
+static inline bool _hash_table_file_contains(const hash_table_file_header *header, uint64_t offset, uint64_t size) {
+	return offset >= sizeof(hash_table_file_header) && offset <= header->file_size && size <= header->file_size - offset;
+}
+
+/* Private: Checks that the header of a mapped file describes a
+ *          table this build can use, with every array inside the
+ *          file.
+ *
+ * header - The header at the start of the mapping.
+ * size - The size of the file in bytes.
+ *
+ * Returns true if the header is valid.
+ */
+bool _hash_table_header_valid(const hash_table_file_header *header, size_t size) {
+	if (memcmp(header->magic, FILE_MAGIC, sizeof(header->magic)) != 0 || header->version != FILE_VERSION ||
+		header->byte_order != BYTE_ORDER_MARK || header->file_size != size) {
+		return false;
+	}
+
+	if (header->hash != HASH_TABLE_HASH_FAST && header->hash != HASH_TABLE_HASH_KEYED) {
+		return false;
+	}
+
+	if (header->bucket_count == 0 || header->position_count < header->length ||
+		header->entry_size < sizeof(hash_table_frozen_entry) || header->entry_size % ALIGNMENT != 0) {
+		return false;
+	}
+
+	return header->entries % ENTRY_ALIGNMENT == 0 && header->values % ALIGNMENT == 0 &&
+		header->pilots % ALIGNMENT == 0 && header->remap % ALIGNMENT == 0 && header->value_lengths % ALIGNMENT == 0 &&
+		_hash_table_file_contains(header, header->pilots, (uint64_t)header->bucket_count * sizeof(uint16_t)) &&
+		_hash_table_file_contains(header, header->remap, (uint64_t)(header->position_count - header->length) * sizeof(uint32_t)) &&
+		_hash_table_file_contains(header, header->value_lengths, (header->value_size == 0) ? (uint64_t)header->length * sizeof(uint64_t) : 0) &&
+		_hash_table_file_contains(header, header->entries, (uint64_t)header->length * header->entry_size) &&
+		_hash_table_file_contains(header, header->keys, header->keys_size) &&
+		_hash_table_file_contains(header, header->values, header->values_size);
+}
+
+/* Private: Checks that every slot in the remap array of a mapped
+ *          file, and every key and value of its entries, lies
+ *          within the table, since lookups follow them without
+ *          checking, and that every value saved as a string ends
+ *          in a null byte.
+ *
+ * header - The header at the start of the mapping, which must be
+ *          valid.
+ * mapping - The start of the mapping.
+ *
+ * Returns true if every offset is valid.
+ */
+bool _hash_table_offsets_valid(const hash_table_file_header *header, const char *mapping) {
+	const uint32_t *remap = (const uint32_t *)(mapping + header->remap);
+	const uint64_t *value_lengths = (const uint64_t *)(mapping + header->value_lengths);
+	const char *values = mapping + header->values;
+
+	uint32_t i = 0;
+	for (i = 0; i < header->position_count - header->length; i++) {
+		if (remap[i] >= header->length) {
+			return false;
+		}
+	}
+
+	for (i = 0; i < header->length; i++) {
+		const hash_table_frozen_entry *entry = (const hash_table_frozen_entry *)(mapping + header->entries + i * header->entry_size);
+
+		if (header->keys_inline) {
+			if (entry->key_length > header->entry_size - offsetof(hash_table_frozen_entry, key)) {
+				return false;
+			}
+		} else if (entry->key_offset > header->keys_size || entry->key_length > header->keys_size - entry->key_offset) {
+			return false;
+		}
+
+		if (entry->value == HASH_TABLE_NULL_OFFSET) {
+			continue;
+		}
+
+		uint64_t value_size = (header->value_size > 0) ? header->value_size : value_lengths[i];
+		if (entry->value > header->values_size || value_size > header->values_size - entry->value) {
+			return false;
+		}
+
+		if (header->string_values && (value_size == 0 || values[entry->value + value_size - 1] != '\0')) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Public: Loads a hash table from a file written by hash_table_save
+ *         by mapping the file into memory. Nothing is copied or
+ *         rehashed, but the remap array and entries are read once
+ *         to check that every offset in them stays inside the file,
+ *         so a damaged file is rejected rather than read out of
+ *         bounds. The table is frozen, and its values point into
+ *         the mapping, which is read-only. The file is unmapped by
+ *         hash_table_free.
+ *
+ * path - The path of the file to load.
+ *
+ * Returns the table, or NULL if the file couldn't be mapped, wasn't
+ * written by a compatible build, or is damaged.
+ */
+hash_table *hash_table_load(const char *path) {
+	int descriptor = open(path, O_RDONLY);
+	if (descriptor < 0) {
+		return NULL;
+	}
+
+	struct stat status;
+	if (fstat(descriptor, &status) != 0 || status.st_size < (off_t)sizeof(hash_table_file_header)) {
+		close(descriptor);
+		return NULL;
+	}
+
+	size_t size = status.st_size;
+	char *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	close(descriptor);
+
+	if (mapping == MAP_FAILED) {
+		return NULL;
+	}
+
+	const hash_table_file_header *header = (const hash_table_file_header *)mapping;
+	hash_table *table = calloc(1, sizeof(hash_table));
+	hash_table_frozen *frozen = calloc(1, sizeof(hash_table_frozen));
+	if (!_hash_table_header_valid(header, size) || !_hash_table_offsets_valid(header, mapping) || table == NULL || frozen == NULL) {
+		munmap(mapping, size);
+		free(table);
+		free(frozen);
+		return NULL;
+	}
+
+	frozen->seed = header->seed;
+	frozen->bucket_count = header->bucket_count;
+	frozen->pilots = (uint16_t *)(mapping + header->pilots);
+	frozen->position_count = header->position_count;
+	frozen->remap = (uint32_t *)(mapping + header->remap);
+	frozen->entries = mapping + header->entries;
+	frozen->entry_size = header->entry_size;
+	frozen->keys_inline = header->keys_inline;
+	frozen->keys = mapping + header->keys;
+	frozen->keys_size = header->keys_size;
+	frozen->values = mapping + header->values;
+	frozen->mapping = mapping;
+	frozen->mapping_size = size;
+
+	table->hash_function = (header->hash == HASH_TABLE_HASH_KEYED) ? &hash_keyed : &hash_fast;
+	table->seed = header->hash_seed;
+	table->value_size = header->value_size;
+	table->layout = HASH_TABLE_FROZEN;
+	table->length = header->length;
+	table->bucket_count = header->length;
+	table->occupied_buckets = header->length;
+	table->frozen = frozen;
+
+	return table;
+}
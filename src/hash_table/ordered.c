@@ -0,0 +1,581 @@
+/*
+ *  ordered.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/18/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include "hash_table_private.h"
+
+/* Items are stored in a dense array of entries, in the order they
+ * were added, and found through a sparse index of bucket_count
+ * slots, probed linearly from the slot picked by the low bits of
+ * their hash. Each index slot holds the position of an entry plus
+ * one, or zero if it is empty, in as few bytes as the number of
+ * entries allows, so the index costs one to four bytes per slot
+ * rather than a whole item.
+ *
+ * Removing an item leaves a hole in the entries, marked by a NULL
+ * key, and shifts later index slots back rather than leaving a
+ * marker, so probes only ever stop at empty slots. Holes are
+ * squeezed out the next time the entries fill up.
+ */
+#define MIN_SLOTS 8
+#define MAX_LOAD_NUMERATOR 2
+#define MAX_LOAD_DENOMINATOR 3
+
+size_t _hash_table_ordered_find(hash_table *table, const void *key, size_t length, uint64_t hash);
+bool _hash_table_ordered_make_room(hash_table *table);
+
+/* Private: Gets the number of entries an ordered table with a
+ *          number of index slots has room for.
+ *
+ * slot_count - The number of index slots.
+ *
+ * Returns the number of entries.
+ */
+static inline unsigned int _hash_table_ordered_usable(unsigned int slot_count) {
+	return (uint64_t)slot_count * MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR;
+}
+
+/* Private: Gets an index slot of an ordered table, first resetting
+ *          it if the table has been cleared since the slot was last
+ *          used.
+ *
+ * table - The table to read the index of.
+ * slot - The index of the slot.
+ *
+ * Returns the position of the slot's entry plus one, or zero if
+ * the slot is empty.
+ */
+static inline uint32_t _hash_table_ordered_slot(hash_table *table, size_t slot) {
+	_hash_table_epoch_touch(table, slot);
+
+	if (table->index_width == 1) {
+		return ((const uint8_t *)table->index)[slot];
+	}
+
+	if (table->index_width == 2) {
+		return ((const uint16_t *)table->index)[slot];
+	}
+
+	return ((const uint32_t *)table->index)[slot];
+}
+
+/* Private: Sets an index slot of an ordered table.
+ *
+ * table - The table to change the index of.
+ * slot - The index of the slot.
+ * value - The position of an entry plus one, or zero to empty the
+ *         slot.
+ *
+ * Returns nothing.
+ */
+static inline void _hash_table_ordered_set_slot(hash_table *table, size_t slot, uint32_t value) {
+	if (table->index_width == 1) {
+		((uint8_t *)table->index)[slot] = value;
+	} else if (table->index_width == 2) {
+		((uint16_t *)table->index)[slot] = value;
+	} else {
+		((uint32_t *)table->index)[slot] = value;
+	}
+}
+
+/* Private: Finds the index slot of a key in an ordered table, or
+ *          the empty slot where it would be placed.
+ *
+ * table - The table to search.
+ * key - The key to look for.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ *
+ * Returns the index of the slot, which is empty if the key isn't
+ * in the table.
+ */
+size_t _hash_table_ordered_find(hash_table *table, const void *key, size_t length, uint64_t hash) {
+	size_t mask = table->bucket_count - 1;
+	size_t slot = hash & mask;
+
+	HASH_TABLE_COUNT(table, searches, 1);
+
+	uint32_t position = 0;
+	while ((position = _hash_table_ordered_slot(table, slot)) != 0) {
+		HASH_TABLE_COUNT(table, comparisons, 1);
+		if (_hash_table_item_matches(&table->slots[position - 1], key, length, hash)) {
+			break;
+		}
+
+		slot = (slot + 1) & mask;
+	}
+
+	return slot;
+}
+
+/* Private: Gets the number of index slots an ordered table needs
+ *          to hold a number of items without growing.
+ *
+ * capacity - The number of items the table should hold.
+ *
+ * Returns the number of slots, which is a power of two.
+ */
+unsigned int _hash_table_ordered_size_for_capacity(unsigned int capacity) {
+	unsigned int slot_count = MIN_SLOTS;
+	while (capacity > _hash_table_ordered_usable(slot_count)) {
+		slot_count *= 2;
+	}
+
+	return slot_count;
+}
+
+/* Private: Allocates empty storage for an ordered table.
+ *
+ * table - The table to initialize.
+ * size - The minimum number of index slots to allocate, which is
+ *        rounded up to a power of two.
+ *
+ * Returns true if the storage could be allocated; otherwise,
+ * false is returned and the table is unchanged.
+ */
+bool _hash_table_ordered_init(hash_table *table, unsigned int size) {
+	unsigned int slot_count = MIN_SLOTS;
+	while (slot_count < size) {
+		slot_count *= 2;
+	}
+
+	unsigned int usable = _hash_table_ordered_usable(slot_count);
+	unsigned int width = (usable <= UINT8_MAX) ? 1 : (usable <= UINT16_MAX) ? 2 : 4;
+
+	void *index = calloc(slot_count, width);
+	if (index == NULL) {
+		return false;
+	}
+
+	hash_table_item *entries = malloc(usable * sizeof(hash_table_item));
+	if (entries == NULL) {
+		free(index);
+		return false;
+	}
+
+	table->index = index;
+	table->index_width = width;
+	table->slots = entries;
+	table->entry_count = 0;
+	table->entry_capacity = usable;
+	table->bucket_count = slot_count;
+	table->occupied_buckets = 0;
+
+	return true;
+}
+
+/* Private: Moves every item of an ordered table into new storage,
+ *          keeping their order and squeezing out holes.
+ *
+ * table - The table to resize.
+ * size - The minimum number of index slots in the new storage,
+ *        which must leave room for every item.
+ *
+ * Returns true if the resizing succeeded; otherwise, false is
+ * returned and the table is unchanged.
+ */
+bool _hash_table_ordered_resize(hash_table *table, unsigned int size) {
+	HASH_TABLE_RESIZE_START();
+	_hash_table_epoch_settle(table);
+
+	void *old_index = table->index;
+	unsigned int old_width = table->index_width;
+	hash_table_item *old_entries = table->slots;
+	unsigned int old_entry_count = table->entry_count;
+	unsigned int old_entry_capacity = table->entry_capacity;
+	unsigned int old_count = table->bucket_count;
+	unsigned int old_occupied = table->occupied_buckets;
+
+	if (!_hash_table_ordered_init(table, size)) {
+		return false;
+	}
+
+	if (table->length > table->entry_capacity) {
+		free(table->index);
+		free(table->slots);
+
+		table->index = old_index;
+		table->index_width = old_width;
+		table->slots = old_entries;
+		table->entry_count = old_entry_count;
+		table->entry_capacity = old_entry_capacity;
+		table->bucket_count = old_count;
+		table->occupied_buckets = old_occupied;
+
+		return false;
+	}
+
+	size_t mask = table->bucket_count - 1;
+	unsigned int i = 0;
+	for (i = 0; i < old_entry_count; i++) {
+		if (old_entries[i].key == NULL) {
+			continue;
+		}
+
+		size_t slot = old_entries[i].hash & mask;
+		while (_hash_table_ordered_slot(table, slot) != 0) {
+			slot = (slot + 1) & mask;
+		}
+
+		table->slots[table->entry_count] = old_entries[i];
+		table->entry_count++;
+		_hash_table_ordered_set_slot(table, slot, table->entry_count);
+	}
+
+	table->occupied_buckets = table->entry_count;
+
+	free(old_index);
+	free(old_entries);
+
+	HASH_TABLE_RESIZE_END(table);
+
+	return true;
+}
+
+/* Private: Makes room for one more entry at the end of an ordered
+ *          table's entries, by squeezing out holes if at least a
+ *          quarter of the entries are holes, and by doubling the
+ *          table otherwise.
+ *
+ * table - The table to make room in.
+ *
+ * Returns true if there is room; otherwise, false is returned
+ * and the table is unchanged.
+ */
+bool _hash_table_ordered_make_room(hash_table *table) {
+	if (table->entry_count < table->entry_capacity) {
+		return true;
+	}
+
+	if (table->length < table->entry_count - table->entry_count / 4) {
+		return _hash_table_ordered_resize(table, table->bucket_count);
+	}
+
+	return table->bucket_count <= UINT_MAX / 2 && _hash_table_ordered_resize(table, table->bucket_count * 2);
+}
+
+/* Private: Finds the item of a key in an ordered table, adding it
+ *          with a NULL value after every other item if it isn't
+ *          there.
+ *
+ * table - The table to find the key in.
+ * key - The key to find.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ * inserted - Set to whether the key was added.
+ *
+ * Returns the key's item, or NULL if it couldn't be added, in
+ * which case the table is unchanged.
+ */
+hash_table_item *_hash_table_ordered_insert(hash_table *table, const void *key, size_t length, uint64_t hash, bool *inserted) {
+	*inserted = false;
+
+	size_t slot = _hash_table_ordered_find(table, key, length, hash);
+	uint32_t position = _hash_table_ordered_slot(table, slot);
+	if (position != 0) {
+		return &table->slots[position - 1];
+	}
+
+	if (table->entry_count == table->entry_capacity) {
+		if (!_hash_table_ordered_make_room(table)) {
+			return NULL;
+		}
+
+		slot = _hash_table_ordered_find(table, key, length, hash);
+	}
+
+	hash_table_item *entry = &table->slots[table->entry_count];
+	if (!_hash_table_item_init(table, entry, NULL, key, length, hash, NULL)) {
+		return NULL;
+	}
+
+	table->entry_count++;
+	_hash_table_ordered_set_slot(table, slot, table->entry_count);
+	table->occupied_buckets++;
+	table->length++;
+	*inserted = true;
+
+	return entry;
+}
+
+/* Private: Gets the value of a key in an ordered table.
+ *
+ * table - The table to get the value from.
+ * key - The key to get the value of.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ *
+ * Returns the value of key in table, or NULL if
+ * the element couldn't be found.
+ */
+void *_hash_table_ordered_get(hash_table *table, const void *key, size_t length, uint64_t hash) {
+	uint32_t position = _hash_table_ordered_slot(table, _hash_table_ordered_find(table, key, length, hash));
+	if (position == 0) {
+		return NULL;
+	}
+
+	return table->slots[position - 1].value;
+}
+
+/* Private: Gets the values of a batch of keys in an ordered table,
+ *          prefetching the home index slot of every key before
+ *          resolving any of them.
+ *
+ * table - The table to get the values from.
+ * keys - The keys to get the values of.
+ * lengths - The length of each key in bytes.
+ * hashes - The hash of each key, from _hash_table_hash.
+ * count - The number of keys, at most HASH_TABLE_BATCH_SIZE.
+ * values - Set to the value of each key, or NULL for keys that
+ *          couldn't be found.
+ *
+ * Returns nothing.
+ */
+void _hash_table_ordered_get_many(hash_table *table, const void **keys, const size_t *lengths, const uint64_t *hashes, size_t count, void **values) {
+	size_t mask = table->bucket_count - 1;
+	uint32_t positions[HASH_TABLE_BATCH_SIZE];
+
+	size_t i = 0;
+	for (i = 0; i < count; i++) {
+		__builtin_prefetch((char *)table->index + (hashes[i] & mask) * table->index_width);
+	}
+
+	/* The entries of the keys' home slots are usually the keys'
+	 * own, so they are fetched next.
+	 */
+	for (i = 0; i < count; i++) {
+		positions[i] = _hash_table_ordered_slot(table, hashes[i] & mask);
+		if (positions[i] != 0) {
+			__builtin_prefetch(&table->slots[positions[i] - 1]);
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		values[i] = (positions[i] == 0) ? NULL : _hash_table_ordered_get(table, keys[i], lengths[i], hashes[i]);
+	}
+}
+
+/* Private: Removes a key from an ordered table, leaving a hole in
+ *          its entries. The index slots after the key's are shifted
+ *          back into the gap, unless that would move them before
+ *          their home slots.
+ *
+ * table - The table to remove the key from.
+ * key - The key to remove.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ *
+ * Returns true if the key was found and removed.
+ */
+bool _hash_table_ordered_remove(hash_table *table, const void *key, size_t length, uint64_t hash) {
+	size_t gap = _hash_table_ordered_find(table, key, length, hash);
+	uint32_t position = _hash_table_ordered_slot(table, gap);
+	if (position == 0) {
+		return false;
+	}
+
+	hash_table_item *entry = &table->slots[position - 1];
+	_hash_table_item_release(table, entry);
+	entry->key = NULL;
+
+	size_t mask = table->bucket_count - 1;
+	size_t slot = gap;
+
+	while (true) {
+		slot = (slot + 1) & mask;
+
+		uint32_t next = _hash_table_ordered_slot(table, slot);
+		if (next == 0) {
+			break;
+		}
+
+		size_t home = table->slots[next - 1].hash & mask;
+		if (((slot - home) & mask) >= ((slot - gap) & mask)) {
+			_hash_table_ordered_set_slot(table, gap, next);
+			gap = slot;
+		}
+	}
+
+	_hash_table_ordered_set_slot(table, gap, 0);
+
+	/* Holes at the end of the entries are simply given back.
+	 */
+	while (table->entry_count > 0 && table->slots[table->entry_count - 1].key == NULL) {
+		table->entry_count--;
+	}
+
+	table->occupied_buckets--;
+	table->length--;
+
+	return true;
+}
+
+/* Private: Measures how far the items of an ordered table are
+ *          from their home index slots.
+ *
+ * table - The table to measure.
+ * max - Set to the number of slots probed to find the furthest
+ *       item.
+ * total - Set to the total number of slots probed to find every
+ *         item.
+ * histogram - The number of items found with each number of probes,
+ *             which is added to, or NULL.
+ *
+ * Returns nothing.
+ */
+void _hash_table_ordered_probe_lengths(hash_table *table, unsigned int *max, uint64_t *total, unsigned long *histogram) {
+	size_t mask = table->bucket_count - 1;
+
+	unsigned int i = 0;
+	for (i = 0; i < table->bucket_count; i++) {
+		uint32_t position = _hash_table_ordered_slot(table, i);
+		if (position == 0) {
+			continue;
+		}
+
+		unsigned int probe_length = ((i - table->slots[position - 1].hash) & mask) + 1;
+		if (probe_length > *max) {
+			*max = probe_length;
+		}
+
+		*total += probe_length;
+		_hash_table_count_length(histogram, probe_length - 1);
+	}
+}
+
+/* Private: Copies every item of an ordered table into an array,
+ *          in the order they were added.
+ *
+ * table - The table to copy the items of.
+ * items - An array with room for every item.
+ *
+ * Returns nothing.
+ */
+void _hash_table_ordered_collect(hash_table *table, hash_table_item *items) {
+	unsigned int i = 0;
+	for (i = 0; i < table->entry_count; i++) {
+		if (table->slots[i].key != NULL) {
+			*items++ = table->slots[i];
+		}
+	}
+}
+
+/* Private: Visits every item of an ordered table whose home is the
+ *          index slot a cursor points to, then advances the cursor
+ *          to the next slot. Such items are in the run of full
+ *          slots starting at their home.
+ *
+ * table - The table to visit the items of.
+ * cursor - The cursor, as described by hash_table_scan.
+ * visit - The function to call with each item's key, key length,
+ *         value, and context.
+ * context - The pointer to pass to visit.
+ *
+ * Returns the number of items visited.
+ */
+unsigned int _hash_table_ordered_scan(hash_table *table, unsigned long *cursor, void (*visit)(const char *, size_t, void *, void *), void *context) {
+	size_t mask = table->bucket_count - 1;
+	size_t home = *cursor & mask;
+	unsigned int visited = 0;
+
+	*cursor = _hash_table_next_cursor(*cursor, mask);
+
+	size_t offset = 0;
+	for (offset = 0; offset <= mask; offset++) {
+		uint32_t position = _hash_table_ordered_slot(table, (home + offset) & mask);
+		if (position == 0) {
+			break;
+		}
+
+		hash_table_item *item = &table->slots[position - 1];
+		if ((item->hash & mask) == home) {
+			visit(item->key, item->key_length, item->value, context);
+			visited++;
+		}
+	}
+
+	return visited;
+}
+
+/* Private: Visits every item of an ordered table in the order they
+ *          were added, in one pass over its entries.
+ *
+ * table - The table to visit the items of.
+ * visit - The function to call with each item's key, key length,
+ *         value, and context.
+ * context - The pointer to pass to visit.
+ *
+ * Returns nothing.
+ */
+void _hash_table_ordered_foreach(hash_table *table, void (*visit)(const char *, size_t, void *, void *), void *context) {
+	unsigned int i = 0;
+	for (i = 0; i < table->entry_count; i++) {
+		if (table->slots[i].key != NULL) {
+			visit(table->slots[i].key, table->slots[i].key_length, table->slots[i].value, context);
+		}
+	}
+}
+
+/* Private: Releases every item of an ordered table, if any of them
+ *          have anything to free, without changing its storage.
+ *
+ * table - The table to release the items of.
+ *
+ * Returns nothing.
+ */
+static void _hash_table_ordered_release_items(hash_table *table) {
+	if (!table->arena || table->releases_values) {
+		unsigned int i = 0;
+		for (i = 0; i < table->entry_count; i++) {
+			if (table->slots[i].key != NULL) {
+				_hash_table_item_release(table, &table->slots[i]);
+			}
+		}
+	}
+}
+
+/* Private: Releases every item of an ordered table and empties its
+ *          entries, keeping its storage. The index is left for
+ *          hash_table_clear to reset.
+ *
+ * table - The table to clear.
+ *
+ * Returns nothing.
+ */
+void _hash_table_ordered_clear(hash_table *table) {
+	_hash_table_ordered_release_items(table);
+
+	table->entry_count = 0;
+	table->occupied_buckets = 0;
+}
+
+/* Private: Empties a run of the index slots of an ordered table.
+ *
+ * table - The table to change.
+ * start - The index of the first slot.
+ * count - The number of slots.
+ *
+ * Returns nothing.
+ */
+void _hash_table_ordered_reset(hash_table *table, unsigned int start, unsigned int count) {
+	memset((char *)table->index + (size_t)start * table->index_width, 0, (size_t)count * table->index_width);
+}
+
+/* Private: Releases every item of an ordered table and frees its
+ *          storage, but not the table itself or its arena. Items
+ *          are only visited if they have anything to free.
+ *
+ * table - The table to clear.
+ *
+ * Returns nothing.
+ */
+void _hash_table_ordered_free(hash_table *table) {
+	_hash_table_ordered_release_items(table);
+
+	free(table->index);
+	free(table->slots);
+}
@@ -0,0 +1,550 @@
+/*
+ *  robin_hood.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include "hash_table_private.h"
+
+/* Items are stored inline in one array of slots and probed
+ * linearly from the slot picked by the low bits of their hash.
+ * An item's distance from that slot is kept in a parallel array
+ * of bytes, holding zero for an empty slot and the distance plus
+ * one otherwise. On insertion, an item takes the slot of any item
+ * closer to its own home slot, which keeps every key's probe
+ * short even at a high load factor.
+ */
+#define MIN_SLOTS 8
+#define MAX_DISTANCE (UCHAR_MAX - 1)
+#define MAX_LOAD_NUMERATOR 9
+#define MAX_LOAD_DENOMINATOR 10
+
+bool _hash_table_robin_hood_fits(hash_table *table, uint64_t hash);
+size_t _hash_table_robin_hood_place(hash_table *table, hash_table_item item);
+hash_table_item *_hash_table_robin_hood_find(hash_table *table, const void *key, size_t length, uint64_t hash);
+
+/* Private: Gets the distance of a slot of a Robin Hood table, first
+ *          resetting it if the table has been cleared since the
+ *          slot was last used.
+ *
+ * table - The table to read.
+ * index - The index of the slot.
+ *
+ * Returns the distance of the slot's item plus one, or zero for an
+ * empty slot.
+ */
+static inline unsigned int _hash_table_robin_hood_distance(hash_table *table, size_t index) {
+	_hash_table_epoch_touch(table, index);
+
+	return table->distances[index];
+}
+
+/* Private: Checks whether an item with a hash can be placed in a
+ *          Robin Hood table without moving any item further than
+ *          MAX_DISTANCE from its home slot. Insertion is simulated
+ *          using only the distances of the items it would move.
+ *
+ * table - The table to check, which must have a free slot.
+ * hash - The hash of the item to place.
+ *
+ * Returns true if the item fits.
+ */
+bool _hash_table_robin_hood_fits(hash_table *table, uint64_t hash) {
+	size_t mask = table->bucket_count - 1;
+	size_t index = hash & mask;
+	unsigned int distance = 0;
+
+	while (_hash_table_robin_hood_distance(table, index) != 0) {
+		unsigned int resident = table->distances[index] - 1;
+		if (resident < distance) {
+			distance = resident;
+		}
+
+		distance++;
+		if (distance > MAX_DISTANCE) {
+			return false;
+		}
+
+		index = (index + 1) & mask;
+	}
+
+	return true;
+}
+
+/* Private: Places an item in a Robin Hood table, moving items that
+ *          are closer to their home slots along to make room. The
+ *          table must have a free slot, and the item must fit.
+ *
+ * table - The table to place the item in.
+ * item - The item to place.
+ *
+ * Returns the index of the slot the item was placed in.
+ */
+size_t _hash_table_robin_hood_place(hash_table *table, hash_table_item item) {
+	size_t mask = table->bucket_count - 1;
+	size_t index = item.hash & mask;
+	size_t placed = SIZE_MAX;
+	unsigned int distance = 0;
+
+	while (_hash_table_robin_hood_distance(table, index) != 0) {
+		unsigned int resident = table->distances[index] - 1;
+		if (resident < distance) {
+			hash_table_item displaced = table->slots[index];
+			table->slots[index] = item;
+			table->distances[index] = distance + 1;
+
+			if (placed == SIZE_MAX) {
+				placed = index;
+			}
+
+			item = displaced;
+			distance = resident;
+		}
+
+		distance++;
+		index = (index + 1) & mask;
+	}
+
+	table->slots[index] = item;
+	table->distances[index] = distance + 1;
+	table->occupied_buckets++;
+
+	return (placed == SIZE_MAX) ? index : placed;
+}
+
+/* Private: Finds the slot holding a key in a Robin Hood table.
+ *          The search stops at the first slot whose item is closer
+ *          to its home slot than the key would be, since the key
+ *          would have taken that slot.
+ *
+ * table - The table to search.
+ * key - The key to look for.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ *
+ * Returns the key's item, or NULL if it isn't in the table.
+ */
+hash_table_item *_hash_table_robin_hood_find(hash_table *table, const void *key, size_t length, uint64_t hash) {
+	size_t mask = table->bucket_count - 1;
+	size_t index = hash & mask;
+	unsigned int distance = 1;
+
+	HASH_TABLE_COUNT(table, searches, 1);
+
+	while (_hash_table_robin_hood_distance(table, index) >= distance) {
+		HASH_TABLE_COUNT(table, comparisons, 1);
+		if (table->distances[index] == distance && _hash_table_item_matches(&table->slots[index], key, length, hash)) {
+			return &table->slots[index];
+		}
+
+		distance++;
+		index = (index + 1) & mask;
+	}
+
+	return NULL;
+}
+
+/* Private: Gets the number of slots a Robin Hood table needs to
+ *          hold a number of items without growing.
+ *
+ * capacity - The number of items the table should hold.
+ *
+ * Returns the number of slots, which is a power of two.
+ */
+unsigned int _hash_table_robin_hood_size_for_capacity(unsigned int capacity) {
+	unsigned int slot_count = MIN_SLOTS;
+	while (((uint64_t)capacity) * MAX_LOAD_DENOMINATOR > ((uint64_t)slot_count) * MAX_LOAD_NUMERATOR) {
+		slot_count *= 2;
+	}
+
+	return slot_count;
+}
+
+/* Private: Allocates empty storage for a Robin Hood table.
+ *
+ * table - The table to initialize.
+ * size - The minimum number of slots to allocate, which is
+ *        rounded up to a power of two.
+ *
+ * Returns true if the storage could be allocated; otherwise,
+ * false is returned and the table is unchanged.
+ */
+bool _hash_table_robin_hood_init(hash_table *table, unsigned int size) {
+	unsigned int slot_count = MIN_SLOTS;
+	while (slot_count < size) {
+		slot_count *= 2;
+	}
+
+	unsigned char *distances = calloc(slot_count, sizeof(unsigned char));
+	if (distances == NULL) {
+		return false;
+	}
+
+	hash_table_item *slots = malloc(slot_count * sizeof(hash_table_item));
+	if (slots == NULL) {
+		free(distances);
+		return false;
+	}
+
+	table->distances = distances;
+	table->slots = slots;
+	table->bucket_count = slot_count;
+	table->occupied_buckets = 0;
+
+	return true;
+}
+
+/* Private: Moves every item of a Robin Hood table into new
+ *          storage.
+ *
+ * table - The table to resize.
+ * size - The minimum number of slots in the new storage.
+ *
+ * Returns true if the resizing succeeded; otherwise, false is
+ * returned and the table is unchanged.
+ */
+bool _hash_table_robin_hood_resize(hash_table *table, unsigned int size) {
+	HASH_TABLE_RESIZE_START();
+	_hash_table_epoch_settle(table);
+
+	unsigned char *old_distances = table->distances;
+	hash_table_item *old_slots = table->slots;
+	unsigned int old_count = table->bucket_count;
+	unsigned int old_occupied = table->occupied_buckets;
+
+	if (!_hash_table_robin_hood_init(table, size)) {
+		return false;
+	}
+
+	unsigned int i = 0;
+	for (i = 0; i < old_count; i++) {
+		if (old_distances[i] == 0) {
+			continue;
+		}
+
+		if (!_hash_table_robin_hood_fits(table, old_slots[i].hash)) {
+			free(table->distances);
+			free(table->slots);
+
+			table->distances = old_distances;
+			table->slots = old_slots;
+			table->bucket_count = old_count;
+			table->occupied_buckets = old_occupied;
+
+			return false;
+		}
+
+		_hash_table_robin_hood_place(table, old_slots[i]);
+	}
+
+	free(old_distances);
+	free(old_slots);
+
+	HASH_TABLE_RESIZE_END(table);
+
+	return true;
+}
+
+/* Private: Finds the item of a key in a Robin Hood table, adding
+ *          it with a NULL value if it isn't there and doubling the
+ *          table if it would pass its maximum load factor or the
+ *          key's probe would be too long.
+ *
+ * table - The table to find the key in.
+ * key - The key to find.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ * inserted - Set to whether the key was added.
+ *
+ * Returns the key's item, or NULL if it couldn't be added, in
+ * which case the table is unchanged.
+ */
+hash_table_item *_hash_table_robin_hood_insert(hash_table *table, const void *key, size_t length, uint64_t hash, bool *inserted) {
+	*inserted = false;
+
+	hash_table_item *existing = _hash_table_robin_hood_find(table, key, length, hash);
+	if (existing != NULL) {
+		return existing;
+	}
+
+	if ((table->occupied_buckets + 1) * MAX_LOAD_DENOMINATOR > table->bucket_count * MAX_LOAD_NUMERATOR) {
+		if (!_hash_table_robin_hood_resize(table, table->bucket_count * 2)) {
+			return NULL;
+		}
+	}
+
+	/* Probes only stay too long at a low load factor if many keys
+	 * share their whole hash, which growing won't help.
+	 */
+	while (!_hash_table_robin_hood_fits(table, hash)) {
+		if (table->occupied_buckets * 2 < table->bucket_count || !_hash_table_robin_hood_resize(table, table->bucket_count * 2)) {
+			return NULL;
+		}
+	}
+
+	hash_table_item item;
+	if (!_hash_table_item_init(table, &item, NULL, key, length, hash, NULL)) {
+		return NULL;
+	}
+
+	size_t index = _hash_table_robin_hood_place(table, item);
+	table->length++;
+	*inserted = true;
+
+	return &table->slots[index];
+}
+
+/* Private: Gets the value of a key in a Robin Hood table.
+ *
+ * table - The table to get the value from.
+ * key - The key to get the value of.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ *
+ * Returns the value of key in table, or NULL if
+ * the element couldn't be found.
+ */
+void *_hash_table_robin_hood_get(hash_table *table, const void *key, size_t length, uint64_t hash) {
+	hash_table_item *item = _hash_table_robin_hood_find(table, key, length, hash);
+	if (item == NULL) {
+		return NULL;
+	}
+
+	return item->value;
+}
+
+/* Private: Gets the values of a batch of keys in a Robin Hood
+ *          table, prefetching the home slot of every key before
+ *          resolving any of them.
+ *
+ * table - The table to get the values from.
+ * keys - The keys to get the values of.
+ * lengths - The length of each key in bytes.
+ * hashes - The hash of each key, from _hash_table_hash.
+ * count - The number of keys, at most HASH_TABLE_BATCH_SIZE.
+ * values - Set to the value of each key, or NULL for keys that
+ *          couldn't be found.
+ *
+ * Returns nothing.
+ */
+void _hash_table_robin_hood_get_many(hash_table *table, const void **keys, const size_t *lengths, const uint64_t *hashes, size_t count, void **values) {
+	size_t mask = table->bucket_count - 1;
+
+	size_t i = 0;
+	for (i = 0; i < count; i++) {
+		__builtin_prefetch(&table->distances[hashes[i] & mask]);
+		__builtin_prefetch(&table->slots[hashes[i] & mask]);
+	}
+
+	for (i = 0; i < count; i++) {
+		values[i] = _hash_table_robin_hood_get(table, keys[i], lengths[i], hashes[i]);
+	}
+}
+
+/* Private: Removes a key from a Robin Hood table. The items after
+ *          it are shifted back one slot each, up to the first one
+ *          that is empty or already in its home slot, so no marker
+ *          is left behind.
+ *
+ * table - The table to remove the key from.
+ * key - The key to remove.
+ * length - The length of the key in bytes.
+ * hash - The key's hash, from _hash_table_hash.
+ *
+ * Returns true if the key was found and removed.
+ */
+bool _hash_table_robin_hood_remove(hash_table *table, const void *key, size_t length, uint64_t hash) {
+	hash_table_item *item = _hash_table_robin_hood_find(table, key, length, hash);
+	if (item == NULL) {
+		return false;
+	}
+
+	_hash_table_item_release(table, item);
+
+	size_t mask = table->bucket_count - 1;
+	size_t index = item - table->slots;
+	size_t next = (index + 1) & mask;
+
+	while (_hash_table_robin_hood_distance(table, next) > 1) {
+		table->slots[index] = table->slots[next];
+		table->distances[index] = table->distances[next] - 1;
+
+		index = next;
+		next = (next + 1) & mask;
+	}
+
+	table->distances[index] = 0;
+	table->occupied_buckets--;
+	table->length--;
+
+	return true;
+}
+
+/* Private: Measures how far the items of a Robin Hood table are
+ *          from their home slots.
+ *
+ * table - The table to measure.
+ * max - Set to the number of slots probed to find the furthest
+ *       item.
+ * total - Set to the total number of slots probed to find every
+ *         item.
+ * histogram - The number of items found with each number of probes,
+ *             which is added to, or NULL.
+ *
+ * Returns nothing.
+ */
+void _hash_table_robin_hood_probe_lengths(hash_table *table, unsigned int *max, uint64_t *total, unsigned long *histogram) {
+	unsigned int i = 0;
+	for (i = 0; i < table->bucket_count; i++) {
+		unsigned int probe_length = table->distances[i];
+		if (probe_length == 0) {
+			continue;
+		}
+
+		if (probe_length > *max) {
+			*max = probe_length;
+		}
+
+		*total += probe_length;
+		_hash_table_count_length(histogram, probe_length - 1);
+	}
+}
+
+/* Private: Copies every item of a Robin Hood table into an
+ *          array.
+ *
+ * table - The table to copy the items of.
+ * items - An array with room for every item.
+ *
+ * Returns nothing.
+ */
+void _hash_table_robin_hood_collect(hash_table *table, hash_table_item *items) {
+	unsigned int i = 0;
+	for (i = 0; i < table->bucket_count; i++) {
+		if (table->distances[i] != 0) {
+			*items++ = table->slots[i];
+		}
+	}
+}
+
+/* Private: Visits every item of a Robin Hood table whose home is
+ *          the slot a cursor points to, then advances the cursor to
+ *          the next slot. Such items follow one another, and end
+ *          before the first empty slot or item that is closer to
+ *          its own home.
+ *
+ * table - The table to visit the items of.
+ * cursor - The cursor, as described by hash_table_scan.
+ * visit - The function to call with each item's key, key length,
+ *         value, and context.
+ * context - The pointer to pass to visit.
+ *
+ * Returns the number of items visited.
+ */
+unsigned int _hash_table_robin_hood_scan(hash_table *table, unsigned long *cursor, void (*visit)(const char *, size_t, void *, void *), void *context) {
+	size_t mask = table->bucket_count - 1;
+	size_t home = *cursor & mask;
+	unsigned int visited = 0;
+
+	*cursor = _hash_table_next_cursor(*cursor, mask);
+
+	size_t offset = 0;
+	for (offset = 0; offset <= mask; offset++) {
+		size_t index = (home + offset) & mask;
+		unsigned int distance = _hash_table_robin_hood_distance(table, index);
+		if (distance == 0 || distance - 1 < offset) {
+			break;
+		}
+
+		if (distance - 1 == offset) {
+			hash_table_item *item = &table->slots[index];
+			visit(item->key, item->key_length, item->value, context);
+			visited++;
+		}
+	}
+
+	return visited;
+}
+
+/* Private: Visits every item of a Robin Hood table in one pass over
+ *          its slots.
+ *
+ * table - The table to visit the items of.
+ * visit - The function to call with each item's key, key length,
+ *         value, and context.
+ * context - The pointer to pass to visit.
+ *
+ * Returns nothing.
+ */
+void _hash_table_robin_hood_foreach(hash_table *table, void (*visit)(const char *, size_t, void *, void *), void *context) {
+	unsigned int i = 0;
+	for (i = 0; i < table->bucket_count; i++) {
+		if (table->distances[i] != 0) {
+			visit(table->slots[i].key, table->slots[i].key_length, table->slots[i].value, context);
+		}
+	}
+}
+
+/* Private: Releases every item of a Robin Hood table, if any of
+ *          them have anything to free, without changing its storage.
+ *
+ * table - The table to release the items of.
+ *
+ * Returns nothing.
+ */
+static void _hash_table_robin_hood_release_items(hash_table *table) {
+	if (!table->arena || table->releases_values) {
+		_hash_table_epoch_settle(table);
+
+		unsigned int i = 0;
+		for (i = 0; i < table->bucket_count; i++) {
+			if (table->distances[i] != 0) {
+				_hash_table_item_release(table, &table->slots[i]);
+			}
+		}
+	}
+}
+
+/* Private: Releases every item of a Robin Hood table, keeping its
+ *          storage. The distances are left for hash_table_clear to
+ *          reset.
+ *
+ * table - The table to clear.
+ *
+ * Returns nothing.
+ */
+void _hash_table_robin_hood_clear(hash_table *table) {
+	_hash_table_robin_hood_release_items(table);
+
+	table->occupied_buckets = 0;
+}
+
+/* Private: Empties a run of the slots of a Robin Hood table by
+ *          resetting their distances.
+ *
+ * table - The table to change.
+ * start - The index of the first slot.
+ * count - The number of slots.
+ *
+ * Returns nothing.
+ */
+void _hash_table_robin_hood_reset(hash_table *table, unsigned int start, unsigned int count) {
+	memset(table->distances + start, 0, count * sizeof(unsigned char));
+}
+
+/* Private: Releases every item of a Robin Hood table and frees its
+ *          storage, but not the table itself or its arena. Items
+ *          are only visited if they have anything to free.
+ *
+ * table - The table to clear.
+ *
+ * Returns nothing.
+ */
+void _hash_table_robin_hood_free(hash_table *table) {
+	_hash_table_robin_hood_release_items(table);
+
+	free(table->distances);
+	free(table->slots);
+}
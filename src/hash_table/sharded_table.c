@@ -0,0 +1,552 @@
+/*
+ *  sharded_table.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/18/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <limits.h>
+#include <unistd.h>
+
+#include "sharded_table.h"
+#include "hash_table_private.h"
+
+/* Keys are sent to shards by the high 32 bits of their hashes,
+ * which no layout uses to place keys within a table, so the keys
+ * of each shard are spread over all of its buckets.
+ *
+ * Each writer keeps its own sub-table per shard, so writers never
+ * share memory with each other and need no locks. Merging moves
+ * every writer's sub-tables for a shard into the shard, with
+ * threads taking shards one at a time; a shard that is still empty
+ * adopts the largest sub-table as it is, rather than copying it.
+ */
+#define SHARDS_PER_PROCESSOR 4
+
+typedef struct sharded_table_merge_work {
+	sharded_table *table;
+
+	/* The next shard for a thread to merge
+	 */
+	unsigned int next_shard;
+
+	/* Whether every shard merged so far was merged fully
+	 */
+	bool merged;
+} sharded_table_merge_work;
+
+unsigned int _sharded_table_processors();
+hash_table *_sharded_table_new_shard(sharded_table *table, unsigned int capacity);
+bool _sharded_table_move(hash_table *shard, hash_table **sub_table);
+bool _sharded_table_merge_shard(sharded_table *table, unsigned int index);
+void *_sharded_table_merge_worker(void *context);
+
+/* Private: Gets the shard a key belongs in.
+ *
+ * table - The table the key belongs to.
+ * hash - The key's hash.
+ *
+ * Returns the index of the shard.
+ */
+static inline unsigned int _sharded_table_shard(const sharded_table *table, uint64_t hash) {
+	return ((hash >> 32) * table->shard_count) >> 32;
+}
+
+/* Private: Gets the number of processors available to run threads.
+ *
+ * Returns the number of processors, which is at least one.
+ */
+unsigned int _sharded_table_processors() {
+	long processors = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return (processors > 0) ? (unsigned int)processors : 1;
+}
+
+/* Private: Creates an empty shard or sub-table, which hashes keys
+ *          with the table's hash function and seed.
+ *
+ * table - The table the shard belongs to.
+ * capacity - The number of items the shard should hold before it
+ *            first grows.
+ *
+ * Returns the new shard, or NULL if it couldn't be created.
+ */
+hash_table *_sharded_table_new_shard(sharded_table *table, unsigned int capacity) {
+	hash_table_options options = table->options;
+	options.capacity = capacity;
+
+	hash_table *shard = hash_table_new_with_options(&options);
+	if (shard == NULL) {
+		return NULL;
+	}
+
+	shard->hash_function = table->hash_function;
+	shard->seed = table->seed;
+
+	return shard;
+}
+
+/* Private: Moves every item of a writer's sub-table into a shard,
+ *          and frees the sub-table. Keys already in the shard take
+ *          the sub-table's values, as with hash_table_set.
+ *
+ * shard - The shard to move the items to.
+ * sub_table - The sub-table to move the items from, which is set
+ *             to NULL once it has been freed.
+ *
+ * Returns true if every item was moved. Otherwise, false is
+ * returned, and items that couldn't be moved have their values
+ * released; if the sub-table's items couldn't even be listed, it is
+ * left as it is.
+ */
+bool _sharded_table_move(hash_table *shard, hash_table **sub_table) {
+	unsigned int count = (*sub_table)->length;
+	hash_table_item *items = malloc((size_t)count * sizeof(hash_table_item));
+	if (items == NULL && count > 0) {
+		return false;
+	}
+
+	_hash_table_collect_items(*sub_table, items);
+
+	bool moved = true;
+	unsigned int i = 0;
+	for (i = 0; i < count; i++) {
+		hash_table_item *item = &items[i];
+		if (_hash_table_set(shard, item->value, item->key, item->key_length, item->hash, item->release_function)) {
+			continue;
+		}
+
+		if (item->release_function != NULL) {
+			item->release_function(item->value);
+		}
+
+		moved = false;
+	}
+
+	_hash_table_discard_storage(*sub_table, items, count);
+	free(*sub_table);
+	free(items);
+	*sub_table = NULL;
+
+	return moved;
+}
+
+/* Private: Moves the items of every writer's sub-table for a shard
+ *          into the shard.
+ *
+ * table - The table to merge.
+ * index - The index of the shard.
+ *
+ * Returns true if every item was moved.
+ */
+bool _sharded_table_merge_shard(sharded_table *table, unsigned int index) {
+	sharded_table_writer *writer = NULL;
+
+	if (table->shards[index]->length == 0) {
+		sharded_table_writer *largest = NULL;
+		for (writer = table->writers; writer != NULL; writer = writer->next) {
+			hash_table *sub_table = writer->shards[index];
+			if (sub_table != NULL && (largest == NULL || sub_table->length > largest->shards[index]->length)) {
+				largest = writer;
+			}
+		}
+
+		if (largest != NULL) {
+			hash_table_free(table->shards[index]);
+			table->shards[index] = largest->shards[index];
+			largest->shards[index] = NULL;
+		}
+	}
+
+	hash_table *shard = table->shards[index];
+
+	unsigned long total = shard->length;
+	for (writer = table->writers; writer != NULL; writer = writer->next) {
+		if (writer->shards[index] != NULL) {
+			total += writer->shards[index]->length;
+		}
+	}
+
+	/* Growing the shard once up front saves resizing it as items
+	 * are moved; if it can't, it grows as needed instead.
+	 */
+	hash_table_reserve(shard, (total > UINT_MAX) ? UINT_MAX : (unsigned int)total);
+
+	bool merged = true;
+	for (writer = table->writers; writer != NULL; writer = writer->next) {
+		if (writer->shards[index] != NULL && !_sharded_table_move(shard, &writer->shards[index])) {
+			merged = false;
+		}
+	}
+
+	return merged;
+}
+
+/* Private: Merges shards until none are left, as the body of a
+ *          merging thread.
+ *
+ * context - The sharded_table_merge_work shared by the threads.
+ *
+ * Returns NULL.
+ */
+void *_sharded_table_merge_worker(void *context) {
+	sharded_table_merge_work *work = context;
+
+	while (true) {
+		unsigned int index = __atomic_fetch_add(&work->next_shard, 1, __ATOMIC_RELAXED);
+		if (index >= work->table->shard_count) {
+			break;
+		}
+
+		if (!_sharded_table_merge_shard(work->table, index)) {
+			__atomic_store_n(&work->merged, false, __ATOMIC_RELAXED);
+		}
+	}
+
+	return NULL;
+}
+
+/* Public: Creates a new sharded table, with SHARDS_PER_PROCESSOR
+ *         chained shards for each available processor.
+ *
+ * Returns the new table, or NULL if it couldn't be created.
+ */
+sharded_table *sharded_table_new() {
+	sharded_table_options options;
+	memset(&options, 0, sizeof(options));
+
+	return sharded_table_new_with_options(&options);
+}
+
+/* Public: Creates a new sharded table with the given options.
+ *
+ * options - The number of shards, and the options each shard is
+ *           created with.
+ *
+ * Returns the new table, or NULL if it couldn't be created.
+ */
+sharded_table *sharded_table_new_with_options(const sharded_table_options *options) {
+	if (options->table.layout == HASH_TABLE_FROZEN) {
+		return NULL;
+	}
+
+	sharded_table *table = malloc(sizeof(sharded_table));
+	if (table == NULL) {
+		return NULL;
+	}
+
+	if (options->table.hash == HASH_TABLE_HASH_KEYED) {
+		table->hash_function = &hash_keyed;
+		table->seed = hash_random_seed();
+	} else {
+		table->hash_function = &hash_fast;
+		table->seed = 0;
+	}
+
+	table->options = options->table;
+	table->shard_count = options->shard_count;
+	if (table->shard_count == 0) {
+		table->shard_count = _sharded_table_processors() * SHARDS_PER_PROCESSOR;
+	}
+
+	table->writers = NULL;
+	pthread_mutex_init(&table->writers_lock, NULL);
+
+	table->shards = calloc(table->shard_count, sizeof(hash_table *));
+	if (table->shards == NULL) {
+		pthread_mutex_destroy(&table->writers_lock);
+		free(table);
+		return NULL;
+	}
+
+	unsigned int i = 0;
+	for (i = 0; i < table->shard_count; i++) {
+		table->shards[i] = _sharded_table_new_shard(table, options->table.capacity / table->shard_count);
+		if (table->shards[i] == NULL) {
+			sharded_table_free(table);
+			return NULL;
+		}
+	}
+
+	return table;
+}
+
+/* Public: Creates a writer for a sharded table, through which one
+ *         thread at a time can add keys without synchronizing with
+ *         other writers. Keys added through a writer can't be found
+ *         until sharded_table_merge is called. Writers are freed
+ *         with their table.
+ *
+ * table - The table to create the writer for.
+ *
+ * Returns the new writer, or NULL if it couldn't be created.
+ */
+sharded_table_writer *sharded_table_writer_new(sharded_table *table) {
+	sharded_table_writer *writer = malloc(sizeof(sharded_table_writer));
+	if (writer == NULL) {
+		return NULL;
+	}
+
+	writer->table = table;
+	writer->shards = calloc(table->shard_count, sizeof(hash_table *));
+	if (writer->shards == NULL) {
+		free(writer);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&table->writers_lock);
+	writer->next = table->writers;
+	table->writers = writer;
+	pthread_mutex_unlock(&table->writers_lock);
+
+	return writer;
+}
+
+/* Public: Sets the value of a key in a writer's sub-tables.
+ *
+ * writer - The writer to add the key through.
+ * elem - The element to set as the value of key.
+ * key - The key to set the value of.
+ * release_function - A function to call when elem is removed
+ *                    from the table, or NULL to call no function.
+ *
+ * Returns true if the element was added successfully;
+ * otherwise, false is returned and the table is unchanged.
+ */
+bool sharded_table_writer_set(sharded_table_writer *writer, void *elem, char *key, void (*release_function)(void *)) {
+	return sharded_table_writer_set_bytes(writer, elem, key, strlen(key), release_function);
+}
+
+/* Public: Sets the value of a key of arbitrary bytes in a writer's
+ *         sub-tables. If a key is set through more than one writer
+ *         before a merge, which value it is left with is undefined.
+ *
+ * writer - The writer to add the key through.
+ * elem - The element to set as the value of key.
+ * key - The key to set the value of.
+ * length - The length of the key in bytes.
+ * release_function - A function to call when elem is removed
+ *                    from the table, or NULL to call no function.
+ *
+ * Returns true if the element was added successfully;
+ * otherwise, false is returned and the table is unchanged.
+ */
+bool sharded_table_writer_set_bytes(sharded_table_writer *writer, void *elem, const void *key, size_t length, void (*release_function)(void *)) {
+	sharded_table *table = writer->table;
+	uint64_t hash = table->hash_function(key, length, table->seed);
+	unsigned int index = _sharded_table_shard(table, hash);
+
+	if (writer->shards[index] == NULL) {
+		writer->shards[index] = _sharded_table_new_shard(table, 0);
+		if (writer->shards[index] == NULL) {
+			return false;
+		}
+	}
+
+	return _hash_table_set(writer->shards[index], elem, key, length, hash, release_function);
+}
+
+/* Public: Moves the keys added through every writer into the
+ *         table's shards, using several threads. No writer may be
+ *         used, or created, until this returns; afterwards, writers
+ *         can be used to add more keys before the next merge.
+ *
+ * table - The table to merge.
+ * threads - The largest number of threads to use, counting the
+ *           calling thread, or zero for one per available processor.
+ *
+ * Returns true if every key was merged. Otherwise, false is
+ * returned, and the values of keys that couldn't be merged may have
+ * been released.
+ */
+bool sharded_table_merge(sharded_table *table, unsigned int threads) {
+	if (threads == 0) {
+		threads = _sharded_table_processors();
+	}
+
+	if (threads > table->shard_count) {
+		threads = table->shard_count;
+	}
+
+	sharded_table_merge_work work = { table, 0, true };
+
+	pthread_t *workers = malloc(threads * sizeof(pthread_t));
+	unsigned int started = 0;
+
+	/* The calling thread merges too, so that the merge still
+	 * finishes if no threads can be started.
+	 */
+	while (workers != NULL && started + 1 < threads &&
+		pthread_create(&workers[started], NULL, _sharded_table_merge_worker, &work) == 0) {
+		started++;
+	}
+
+	_sharded_table_merge_worker(&work);
+
+	unsigned int i = 0;
+	for (i = 0; i < started; i++) {
+		pthread_join(workers[i], NULL);
+	}
+
+	free(workers);
+
+	return work.merged;
+}
+
+/* Public: Sets the value of a key directly in a table's shards.
+ *         This must not be called at the same time as any other
+ *         function on the table.
+ *
+ * table - The table to set the value in.
+ * elem - The element to set as the value of key.
+ * key - The key to set the value of.
+ * release_function - A function to call when elem is removed
+ *                    from the table, or NULL to call no function.
+ *
+ * Returns true if the element was added successfully;
+ * otherwise, false is returned and the table is unchanged.
+ */
+bool sharded_table_set(sharded_table *table, void *elem, char *key, void (*release_function)(void *)) {
+	return sharded_table_set_bytes(table, elem, key, strlen(key), release_function);
+}
+
+/* Public: Sets the value of a key of arbitrary bytes directly in a
+ *         table's shards. This must not be called at the same time
+ *         as any other function on the table.
+ *
+ * table - The table to set the value in.
+ * elem - The element to set as the value of key.
+ * key - The key to set the value of.
+ * length - The length of the key in bytes.
+ * release_function - A function to call when elem is removed
+ *                    from the table, or NULL to call no function.
+ *
+ * Returns true if the element was added successfully;
+ * otherwise, false is returned and the table is unchanged.
+ */
+bool sharded_table_set_bytes(sharded_table *table, void *elem, const void *key, size_t length, void (*release_function)(void *)) {
+	uint64_t hash = table->hash_function(key, length, table->seed);
+
+	return _hash_table_set(table->shards[_sharded_table_shard(table, hash)], elem, key, length, hash, release_function);
+}
+
+/* Public: Gets the value of a key in a table's shards. Keys added
+ *         through writers can only be found once they are merged.
+ *
+ * table - The table to get the value from.
+ * key - The key to get the value of.
+ *
+ * Returns the value of key in table, or NULL if
+ * the element couldn't be found.
+ */
+void *sharded_table_get(sharded_table *table, char *key) {
+	return sharded_table_get_bytes(table, key, strlen(key));
+}
+
+/* Public: Gets the value of a key of arbitrary bytes in a table's
+ *         shards. Keys added through writers can only be found once
+ *         they are merged.
+ *
+ * table - The table to get the value from.
+ * key - The key to get the value of.
+ * length - The length of the key in bytes.
+ *
+ * Returns the value of key in table, or NULL if
+ * the element couldn't be found.
+ */
+void *sharded_table_get_bytes(sharded_table *table, const void *key, size_t length) {
+	uint64_t hash = table->hash_function(key, length, table->seed);
+
+	return _hash_table_get(table->shards[_sharded_table_shard(table, hash)], key, length, hash);
+}
+
+/* Public: Removes a key from a table's shards, calling the release
+ *         function of its value.
+ *
+ * table - The table to remove the key from.
+ * key - The key to remove.
+ *
+ * Returns true if the key was removed, or false if it wasn't in
+ * the table's shards.
+ */
+bool sharded_table_remove(sharded_table *table, char *key) {
+	return sharded_table_remove_bytes(table, key, strlen(key));
+}
+
+/* Public: Removes a key of arbitrary bytes from a table's shards,
+ *         calling the release function of its value.
+ *
+ * table - The table to remove the key from.
+ * key - The key to remove.
+ * length - The length of the key in bytes.
+ *
+ * Returns true if the key was removed, or false if it wasn't in
+ * the table's shards.
+ */
+bool sharded_table_remove_bytes(sharded_table *table, const void *key, size_t length) {
+	uint64_t hash = table->hash_function(key, length, table->seed);
+	hash_table *shard = table->shards[_sharded_table_shard(table, hash)];
+
+	if (!_hash_table_remove(shard, key, length, hash)) {
+		return false;
+	}
+
+	_hash_table_shrink(shard);
+
+	return true;
+}
+
+/* Public: Gets the number of keys in a table's shards, not counting
+ *         keys added through writers that haven't been merged.
+ *
+ * table - The table to count the keys of.
+ *
+ * Returns the number of keys.
+ */
+unsigned long sharded_table_length(sharded_table *table) {
+	unsigned long length = 0;
+
+	unsigned int i = 0;
+	for (i = 0; i < table->shard_count; i++) {
+		length += table->shards[i]->length;
+	}
+
+	return length;
+}
+
+/* Public: Frees memory associated with a sharded table and its
+ *         writers, calling the release functions of every value,
+ *         including those of keys that haven't been merged.
+ *
+ * table - The table to free.
+ *
+ * Returns nothing.
+ */
+void sharded_table_free(sharded_table *table) {
+	unsigned int i = 0;
+
+	while (table->writers != NULL) {
+		sharded_table_writer *writer = table->writers;
+		table->writers = writer->next;
+
+		for (i = 0; i < table->shard_count; i++) {
+			if (writer->shards[i] != NULL) {
+				hash_table_free(writer->shards[i]);
+			}
+		}
+
+		free(writer->shards);
+		free(writer);
+	}
+
+	for (i = 0; i < table->shard_count; i++) {
+		if (table->shards[i] != NULL) {
+			hash_table_free(table->shards[i]);
+		}
+	}
+
+	free(table->shards);
+	pthread_mutex_destroy(&table->writers_lock);
+	free(table);
+}
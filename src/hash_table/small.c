@@ -0,0 +1,362 @@
+/*
+ *  small.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/18/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include "hash_table_private.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+/* A small table keeps its items packed at the start of its slots,
+ * in the order they were added, with no index. Each item has a
+ * four-byte tag holding its key's length in the high byte and the
+ * key's first three bytes below it, and a key is found by comparing
+ * its tag with all of the table's tags at once, then comparing
+ * only the keys whose tags match. Keys are never hashed until the
+ * table outgrows HASH_TABLE_SMALL_SIZE items and moves into the
+ * storage of its layout.
+ *
+ * The slots grow SLOT_STEP items at a time, since there are never
+ * more than a few; bucket_count is the number there is room for.
+ */
+#define SLOT_STEP 2
+
+#if HASH_TABLE_SMALL_SIZE != 8
+#error "_small_match compares exactly eight tags"
+#endif
+
+/* Private: Gets the tag of a key in a small table.
+ *
+ * key - The key to get the tag of.
+ * length - The length of the key in bytes.
+ *
+ * Returns the tag.
+ */
+static inline uint32_t _small_tag(const void *key, size_t length) {
+	const unsigned char *bytes = key;
+	uint32_t tag = (uint32_t)(length & 0xff) << 24;
+
+	size_t i = 0;
+	for (i = 0; i < 3 && i < length; i++) {
+		tag |= (uint32_t)bytes[i] << (8 * i);
+	}
+
+	return tag;
+}
+
+/* Private: Finds the tags of a small table equal to a tag.
+ *
+ * tags - The table's HASH_TABLE_SMALL_SIZE tags.
+ * tag - The tag to look for.
+ *
+ * Returns a mask with bit i set if tags[i] matches, including tags
+ * past the table's length.
+ */
+static inline unsigned int _small_match(const uint32_t *tags, uint32_t tag) {
+#if defined(__SSE2__)
+	__m128i value = _mm_set1_epi32(tag);
+	__m128i low = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)tags), value);
+	__m128i high = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(tags + 4)), value);
+	return _mm_movemask_ps(_mm_castsi128_ps(low)) | (_mm_movemask_ps(_mm_castsi128_ps(high)) << 4);
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	uint32x4_t value = vdupq_n_u32(tag);
+	uint16x4_t low = vmovn_u32(vceqq_u32(vld1q_u32(tags), value));
+	uint16x4_t high = vmovn_u32(vceqq_u32(vld1q_u32(tags + 4), value));
+	uint8x8_t narrowed = vmovn_u16(vcombine_u16(low, high));
+	uint64_t bytes = vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x0101010101010101ULL;
+
+	/* Gathers the low bit of each byte into the top byte, in order.
+	 */
+	return (bytes * 0x0102040810204080ULL) >> 56;
+#else
+	unsigned int mask = 0;
+
+	int i = 0;
+	for (i = 0; i < HASH_TABLE_SMALL_SIZE; i++) {
+		if (tags[i] == tag) {
+			mask |= 1U << i;
+		}
+	}
+
+	return mask;
+#endif
+}
+
+/* Private: Finds the slot holding a key in a small table.
+ *
+ * table - The table to search.
+ * key - The key to look for.
+ * length - The length of the key in bytes.
+ * tag - The key's tag, from _small_tag.
+ *
+ * Returns the index of the key's slot, or the table's length if it
+ * isn't in the table.
+ */
+static inline unsigned int _hash_table_small_find(hash_table *table, const void *key, size_t length, uint32_t tag) {
+	HASH_TABLE_COUNT(table, searches, 1);
+
+	unsigned int mask = _small_match(table->small_tags, tag) & ((1U << table->length) - 1);
+	while (mask != 0) {
+		unsigned int i = __builtin_ctz(mask);
+		hash_table_item *item = &table->slots[i];
+
+		HASH_TABLE_COUNT(table, comparisons, 1);
+		if (item->key_length == length && memcmp(key, item->key, length) == 0) {
+			return i;
+		}
+
+		mask &= mask - 1;
+	}
+
+	return table->length;
+}
+
+/* Private: Finds the item of a key in a small table, adding it
+ *          with a NULL value if it isn't there and there is room.
+ *
+ * table - The table to find the key in.
+ * key - The key to find.
+ * length - The length of the key in bytes.
+ * inserted - Set to whether the key was added.
+ *
+ * Returns the key's item, or NULL if it couldn't be added, either
+ * because the table already holds HASH_TABLE_SMALL_SIZE items or
+ * because memory couldn't be allocated; the table is unchanged.
+ */
+hash_table_item *_hash_table_small_insert(hash_table *table, const void *key, size_t length, bool *inserted) {
+	uint32_t tag = _small_tag(key, length);
+
+	unsigned int i = _hash_table_small_find(table, key, length, tag);
+	if (i < table->length) {
+		return &table->slots[i];
+	}
+
+	if (table->length == HASH_TABLE_SMALL_SIZE) {
+		return NULL;
+	}
+
+	if (table->length == table->bucket_count) {
+		unsigned int count = table->bucket_count + SLOT_STEP;
+		hash_table_item *slots = realloc(table->slots, count * sizeof(hash_table_item));
+		if (slots == NULL) {
+			return NULL;
+		}
+
+		table->slots = slots;
+		table->bucket_count = count;
+	}
+
+	hash_table_item *item = &table->slots[table->length];
+	if (!_hash_table_item_init(table, item, NULL, key, length, 0, NULL)) {
+		return NULL;
+	}
+
+	table->small_tags[table->length] = tag;
+	table->length++;
+	table->occupied_buckets = table->length;
+	*inserted = true;
+
+	return item;
+}
+
+/* Private: Gets the value of a key in a small table.
+ *
+ * table - The table to get the value from.
+ * key - The key to get the value of.
+ * length - The length of the key in bytes.
+ *
+ * Returns the value of key in table, or NULL if
+ * the element couldn't be found.
+ */
+void *_hash_table_small_get(hash_table *table, const void *key, size_t length) {
+	unsigned int i = _hash_table_small_find(table, key, length, _small_tag(key, length));
+
+	return (i < table->length) ? table->slots[i].value : NULL;
+}
+
+/* Private: Removes a key from a small table, calling the release
+ *          function of its value. Later items are moved back, so
+ *          the rest stay in the order they were added.
+ *
+ * table - The table to remove the key from.
+ * key - The key to remove.
+ * length - The length of the key in bytes.
+ *
+ * Returns true if the key was found and removed.
+ */
+bool _hash_table_small_remove(hash_table *table, const void *key, size_t length) {
+	unsigned int i = _hash_table_small_find(table, key, length, _small_tag(key, length));
+	if (i == table->length) {
+		return false;
+	}
+
+	_hash_table_item_release(table, &table->slots[i]);
+
+	table->length--;
+	table->occupied_buckets = table->length;
+
+	memmove(&table->slots[i], &table->slots[i + 1], (table->length - i) * sizeof(hash_table_item));
+	memmove(&table->small_tags[i], &table->small_tags[i + 1], (table->length - i) * sizeof(uint32_t));
+
+	return true;
+}
+
+/* Private: Copies every item of a small table into an array,
+ *          hashing each key, since small tables don't store hashes.
+ *
+ * table - The table to copy the items of.
+ * items - An array with room for every item.
+ *
+ * Returns nothing.
+ */
+void _hash_table_small_collect(hash_table *table, hash_table_item *items) {
+	unsigned int i = 0;
+	for (i = 0; i < table->length; i++) {
+		items[i] = table->slots[i];
+		items[i].hash = _hash_table_hash(table, items[i].key, items[i].key_length);
+	}
+}
+
+/* Private: Visits every item of a small table, in the order they
+ *          were added.
+ *
+ * table - The table to visit the items of.
+ * visit - The function to call with each item's key, key length,
+ *         value, and context.
+ * context - The pointer to pass to visit.
+ *
+ * Returns nothing.
+ */
+void _hash_table_small_foreach(hash_table *table, void (*visit)(const char *, size_t, void *, void *), void *context) {
+	unsigned int i = 0;
+	for (i = 0; i < table->length; i++) {
+		hash_table_item *item = &table->slots[i];
+		visit(item->key, item->key_length, item->value, context);
+	}
+}
+
+/* Private: Moves the items of a small table into the storage of its
+ *          layout, sized to hold a number of items, hashing each key.
+ *          The new storage is built in a separate table first, so
+ *          the small table is only changed once every item is in it.
+ *
+ * table - The table to grow.
+ * capacity - The number of items the table should hold.
+ *
+ * Returns true if the table was grown; otherwise, false is returned
+ * and the table is unchanged.
+ */
+bool _hash_table_small_grow(hash_table *table, unsigned int capacity) {
+	HASH_TABLE_RESIZE_START();
+
+	hash_table_options options = {
+		.layout = table->layout,
+		.incremental_resize = table->incremental_resize,
+		.capacity = capacity,
+		.arena = table->arena,
+		.value_size = table->value_size
+	};
+
+	hash_table *grown = _hash_table_new_with_size(_hash_table_size_for_capacity(table->layout, capacity), &options);
+	if (grown == NULL) {
+		return false;
+	}
+
+	grown->hash_function = table->hash_function;
+	grown->seed = table->seed;
+
+	unsigned int i = 0;
+	for (i = 0; i < table->length; i++) {
+		hash_table_item *item = &table->slots[i];
+		uint64_t hash = _hash_table_hash(table, item->key, item->key_length);
+		if (!_hash_table_set(grown, item->value, item->key, item->key_length, hash, item->release_function)) {
+			break;
+		}
+	}
+
+	if (i < table->length) {
+		hash_table_item items[HASH_TABLE_SMALL_SIZE];
+		_hash_table_collect_items(grown, items);
+		_hash_table_discard_storage(grown, items, grown->length);
+		free(grown);
+
+		return false;
+	}
+
+	if (!table->arena) {
+		for (i = 0; i < table->length; i++) {
+			free(table->slots[i].key);
+		}
+	}
+
+	free(table->slots);
+
+	/* The new keys were carved out of the new table's slabs, which
+	 * go in front of the old ones so they are freed together.
+	 */
+	if (grown->slabs != NULL) {
+		hash_table_slab *last = grown->slabs;
+		while (last->next != NULL) {
+			last = last->next;
+		}
+
+		last->next = table->slabs;
+		table->slabs = grown->slabs;
+	}
+
+	table->small = false;
+	table->bucket_count = grown->bucket_count;
+	table->occupied_buckets = grown->occupied_buckets;
+	table->items = grown->items;
+	table->control = grown->control;
+	table->slots = grown->slots;
+	table->distances = grown->distances;
+	table->index = grown->index;
+	table->index_width = grown->index_width;
+	table->entry_count = grown->entry_count;
+	table->entry_capacity = grown->entry_capacity;
+
+	free(grown);
+
+	HASH_TABLE_RESIZE_END(table);
+
+	return true;
+}
+
+/* Private: Releases every item of a small table, keeping its slots.
+ *          Items are only visited if they have anything to free.
+ *
+ * table - The table to clear.
+ *
+ * Returns nothing.
+ */
+void _hash_table_small_clear(hash_table *table) {
+	if (!table->arena || table->releases_values) {
+		unsigned int i = 0;
+		for (i = 0; i < table->length; i++) {
+			_hash_table_item_release(table, &table->slots[i]);
+		}
+	}
+
+	table->length = 0;
+	table->occupied_buckets = 0;
+}
+
+/* Private: Frees the items and slots of a small table.
+ *
+ * table - The table to free.
+ *
+ * Returns nothing.
+ */
+void _hash_table_small_free(hash_table *table) {
+	_hash_table_small_clear(table);
+
+	free(table->slots);
+}
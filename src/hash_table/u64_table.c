@@ -0,0 +1,338 @@
+/*
+ *  u64_table.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <limits.h>
+
+#include "u64_table.h"
+
+/* Keys are stored inline in one flat array of slots, probed
+ * linearly from each key's home slot. The home slot is taken from
+ * the high bits of the key multiplied by MIX_MULTIPLIER, after its
+ * high half has been folded into its low half, so that sequential
+ * and strided IDs spread over the whole table. Removal shifts
+ * later items back rather than leaving a marker, so probes only
+ * ever stop at empty slots.
+ */
+#define INITIAL_SIZE 16
+#define MIX_MULTIPLIER 0x9e3779b97f4a7c15ULL
+#define MAX_LOAD_NUMERATOR 3
+#define MAX_LOAD_DENOMINATOR 4
+
+typedef struct u64_table_slot {
+	uint64_t key;
+	uint64_t value;
+} u64_table_slot;
+
+unsigned int _u64_table_size_for_capacity(unsigned int capacity);
+bool _u64_table_resize(u64_table *table, unsigned int size);
+u64_table_slot *_u64_table_find(u64_table *table, uint64_t key);
+
+/* Private: Gets the home slot of a key.
+ *
+ * table - The table the key belongs to.
+ * key - The key, which must not be zero.
+ *
+ * Returns the index of the key's home slot.
+ */
+static inline size_t _u64_table_home(const u64_table *table, uint64_t key) {
+	return ((key ^ (key >> 32)) * MIX_MULTIPLIER) >> table->shift;
+}
+
+/* Private: Gets the number of slots needed to hold a number of
+ *          items without growing.
+ *
+ * capacity - The number of items to hold.
+ *
+ * Returns the number of slots, a power of two, or zero if it
+ * would be too large.
+ */
+unsigned int _u64_table_size_for_capacity(unsigned int capacity) {
+	unsigned int size = INITIAL_SIZE;
+	while ((uint64_t)size * MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR < capacity) {
+		if (size > UINT_MAX / 2) {
+			return 0;
+		}
+
+		size *= 2;
+	}
+
+	return size;
+}
+
+/* Private: Moves every item of a table to a new array of slots.
+ *
+ * table - The table to resize.
+ * size - The new number of slots, a power of two.
+ *
+ * Returns true if the table was resized; otherwise, false is
+ * returned and the table is unchanged.
+ */
+bool _u64_table_resize(u64_table *table, unsigned int size) {
+	u64_table_slot *slots = calloc(size, sizeof(u64_table_slot));
+	if (slots == NULL) {
+		return false;
+	}
+
+	u64_table_slot *old_slots = table->slots;
+	unsigned int old_size = table->bucket_count;
+
+	table->slots = slots;
+	table->bucket_count = size;
+	table->shift = 64 - __builtin_ctz(size);
+
+	size_t mask = size - 1;
+	unsigned int i = 0;
+	for (i = 0; i < old_size; i++) {
+		if (old_slots[i].key == 0) {
+			continue;
+		}
+
+		size_t index = _u64_table_home(table, old_slots[i].key);
+		while (slots[index].key != 0) {
+			index = (index + 1) & mask;
+		}
+
+		slots[index] = old_slots[i];
+	}
+
+	free(old_slots);
+
+	return true;
+}
+
+/* Private: Finds the slot holding a key, or the empty slot where
+ *          it would be placed.
+ *
+ * table - The table to search.
+ * key - The key to look for, which must not be zero.
+ *
+ * Returns the slot, whose key is either the key or zero.
+ */
+u64_table_slot *_u64_table_find(u64_table *table, uint64_t key) {
+	size_t mask = table->bucket_count - 1;
+	size_t index = _u64_table_home(table, key);
+
+	while (table->slots[index].key != key && table->slots[index].key != 0) {
+		index = (index + 1) & mask;
+	}
+
+	return &table->slots[index];
+}
+
+/* Public: Creates a new table of 64-bit keys.
+ *
+ * Returns the new table, or NULL if it couldn't be created.
+ */
+u64_table *u64_table_new() {
+	return u64_table_new_with_capacity(0);
+}
+
+/* Public: Creates a new table of 64-bit keys sized to hold a
+ *         number of items without resizing.
+ *
+ * capacity - The number of items the table should hold.
+ *
+ * Returns the new table, or NULL if it couldn't be created.
+ */
+u64_table *u64_table_new_with_capacity(unsigned int capacity) {
+	unsigned int size = _u64_table_size_for_capacity(capacity);
+	if (size == 0) {
+		return NULL;
+	}
+
+	u64_table *table = malloc(sizeof(u64_table));
+	if (table == NULL) {
+		return NULL;
+	}
+
+	table->bucket_count = 0;
+	table->length = 0;
+	table->slots = NULL;
+	table->has_zero_key = false;
+	table->zero_value = 0;
+
+	if (!_u64_table_resize(table, size)) {
+		free(table);
+		return NULL;
+	}
+
+	return table;
+}
+
+/* Public: Grows a table, if needed, so that it can hold a number
+ *         of items without resizing again.
+ *
+ * table - The table to grow.
+ * capacity - The number of items the table should hold.
+ *
+ * Returns true if the table can hold capacity items; otherwise,
+ * false is returned and the table is unchanged.
+ */
+bool u64_table_reserve(u64_table *table, unsigned int capacity) {
+	unsigned int size = _u64_table_size_for_capacity(capacity);
+	if (size == 0) {
+		return false;
+	}
+
+	return size <= table->bucket_count || _u64_table_resize(table, size);
+}
+
+/* Public: Sets the integer value of a key, replacing any value it
+ *         already has.
+ *
+ * table - The table to add the key to.
+ * key - The key to set.
+ * value - The value to give the key.
+ *
+ * Returns true if the key was set; otherwise, false is returned
+ * and the table is unchanged.
+ */
+bool u64_table_set_u64(u64_table *table, uint64_t key, uint64_t value) {
+	if (key == 0) {
+		table->length += !table->has_zero_key;
+		table->has_zero_key = true;
+		table->zero_value = value;
+		return true;
+	}
+
+	u64_table_slot *slot = _u64_table_find(table, key);
+	if (slot->key == key) {
+		slot->value = value;
+		return true;
+	}
+
+	if ((uint64_t)(table->length + 1) * MAX_LOAD_DENOMINATOR > (uint64_t)table->bucket_count * MAX_LOAD_NUMERATOR) {
+		if (table->bucket_count > UINT_MAX / 2 || !_u64_table_resize(table, table->bucket_count * 2)) {
+			return false;
+		}
+
+		slot = _u64_table_find(table, key);
+	}
+
+	slot->key = key;
+	slot->value = value;
+	table->length++;
+
+	return true;
+}
+
+/* Public: Gets the integer value of a key.
+ *
+ * table - The table to get the value from.
+ * key - The key to get the value of.
+ * value - Set to the key's value, if it is in the table.
+ *
+ * Returns true if the key is in the table.
+ */
+bool u64_table_get_u64(u64_table *table, uint64_t key, uint64_t *value) {
+	if (key == 0) {
+		*value = table->zero_value;
+		return table->has_zero_key;
+	}
+
+	u64_table_slot *slot = _u64_table_find(table, key);
+	*value = slot->value;
+
+	return slot->key != 0;
+}
+
+/* Public: Sets the value of a key, replacing any value it already
+ *         has. Values are not freed by the table.
+ *
+ * table - The table to add the key to.
+ * key - The key to set.
+ * value - The value to give the key.
+ *
+ * Returns true if the key was set; otherwise, false is returned
+ * and the table is unchanged.
+ */
+bool u64_table_set(u64_table *table, uint64_t key, void *value) {
+	return u64_table_set_u64(table, key, (uintptr_t)value);
+}
+
+/* Public: Gets the value of a key.
+ *
+ * table - The table to get the value from.
+ * key - The key to get the value of.
+ *
+ * Returns the value of key in table, or NULL if
+ * the key couldn't be found.
+ */
+void *u64_table_get(u64_table *table, uint64_t key) {
+	uint64_t value = 0;
+	if (!u64_table_get_u64(table, key, &value)) {
+		return NULL;
+	}
+
+	return (void *)(uintptr_t)value;
+}
+
+/* Public: Removes a key from a table. The items after it in its
+ *         run of full slots are shifted back into the gap, unless
+ *         that would move them before their home slots.
+ *
+ * table - The table to remove the key from.
+ * key - The key to remove.
+ *
+ * Returns true if the key was removed, or false if it wasn't in
+ * the table.
+ */
+bool u64_table_remove(u64_table *table, uint64_t key) {
+	if (key == 0) {
+		if (!table->has_zero_key) {
+			return false;
+		}
+
+		table->has_zero_key = false;
+		table->zero_value = 0;
+		table->length--;
+		return true;
+	}
+
+	u64_table_slot *slot = _u64_table_find(table, key);
+	if (slot->key == 0) {
+		return false;
+	}
+
+	size_t mask = table->bucket_count - 1;
+	size_t gap = slot - table->slots;
+	size_t index = gap;
+
+	while (true) {
+		index = (index + 1) & mask;
+		if (table->slots[index].key == 0) {
+			break;
+		}
+
+		/* An item can fill the gap if its home is not after the
+		 * gap, going around from the item's slot.
+		 */
+		size_t home = _u64_table_home(table, table->slots[index].key);
+		if (((index - home) & mask) >= ((index - gap) & mask)) {
+			table->slots[gap] = table->slots[index];
+			gap = index;
+		}
+	}
+
+	table->slots[gap].key = 0;
+	table->slots[gap].value = 0;
+	table->length--;
+
+	return true;
+}
+
+/* Public: Frees memory associated with a table of 64-bit keys.
+ *
+ * table - The table to free.
+ *
+ * Returns nothing.
+ */
+void u64_table_free(u64_table *table) {
+	free(table->slots);
+	free(table);
+}
@@ -0,0 +1,132 @@
+/*
+ *  test/cache.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "cache.h"
+
+#define TEST_KEYS 10000
+
+/* Counts the values that leave a cache and adds up their sizes,
+ * which are the values themselves.
+ */
+typedef struct {
+    int evicted;
+    size_t size;
+} cache_test_evictions;
+
+void cache_test_count_eviction(const char *key, size_t length, void *value, void *context) {
+    cache_test_evictions *evictions = context;
+    evictions->evicted++;
+    evictions->size += (size_t)value;
+}
+
+/* Fills a cache with four keys, uses the first, and adds a fifth,
+ * which must evict the second under both policies.
+ */
+bool cache_policy_test(cache_policy policy) {
+    cache_test_evictions evictions = { 0, 0 };
+    cache_options options = { .policy = policy, .capacity = 4, .evict_function = &cache_test_count_eviction, .evict_context = &evictions };
+    cache *cache = cache_new_with_options(&options);
+    if (cache == NULL) {
+        printf("ERROR: Could not create cache with policy %d\n", policy);
+        return false;
+    }
+    
+    cache_put(cache, (void *)1, "a", 1);
+    cache_put(cache, (void *)1, "b", 1);
+    cache_put(cache, (void *)1, "c", 1);
+    cache_put(cache, (void *)1, "d", 1);
+    
+    if (cache_get(cache, "a") != (void *)1 || cache_get(cache, "e") != NULL || evictions.evicted != 0) {
+        printf("ERROR: Cache with policy %d lost keys before it was full\n", policy);
+        return false;
+    }
+    
+    cache_put(cache, (void *)1, "e", 1);
+    
+    if (cache_get(cache, "b") != NULL || cache_get(cache, "a") == NULL || cache_get(cache, "e") == NULL ||
+        evictions.evicted != 1 || cache->length != 4 || cache->size != 4) {
+        printf("ERROR: Cache with policy %d evicted the wrong key\n", policy);
+        return false;
+    }
+    
+    /* A key over the capacity is refused, and one that needs room
+     * for three evicts as many of the oldest keys as it takes.
+     */
+    if (cache_put(cache, (void *)5, "big", 5) || !cache_put(cache, (void *)3, "medium", 3) ||
+        cache->length != 2 || cache->size != 4 || cache_get(cache, "medium") != (void *)3) {
+        printf("ERROR: Cache with policy %d didn't evict by size\n", policy);
+        return false;
+    }
+    
+    if (!cache_put(cache, (void *)1, "medium", 1) || cache->size != 2 || evictions.size != 7 ||
+        !cache_remove(cache, "medium") || cache_remove(cache, "medium") || cache->length != 1) {
+        printf("ERROR: Cache with policy %d didn't replace or remove a key\n", policy);
+        return false;
+    }
+    
+    cache_free(cache);
+    
+    if (evictions.evicted != 7 || evictions.size != 9) {
+        printf("ERROR: Cache with policy %d evicted %d values\n", policy, evictions.evicted);
+        return false;
+    }
+    
+    return true;
+}
+
+/* Keeps a small set of keys hot while streaming many others
+ * through a cache, which must keep every hot key.
+ */
+bool cache_hot_keys_test(cache_policy policy) {
+    cache_options options = { .policy = policy, .capacity = 100 };
+    cache *cache = cache_new_with_options(&options);
+    static int values[TEST_KEYS];
+    char key[32];
+    
+    int i = 0;
+    for (i = 0; i < TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "hot:%d", i % 10);
+        if (cache_get(cache, key) == NULL) {
+            cache_put(cache, &values[i % 10], key, 1);
+        }
+        
+        snprintf(key, sizeof(key), "cold:%d", i);
+        cache_put(cache, &values[i], key, 1);
+        
+        if (i >= 10 && cache_get(cache, "hot:0") != &values[0]) {
+            printf("ERROR: Cache with policy %d evicted a hot key\n", policy);
+            return false;
+        }
+    }
+    
+    snprintf(key, sizeof(key), "cold:%d", TEST_KEYS - 1);
+    if (cache->length != 100 || cache_get(cache, key) != &values[TEST_KEYS - 1] || cache_get(cache, "cold:0") != NULL) {
+        printf("ERROR: Cache with policy %d holds %u keys\n", policy, cache->length);
+        return false;
+    }
+    
+    cache_free(cache);
+    
+    return true;
+}
+
+bool cache_test() {
+    cache_policy policies[] = { CACHE_LRU, CACHE_CLOCK };
+    
+    int i = 0;
+    for (i = 0; i < sizeof(policies) / sizeof(policies[0]); i++) {
+        if (!cache_policy_test(policies[i]) || !cache_hot_keys_test(policies[i])) {
+            return false;
+        }
+    }
+    
+    return true;
+}
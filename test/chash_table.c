@@ -0,0 +1,193 @@
+/*
+ *  test/chash_table.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "chash_table.h"
+
+#define PREFILLED_KEYS 20000
+#define WRITTEN_KEYS 20000
+#define WRITER_THREADS 4
+#define READER_THREADS 4
+
+static int values[PREFILLED_KEYS + WRITTEN_KEYS];
+static unsigned long released = 0;
+
+typedef struct {
+    chash_table *table;
+    int start;
+    int end;
+    bool remove;
+    bool *stop;
+    bool ok;
+} chash_table_worker;
+
+void chash_table_count_release(void *value) {
+    __atomic_add_fetch(&released, 1, __ATOMIC_RELAXED);
+}
+
+/* Sets, or removes every other one of, a range of keys.
+ */
+void *chash_table_writer(void *context) {
+    chash_table_worker *worker = context;
+    char key[32];
+
+    int i = 0;
+    for (i = worker->start; i < worker->end; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+
+        if (worker->remove) {
+            if (i % 2 == 0 && !chash_table_remove(worker->table, key)) {
+                worker->ok = false;
+            }
+        } else if (!chash_table_set(worker->table, &values[i], key, &chash_table_count_release)) {
+            worker->ok = false;
+        }
+    }
+
+    return NULL;
+}
+
+/* Checks the prefilled keys until told to stop, while writers
+ * change and grow the table.
+ */
+void *chash_table_reader(void *context) {
+    chash_table_worker *worker = context;
+    char key[32];
+
+    do {
+        int i = 0;
+        for (i = worker->start; i < worker->end; i++) {
+            snprintf(key, sizeof(key), "key:%d", i);
+
+            if (chash_table_get(worker->table, key) != &values[i]) {
+                worker->ok = false;
+            }
+        }
+    } while (!__atomic_load_n(worker->stop, __ATOMIC_ACQUIRE));
+
+    return NULL;
+}
+
+bool chash_table_run(chash_table *table, bool remove) {
+    pthread_t writers[WRITER_THREADS], readers[READER_THREADS];
+    chash_table_worker writer_workers[WRITER_THREADS], reader_workers[READER_THREADS];
+    bool stop = false, ok = true;
+
+    int i = 0;
+    for (i = 0; i < READER_THREADS; i++) {
+        reader_workers[i] = (chash_table_worker){table, 1, PREFILLED_KEYS, false, &stop, true};
+        pthread_create(&readers[i], NULL, &chash_table_reader, &reader_workers[i]);
+    }
+
+    int per_writer = WRITTEN_KEYS / WRITER_THREADS;
+    for (i = 0; i < WRITER_THREADS; i++) {
+        int start = PREFILLED_KEYS + i * per_writer;
+        writer_workers[i] = (chash_table_worker){table, start, start + per_writer, remove, &stop, true};
+        pthread_create(&writers[i], NULL, &chash_table_writer, &writer_workers[i]);
+    }
+
+    for (i = 0; i < WRITER_THREADS; i++) {
+        pthread_join(writers[i], NULL);
+        ok = ok && writer_workers[i].ok;
+    }
+
+    __atomic_store_n(&stop, true, __ATOMIC_RELEASE);
+
+    for (i = 0; i < READER_THREADS; i++) {
+        pthread_join(readers[i], NULL);
+        ok = ok && reader_workers[i].ok;
+    }
+
+    return ok;
+}
+
+bool chash_table_test() {
+    chash_table *table = chash_table_new();
+    if (table == NULL) {
+        printf("ERROR: Couldn't create concurrent hash table\n");
+        return false;
+    }
+
+    if (!chash_table_set(table, &values[0], "key:0", NULL) || chash_table_get(table, "key:0") != &values[0]) {
+        printf("ERROR: Concurrent hash table couldn't find a set key\n");
+        return false;
+    }
+
+    if (!chash_table_set(table, &values[1], "key:0", NULL) || chash_table_get(table, "key:0") != &values[1]) {
+        printf("ERROR: Concurrent hash table didn't overwrite a key\n");
+        return false;
+    }
+
+    if (!chash_table_remove(table, "key:0") || chash_table_get(table, "key:0") != NULL || chash_table_remove(table, "key:0")) {
+        printf("ERROR: Concurrent hash table didn't remove a key\n");
+        return false;
+    }
+
+    if (!chash_table_set_bytes(table, &values[2], "a\0b", 3, NULL) || chash_table_get_bytes(table, "a\0c", 3) != NULL ||
+        chash_table_get_bytes(table, "a\0b", 3) != &values[2] || chash_table_get(table, "a") != NULL) {
+        printf("ERROR: Concurrent hash table mixed up binary keys\n");
+        return false;
+    }
+
+    if (!chash_table_remove_bytes(table, "a\0b", 3) || chash_table_length(table) != 0) {
+        printf("ERROR: Concurrent hash table has the wrong length\n");
+        return false;
+    }
+
+    char key[32];
+    int i = 0;
+    for (i = 1; i < PREFILLED_KEYS; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        chash_table_set(table, &values[i], key, &chash_table_count_release);
+    }
+
+    if (!chash_table_run(table, false)) {
+        printf("ERROR: Concurrent hash table lost keys while growing\n");
+        return false;
+    }
+
+    if (chash_table_length(table) != PREFILLED_KEYS - 1 + WRITTEN_KEYS) {
+        printf("ERROR: Concurrent hash table has %lu items after concurrent sets\n", chash_table_length(table));
+        return false;
+    }
+
+    for (i = PREFILLED_KEYS; i < PREFILLED_KEYS + WRITTEN_KEYS; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+
+        if (chash_table_get(table, key) != &values[i]) {
+            printf("ERROR: Concurrent hash table lost %s\n", key);
+            return false;
+        }
+    }
+
+    if (!chash_table_run(table, true)) {
+        printf("ERROR: Concurrent hash table failed to remove keys\n");
+        return false;
+    }
+
+    for (i = PREFILLED_KEYS; i < PREFILLED_KEYS + WRITTEN_KEYS; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+
+        if ((chash_table_get(table, key) == NULL) != (i % 2 == 0)) {
+            printf("ERROR: Concurrent hash table has the wrong value for %s after removals\n", key);
+            return false;
+        }
+    }
+
+    chash_table_free(table);
+
+    if (released != PREFILLED_KEYS - 1 + WRITTEN_KEYS) {
+        printf("ERROR: Concurrent hash table released %lu values\n", released);
+        return false;
+    }
+
+    return true;
+}
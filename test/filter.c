@@ -0,0 +1,154 @@
+/*
+ *  test/filter.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "bloom_filter.h"
+#include "cuckoo_filter.h"
+
+#define TEST_KEYS 100000
+
+bool bloom_filter_test() {
+    double rates[] = { 0.1, 0.01, 0.001 };
+    char key[32];
+    
+    int r = 0;
+    for (r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        bloom_filter *filter = bloom_filter_new(TEST_KEYS, rates[r]);
+        if (filter == NULL) {
+            printf("ERROR: Could not create Bloom filter with false positive rate %f\n", rates[r]);
+            return false;
+        }
+        
+        int i = 0;
+        for (i = 0; i < TEST_KEYS; i++) {
+            snprintf(key, sizeof(key), "key:%d", i);
+            bloom_filter_add(filter, key, strlen(key));
+        }
+        
+        for (i = 0; i < TEST_KEYS; i++) {
+            snprintf(key, sizeof(key), "key:%d", i);
+            if (!bloom_filter_contains(filter, key, strlen(key))) {
+                printf("ERROR: Bloom filter lost \"%s\"\n", key);
+                return false;
+            }
+        }
+        
+        int false_positives = 0;
+        for (i = 0; i < TEST_KEYS; i++) {
+            snprintf(key, sizeof(key), "missing:%d", i);
+            false_positives += bloom_filter_contains(filter, key, strlen(key));
+        }
+        
+        /* The measured rate should be near the expected rate, which
+         * must meet the target.
+         */
+        double expected = bloom_filter_false_positive_rate(filter);
+        double measured = (double)false_positives / TEST_KEYS;
+        if (expected > rates[r] || measured > expected * 1.5 + 0.0002) {
+            printf("ERROR: Bloom filter for false positive rate %f has rate %f, expected %f\n", rates[r], measured, expected);
+            return false;
+        }
+        
+        bloom_filter_free(filter);
+    }
+    
+    return true;
+}
+
+bool cuckoo_filter_test() {
+    double rates[] = { 0.05, 0.001 };
+    char key[32];
+    
+    int r = 0;
+    for (r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        cuckoo_filter *filter = cuckoo_filter_new(TEST_KEYS, rates[r]);
+        if (filter == NULL) {
+            printf("ERROR: Could not create cuckoo filter with false positive rate %f\n", rates[r]);
+            return false;
+        }
+        
+        int i = 0;
+        for (i = 0; i < TEST_KEYS; i++) {
+            snprintf(key, sizeof(key), "key:%d", i);
+            if (!cuckoo_filter_add(filter, key, strlen(key))) {
+                printf("ERROR: Cuckoo filter filled up after %d keys\n", i);
+                return false;
+            }
+        }
+        
+        for (i = 0; i < TEST_KEYS; i += 2) {
+            snprintf(key, sizeof(key), "key:%d", i);
+            if (!cuckoo_filter_remove(filter, key, strlen(key))) {
+                printf("ERROR: Could not remove \"%s\" from cuckoo filter\n", key);
+                return false;
+            }
+        }
+        
+        int false_positives = 0;
+        for (i = 0; i < TEST_KEYS; i++) {
+            snprintf(key, sizeof(key), "key:%d", i);
+            bool contains = cuckoo_filter_contains(filter, key, strlen(key));
+            if (i % 2 == 1 && !contains) {
+                printf("ERROR: Cuckoo filter lost \"%s\"\n", key);
+                return false;
+            }
+            
+            snprintf(key, sizeof(key), "missing:%d", i);
+            false_positives += cuckoo_filter_contains(filter, key, strlen(key));
+        }
+        
+        if (filter->length != TEST_KEYS / 2 || (double)false_positives / TEST_KEYS > rates[r]) {
+            printf("ERROR: Cuckoo filter for false positive rate %f has rate %f\n", rates[r], (double)false_positives / TEST_KEYS);
+            return false;
+        }
+        
+        cuckoo_filter_clear(filter);
+        if (filter->length != 0 || cuckoo_filter_contains(filter, "key:1", 5) || !cuckoo_filter_add(filter, "key:1", 5) ||
+            !cuckoo_filter_contains(filter, "key:1", 5)) {
+            printf("ERROR: Cuckoo filter mishandled keys after being cleared\n");
+            return false;
+        }
+        
+        cuckoo_filter_free(filter);
+    }
+    
+    /* A filter that fills up refuses new keys, but keeps every key
+     * it accepted.
+     */
+    cuckoo_filter *filter = cuckoo_filter_new(100, 0.01);
+    int added = 0;
+    int i = 0;
+    for (i = 0; i < 1000; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        if (!cuckoo_filter_add(filter, key, strlen(key))) {
+            break;
+        }
+        
+        added++;
+    }
+    
+    if (added == 1000 || added < filter->bucket_count * CUCKOO_FILTER_BUCKET_SIZE / 2) {
+        printf("ERROR: Cuckoo filter with %zu buckets took %d keys\n", filter->bucket_count, added);
+        return false;
+    }
+    
+    for (i = 0; i < added; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        if (!cuckoo_filter_contains(filter, key, strlen(key))) {
+            printf("ERROR: Full cuckoo filter lost \"%s\"\n", key);
+            return false;
+        }
+    }
+    
+    cuckoo_filter_free(filter);
+    
+    return true;
+}
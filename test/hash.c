@@ -0,0 +1,120 @@
+/*
+ *  test/hash.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hash.h"
+
+#define DISTRIBUTION_KEYS 65536
+#define DISTRIBUTION_BUCKETS 1024
+
+/* Checks that keys that only differ by the order or value of a few
+ * characters spread evenly over buckets, using both the low and the
+ * high bits of the hash. The chi-squared statistic for 1023 degrees
+ * of freedom is within 1023 +/- 180 for all but about one in a
+ * million well-distributed hashes.
+ */
+bool hash_distribution_test(const char *name, uint64_t (*hash_function)(const void *, size_t, uint64_t), uint64_t seed) {
+	static unsigned int low_counts[DISTRIBUTION_BUCKETS];
+	static unsigned int high_counts[DISTRIBUTION_BUCKETS];
+
+	memset(low_counts, 0, sizeof(low_counts));
+	memset(high_counts, 0, sizeof(high_counts));
+
+	char key[32];
+	int i = 0;
+	for (i = 0; i < DISTRIBUTION_KEYS; i++) {
+		int length = snprintf(key, sizeof(key), "user:%d", i);
+		uint64_t hash = hash_function(key, length, seed);
+
+		low_counts[hash % DISTRIBUTION_BUCKETS]++;
+		high_counts[hash >> 54]++;
+	}
+
+	double expected = ((double)DISTRIBUTION_KEYS) / DISTRIBUTION_BUCKETS;
+	double low_chi_squared = 0, high_chi_squared = 0;
+	for (i = 0; i < DISTRIBUTION_BUCKETS; i++) {
+		low_chi_squared += (low_counts[i] - expected) * (low_counts[i] - expected) / expected;
+		high_chi_squared += (high_counts[i] - expected) * (high_counts[i] - expected) / expected;
+	}
+
+	if (low_chi_squared < 843 || low_chi_squared > 1203 || high_chi_squared < 843 || high_chi_squared > 1203) {
+		printf("ERROR: %s is poorly distributed (chi-squared %f and %f)\n", name, low_chi_squared, high_chi_squared);
+		return false;
+	}
+
+	return true;
+}
+
+/* Checks that flipping any one bit of a key flips about half the
+ * bits of its hash.
+ */
+bool hash_avalanche_test(const char *name, uint64_t (*hash_function)(const void *, size_t, uint64_t), uint64_t seed) {
+	unsigned char key[24];
+	unsigned long flipped = 0, trials = 0;
+
+	int round = 0;
+	for (round = 0; round < 64; round++) {
+		size_t length = 1 + round % sizeof(key);
+
+		size_t i = 0;
+		for (i = 0; i < length; i++) {
+			key[i] = (unsigned char)(round * 31 + i * 7);
+		}
+
+		uint64_t original = hash_function(key, length, seed);
+
+		for (i = 0; i < length * 8; i++) {
+			key[i / 8] ^= 1 << (i % 8);
+			flipped += __builtin_popcountll(original ^ hash_function(key, length, seed));
+			key[i / 8] ^= 1 << (i % 8);
+			trials++;
+		}
+	}
+
+	double average = ((double)flipped) / trials;
+	if (average < 31 || average > 33) {
+		printf("ERROR: %s flips %f output bits per input bit\n", name, average);
+		return false;
+	}
+
+	return true;
+}
+
+bool hash_test() {
+	if (hash_fast("user:12", 7, 0) == hash_fast("user:21", 7, 0)) {
+		printf("ERROR: hash_fast collides on anagrams\n");
+		return false;
+	}
+
+	if (hash_fast("", 0, 0) == hash_fast("", 0, 1) || hash_keyed("key", 3, 1) == hash_keyed("key", 3, 2)) {
+		printf("ERROR: Hashes ignore their seeds\n");
+		return false;
+	}
+
+	if (hash_random_seed() == hash_random_seed()) {
+		printf("ERROR: hash_random_seed repeated a seed\n");
+		return false;
+	}
+
+	/* A fixed seed keeps the statistical checks repeatable
+	 */
+	uint64_t seed = 0x9e3779b97f4a7c15ULL;
+
+	if (!hash_distribution_test("hash_fast", &hash_fast, 0) || !hash_distribution_test("hash_keyed", &hash_keyed, seed)) {
+		return false;
+	}
+
+	if (!hash_avalanche_test("hash_fast", &hash_fast, 0) || !hash_avalanche_test("hash_keyed", &hash_keyed, seed)) {
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,205 @@
+/*
+ *  test/hash_set.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/18/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hash_set.h"
+
+#define TEST_KEYS 20000
+
+/* Makes the ith test key, alternating between keys short enough to
+ * be inline and keys that aren't.
+ */
+static void hash_set_test_key(char *key, size_t size, int i) {
+    if (i % 2 == 0) {
+        snprintf(key, size, "%d", i);
+    } else {
+        snprintf(key, size, "a much longer key:%d", i);
+    }
+}
+
+static void hash_set_test_count(const char *key, size_t length, void *context) {
+    if (strlen(key) == length) {
+        (*(int *)context)++;
+    }
+}
+
+/* Checks that a set holds exactly the test keys below count for
+ * which wanted returns true.
+ */
+static bool hash_set_test_check(const char *name, hash_set *set, int count, bool (*wanted)(int i)) {
+    char key[64];
+    int expected = 0;
+    
+    int i = 0;
+    for (i = 0; i < count; i++) {
+        hash_set_test_key(key, sizeof(key), i);
+        if (hash_set_contains(set, key) != wanted(i)) {
+            printf("ERROR: %s of sets is wrong about \"%s\"\n", name, key);
+            return false;
+        }
+        
+        expected += wanted(i);
+    }
+    
+    int visited = 0;
+    hash_set_foreach(set, hash_set_test_count, &visited);
+    
+    if (set->length != expected || visited != expected) {
+        printf("ERROR: %s of sets has %u keys and visited %d, expected %d\n", name, set->length, visited, expected);
+        return false;
+    }
+    
+    return true;
+}
+
+static bool hash_set_test_in_both(int i) {
+    return i % 2 == 0 && i % 3 == 0;
+}
+
+static bool hash_set_test_in_either(int i) {
+    return i % 2 == 0 || i % 3 == 0;
+}
+
+static bool hash_set_test_in_first(int i) {
+    return i % 2 == 0 && i % 3 != 0;
+}
+
+bool hash_set_ops_test(hash_set_options *first_options, hash_set_options *second_options) {
+    hash_set *first = hash_set_new_with_options(first_options);
+    hash_set *second = hash_set_new_with_options(second_options);
+    if (first == NULL || second == NULL) {
+        printf("ERROR: Could not create sets\n");
+        return false;
+    }
+    
+    char key[64];
+    int i = 0;
+    for (i = 0; i < TEST_KEYS; i++) {
+        hash_set_test_key(key, sizeof(key), i);
+        if ((i % 2 == 0 && !hash_set_insert(first, key)) || (i % 3 == 0 && !hash_set_insert(second, key))) {
+            printf("ERROR: Could not add \"%s\" to sets\n", key);
+            return false;
+        }
+    }
+    
+    hash_set *both = hash_set_intersection(first, second);
+    hash_set *either = hash_set_union(first, second);
+    hash_set *only_first = hash_set_difference(first, second);
+    if (both == NULL || either == NULL || only_first == NULL) {
+        printf("ERROR: Could not combine sets\n");
+        return false;
+    }
+    
+    if (!hash_set_test_check("Intersection", both, TEST_KEYS, hash_set_test_in_both) ||
+        !hash_set_test_check("Union", either, TEST_KEYS, hash_set_test_in_either) ||
+        !hash_set_test_check("Difference", only_first, TEST_KEYS, hash_set_test_in_first)) {
+        return false;
+    }
+    
+    hash_set_free(both);
+    hash_set_free(either);
+    hash_set_free(only_first);
+    hash_set_free(first);
+    hash_set_free(second);
+    
+    return true;
+}
+
+bool hash_set_test() {
+    hash_set *set = hash_set_new();
+    if (set == NULL) {
+        printf("ERROR: Could not create set\n");
+        return false;
+    }
+    
+    if (hash_set_contains(set, "") || hash_set_remove(set, "")) {
+        printf("ERROR: Empty set has keys\n");
+        return false;
+    }
+    
+    /* Keys may contain zero bytes, and the empty key is a key like
+     * any other.
+     */
+    if (!hash_set_insert(set, "") || !hash_set_insert_bytes(set, "a\0b", 3) || !hash_set_insert_bytes(set, "a\0b", 3) ||
+        !hash_set_contains(set, "") || !hash_set_contains_bytes(set, "a\0b", 3) || hash_set_contains(set, "a") ||
+        set->length != 2) {
+        printf("ERROR: Set mishandled the empty key or zero bytes\n");
+        return false;
+    }
+    
+    if (!hash_set_remove(set, "") || !hash_set_remove_bytes(set, "a\0b", 3) || set->length != 0) {
+        printf("ERROR: Set didn't remove keys\n");
+        return false;
+    }
+    
+    char key[64];
+    int i = 0;
+    for (i = 0; i < TEST_KEYS; i++) {
+        hash_set_test_key(key, sizeof(key), i);
+        if (!hash_set_insert(set, key)) {
+            printf("ERROR: Could not add \"%s\" to set\n", key);
+            return false;
+        }
+    }
+    
+    if (set->length != TEST_KEYS) {
+        printf("ERROR: Set has %u keys, expected %d\n", set->length, TEST_KEYS);
+        return false;
+    }
+    
+    /* Removing most of the long keys compacts the key storage,
+     * without losing the rest.
+     */
+    size_t keys_size = set->keys_size;
+    for (i = 0; i < TEST_KEYS; i++) {
+        hash_set_test_key(key, sizeof(key), i);
+        if (i % 10 != 9 && !hash_set_remove(set, key)) {
+            printf("ERROR: Could not remove \"%s\" from set\n", key);
+            return false;
+        }
+    }
+    
+    for (i = 0; i < TEST_KEYS; i++) {
+        hash_set_test_key(key, sizeof(key), i);
+        if (hash_set_contains(set, key) != (i % 10 == 9)) {
+            printf("ERROR: Set is wrong about \"%s\" after removals\n", key);
+            return false;
+        }
+    }
+    
+    if (set->length != TEST_KEYS / 10 || set->keys_size >= keys_size / 2 || set->keys_unused * 2 > set->keys_used) {
+        printf("ERROR: Set didn't compact its key storage (%zu of %zu bytes unused)\n", set->keys_unused, set->keys_used);
+        return false;
+    }
+    
+    hash_set_free(set);
+    
+    /* Keys up to the inline size are stored in their slots.
+     */
+    hash_set_options options = { .inline_key_size = 20 };
+    set = hash_set_new_with_options(&options);
+    if (set->inline_key_size < 20 || !hash_set_insert(set, "twenty bytes of key!") || set->keys_used != 0 ||
+        !hash_set_insert(set, "twenty-five bytes of key!") || set->keys_used == 0 ||
+        !hash_set_contains(set, "twenty bytes of key!") || !hash_set_contains(set, "twenty-five bytes of key!")) {
+        printf("ERROR: Set didn't store inline keys in their slots\n");
+        return false;
+    }
+    
+    hash_set_free(set);
+    
+    hash_set_options fast = { .hash = HASH_TABLE_HASH_FAST };
+    hash_set_options keyed = { .hash = HASH_TABLE_HASH_KEYED, .inline_key_size = 24 };
+    if (!hash_set_ops_test(&fast, &fast) || !hash_set_ops_test(&keyed, &fast) || !hash_set_ops_test(&fast, &keyed)) {
+        return false;
+    }
+    
+    return true;
+}
@@ -9,8 +9,1426 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
+#include <unistd.h>
 
+#include "cuckoo_filter.h"
 #include "hash_table.h"
+#include "../src/hash_table/hash_table_private.h"
+
+#define LAYOUT_TEST_KEYS 5000
+
+static int released = 0;
+
+void hash_table_count_release(void *value) {
+    released++;
+}
+
+bool hash_table_layout_test(hash_table_options *options) {
+    hash_table *table = hash_table_new_with_options(options);
+    
+    if (table == NULL) {
+        printf("ERROR: Could not create hash table with layout %d\n", options->layout);
+        return false;
+    }
+    
+    static int values[LAYOUT_TEST_KEYS];
+    char key[32];
+    bool resized_incrementally = false;
+    
+    int i = 0;
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        values[i] = i;
+        snprintf(key, sizeof(key), "key:%d", i);
+        if (!hash_table_set(table, &values[i], key, NULL)) {
+            printf("ERROR: Could not set \"%s\" in hash table with layout %d\n", key, options->layout);
+            return false;
+        }
+        
+        resized_incrementally |= table->old_items != NULL;
+    }
+    
+    if (resized_incrementally != options->incremental_resize) {
+        printf("ERROR: Hash table with layout %d resized incrementally: %d\n", options->layout, resized_incrementally);
+        return false;
+    }
+    
+    snprintf(key, sizeof(key), "key:%d", 7);
+    hash_table_set(table, &values[8], key, NULL);
+    
+    if (table->length != LAYOUT_TEST_KEYS) {
+        printf("ERROR: Expected hash table length %d but got %u\n", LAYOUT_TEST_KEYS, table->length);
+        return false;
+    }
+    
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        int *value = hash_table_get(table, key);
+        int expected = (i == 7) ? 8 : i;
+        if (value == NULL || *value != expected) {
+            printf("ERROR: When reading \"%s\" from hash table with layout %d, expected %d\n", key, options->layout, expected);
+            return false;
+        }
+    }
+    
+    char many_keys[LAYOUT_TEST_KEYS / 10][32];
+    char *many_key_pointers[LAYOUT_TEST_KEYS / 10];
+    void *many_values[LAYOUT_TEST_KEYS / 10];
+    for (i = 0; i < LAYOUT_TEST_KEYS / 10; i++) {
+        snprintf(many_keys[i], sizeof(many_keys[i]), "key:%d", (i % 3 == 0) ? -i - 1 : i * 7);
+        many_key_pointers[i] = many_keys[i];
+    }
+    
+    hash_table_get_many(table, many_key_pointers, LAYOUT_TEST_KEYS / 10, many_values);
+    for (i = 0; i < LAYOUT_TEST_KEYS / 10; i++) {
+        if (many_values[i] != hash_table_get(table, many_keys[i]) || (many_values[i] == NULL) != (i % 3 == 0)) {
+            printf("ERROR: Batched lookup of \"%s\" in hash table with layout %d disagrees with hash_table_get\n", many_keys[i], options->layout);
+            return false;
+        }
+    }
+    
+    if (hash_table_get(table, "key:-1") != NULL || hash_table_get(table, "") != NULL) {
+        printf("ERROR: Found a missing key in hash table with layout %d\n", options->layout);
+        return false;
+    }
+    
+    if (hash_table_get_bytes(table, "key:12", 4) != NULL || hash_table_get_bytes(table, "key:12x", 6) != &values[12]) {
+        printf("ERROR: Byte keys don't match string keys in hash table with layout %d\n", options->layout);
+        return false;
+    }
+    
+    uint64_t packed_keys[] = { 0, 1, 1ULL << 32, 0x0000ff0000000000ULL };
+    for (i = 0; i < sizeof(packed_keys) / sizeof(packed_keys[0]); i++) {
+        hash_table_set_bytes(table, &values[i], &packed_keys[i], sizeof(packed_keys[i]), NULL);
+    }
+    
+    hash_table_set_bytes(table, &values[100], "a\0b", 3, NULL);
+    hash_table_set_bytes(table, &values[101], "a\0c", 3, NULL);
+    hash_table_set_bytes(table, &values[102], "", 0, NULL);
+    
+    for (i = 0; i < sizeof(packed_keys) / sizeof(packed_keys[0]); i++) {
+        if (hash_table_get_bytes(table, &packed_keys[i], sizeof(packed_keys[i])) != &values[i]) {
+            printf("ERROR: Could not read packed key %d from hash table with layout %d\n", i, options->layout);
+            return false;
+        }
+    }
+    
+    if (hash_table_get_bytes(table, "a\0b", 3) != &values[100] || hash_table_get_bytes(table, "a\0c", 3) != &values[101] || hash_table_get(table, "") != &values[102] || hash_table_get(table, "a") != NULL) {
+        printf("ERROR: Could not read keys containing zero bytes from hash table with layout %d\n", options->layout);
+        return false;
+    }
+    
+    for (i = 0; i < 10; i++) {
+        snprintf(key, sizeof(key), "released:%d", i);
+        hash_table_set(table, &values[i], key, &hash_table_count_release);
+    }
+    
+    released = 0;
+    hash_table_free(table);
+    
+    if (released != 10) {
+        printf("ERROR: Freeing hash table with layout %d released %d values\n", options->layout, released);
+        return false;
+    }
+    
+    return true;
+}
+
+bool hash_table_capacity_test(hash_table_options *options) {
+    options->capacity = LAYOUT_TEST_KEYS;
+    hash_table *table = hash_table_new_with_options(options);
+    options->capacity = 0;
+    
+    if (table == NULL) {
+        printf("ERROR: Could not create hash table with capacity %d\n", LAYOUT_TEST_KEYS);
+        return false;
+    }
+    
+    unsigned int bucket_count = table->bucket_count;
+    if ((bucket_count & (bucket_count - 1)) != 0) {
+        printf("ERROR: Hash table has %u buckets, which isn't a power of two\n", bucket_count);
+        return false;
+    }
+    
+    char key[32];
+    int i = 0;
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        hash_table_set(table, NULL, key, NULL);
+    }
+    
+    if (table->bucket_count != bucket_count) {
+        printf("ERROR: Hash table with capacity %d resized while being filled\n", LAYOUT_TEST_KEYS);
+        return false;
+    }
+    
+    if (!hash_table_reserve(table, LAYOUT_TEST_KEYS * 4) || table->bucket_count <= bucket_count || table->old_items != NULL) {
+        printf("ERROR: Could not reserve space in hash table with layout %d\n", options->layout);
+        return false;
+    }
+    
+    bucket_count = table->bucket_count;
+    for (i = LAYOUT_TEST_KEYS; i < LAYOUT_TEST_KEYS * 4; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        hash_table_set(table, NULL, key, NULL);
+    }
+    
+    if (table->bucket_count != bucket_count || table->length != LAYOUT_TEST_KEYS * 4) {
+        printf("ERROR: Hash table resized after reserving space\n");
+        return false;
+    }
+    
+    hash_table_free(table);
+    
+    return true;
+}
+
+bool hash_table_remove_test(hash_table_options *options) {
+    hash_table *table = hash_table_new_with_options(options);
+    
+    if (table == NULL) {
+        printf("ERROR: Could not create hash table with layout %d\n", options->layout);
+        return false;
+    }
+    
+    static int values[LAYOUT_TEST_KEYS];
+    char key[32];
+    
+    int i = 0;
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        hash_table_set(table, &values[i], key, &hash_table_count_release);
+    }
+    
+    released = 0;
+    for (i = 0; i < LAYOUT_TEST_KEYS; i += 2) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        if (!hash_table_remove(table, key) || hash_table_remove(table, key)) {
+            printf("ERROR: Could not remove \"%s\" once from hash table with layout %d\n", key, options->layout);
+            return false;
+        }
+    }
+    
+    if (released != LAYOUT_TEST_KEYS / 2 || table->length != LAYOUT_TEST_KEYS / 2) {
+        printf("ERROR: Removing half the keys of hash table with layout %d released %d values and left %u\n", options->layout, released, table->length);
+        return false;
+    }
+    
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        if (hash_table_get(table, key) != ((i % 2 == 0) ? NULL : &values[i])) {
+            printf("ERROR: Found the wrong value for \"%s\" after removals from hash table with layout %d\n", key, options->layout);
+            return false;
+        }
+    }
+    
+    for (i = 0; i < LAYOUT_TEST_KEYS; i += 2) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        hash_table_set(table, &values[i], key, NULL);
+    }
+    
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        if (hash_table_get(table, key) != &values[i]) {
+            printf("ERROR: Could not read \"%s\" after reinserting it in hash table with layout %d\n", key, options->layout);
+            return false;
+        }
+    }
+    
+    unsigned int bucket_count = table->bucket_count;
+    for (i = 0; i < LAYOUT_TEST_KEYS * 10; i++) {
+        snprintf(key, sizeof(key), "churn:%d", i);
+        hash_table_set(table, &values[0], key, NULL);
+        hash_table_remove(table, key);
+    }
+    
+    if (table->bucket_count > bucket_count * 2 || hash_table_get(table, "churn:0") != NULL) {
+        printf("ERROR: Hash table with layout %d grew from %u to %u buckets without growing in length\n", options->layout, bucket_count, table->bucket_count);
+        return false;
+    }
+    
+    unsigned int max = 0;
+    double mean = 0;
+    hash_table_probe_lengths(table, &max, &mean);
+    
+    if (table->length != LAYOUT_TEST_KEYS || mean < 1 || mean > max || max > 32) {
+        printf("ERROR: Hash table with layout %d has %u items with probe lengths of up to %u, %f on average\n", options->layout, table->length, max, mean);
+        return false;
+    }
+    
+    hash_table_free(table);
+    
+    return true;
+}
+
+bool hash_table_shrink_test(hash_table_options *options) {
+    hash_table *table = hash_table_new_with_options(options);
+    static int values[LAYOUT_TEST_KEYS];
+    char key[32];
+    
+    int i = 0;
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        hash_table_set(table, &values[i], key, &hash_table_count_release);
+    }
+    
+    unsigned int full_count = table->bucket_count;
+    
+    released = 0;
+    for (i = 0; i < LAYOUT_TEST_KEYS - 100; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        hash_table_remove(table, key);
+    }
+    
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        if (hash_table_get(table, key) != ((i < LAYOUT_TEST_KEYS - 100) ? NULL : &values[i])) {
+            printf("ERROR: Found the wrong value for \"%s\" after shrinking hash table with layout %d\n", key, options->layout);
+            return false;
+        }
+    }
+    
+    if (released != LAYOUT_TEST_KEYS - 100 || table->bucket_count * 8 > full_count) {
+        printf("ERROR: Hash table with layout %d has %u buckets for 100 items, down from %u\n", options->layout, table->bucket_count, full_count);
+        return false;
+    }
+    
+    /* Adding and removing keys around the size a table shrinks at
+     * mustn't make it grow and shrink over and over.
+     */
+    unsigned int bucket_count = table->bucket_count;
+    int resizes = 0;
+    for (i = 0; i < 1000; i++) {
+        snprintf(key, sizeof(key), "churn:%d", i % 50);
+        if (i % 100 < 50) {
+            hash_table_set(table, &values[0], key, NULL);
+        } else {
+            hash_table_remove(table, key);
+        }
+        
+        if (table->bucket_count != bucket_count) {
+            bucket_count = table->bucket_count;
+            resizes++;
+        }
+    }
+    
+    if (resizes > 1) {
+        printf("ERROR: Hash table with layout %d resized %d times while its length changed by 50\n", options->layout, resizes);
+        return false;
+    }
+    
+    for (i = LAYOUT_TEST_KEYS - 100; i < LAYOUT_TEST_KEYS - 10; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        hash_table_remove(table, key);
+    }
+    
+    if (!hash_table_compact(table) || table->old_items != NULL || table->bucket_count > 32) {
+        printf("ERROR: Could not compact hash table with layout %d to fewer than %u buckets\n", options->layout, table->bucket_count);
+        return false;
+    }
+    
+    for (i = LAYOUT_TEST_KEYS - 10; i < LAYOUT_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        if (hash_table_get(table, key) != &values[i]) {
+            printf("ERROR: Could not read \"%s\" after compacting hash table with layout %d\n", key, options->layout);
+            return false;
+        }
+    }
+    
+    hash_table_free(table);
+    
+    return true;
+}
+
+/* Clears a table several times while it is in use, including while
+ * a chained table is being resized, checking that its values are
+ * released and its storage is kept for the keys that follow.
+ */
+bool hash_table_clear_test(hash_table_options *options) {
+    hash_table *table = hash_table_new_with_options(options);
+    static int values[LAYOUT_TEST_KEYS];
+    char key[32];
+    
+    if (!hash_table_clear(table) || table->length != 0) {
+        printf("ERROR: Could not clear empty hash table with layout %d\n", options->layout);
+        return false;
+    }
+    
+    int round = 0;
+    for (round = 0; round < 3; round++) {
+        int count = (round == 1) ? 3 : LAYOUT_TEST_KEYS;
+        
+        int i = 0;
+        for (i = 0; i < count; i++) {
+            snprintf(key, sizeof(key), "round%d:%d", round, i);
+            hash_table_set(table, &values[i], key, (i % 2 == 0) ? &hash_table_count_release : NULL);
+        }
+        
+        if (round == 2 && !hash_table_add_filter(table)) {
+            printf("ERROR: Could not add filter to hash table with layout %d\n", options->layout);
+            return false;
+        }
+        
+        unsigned int bucket_count = table->bucket_count;
+        released = 0;
+        
+        if (!hash_table_clear(table) || table->length != 0 || released != (count + 1) / 2 ||
+            table->bucket_count != bucket_count || table->old_items != NULL) {
+            printf("ERROR: Clearing hash table with layout %d left %u keys and released %d values\n", options->layout, table->length, released);
+            return false;
+        }
+        
+        for (i = 0; i < count; i++) {
+            snprintf(key, sizeof(key), "round%d:%d", round, i);
+            if (hash_table_get(table, key) != NULL) {
+                printf("ERROR: Found \"%s\" after clearing hash table with layout %d\n", key, options->layout);
+                return false;
+            }
+        }
+        
+        for (i = 0; i < 100; i++) {
+            snprintf(key, sizeof(key), "after%d:%d", round, i);
+            hash_table_set(table, &values[i], key, NULL);
+        }
+        
+        for (i = 0; i < 100; i++) {
+            snprintf(key, sizeof(key), "after%d:%d", round, i);
+            if (hash_table_get(table, key) != &values[i]) {
+                printf("ERROR: Could not read \"%s\" after clearing hash table with layout %d\n", key, options->layout);
+                return false;
+            }
+        }
+        
+        /* The filter is dropped by clearing, and built again once
+         * the table holds as many keys as a new filter has room for.
+         */
+        if (round == 2) {
+            if (table->filter != NULL || !table->filter_pending) {
+                printf("ERROR: Clearing hash table with layout %d kept its filter\n", options->layout);
+                return false;
+            }
+            
+            for (i = 100; i < 1024; i++) {
+                snprintf(key, sizeof(key), "after%d:%d", round, i);
+                hash_table_set(table, &values[i], key, NULL);
+            }
+            
+            if (table->filter == NULL || table->filter_pending || table->filter->length != table->length ||
+                hash_table_get(table, "after2:1023") != &values[1023] || hash_table_get(table, "missing") != NULL) {
+                printf("ERROR: Filter of hash table with layout %d wasn't rebuilt after clearing\n", options->layout);
+                return false;
+            }
+        }
+        
+        hash_table_clear(table);
+    }
+    
+    /* A frozen table can't be cleared.
+     */
+    hash_table_set(table, &values[0], "frozen", NULL);
+    if (!hash_table_freeze(table) || hash_table_clear(table) || hash_table_get(table, "frozen") != &values[0]) {
+        printf("ERROR: Cleared frozen hash table with layout %d\n", options->layout);
+        return false;
+    }
+    
+    hash_table_free(table);
+    
+    return true;
+}
+
+bool hash_table_filter_test(hash_table_options *options) {
+    hash_table *table = hash_table_new_with_options(options);
+    static int values[LAYOUT_TEST_KEYS * 4];
+    char key[32];
+    
+    int i = 0;
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        hash_table_set(table, &values[i], key, NULL);
+    }
+    
+    if (!hash_table_add_filter(table) || table->filter == NULL) {
+        printf("ERROR: Could not add a filter to hash table with layout %d\n", options->layout);
+        return false;
+    }
+    
+    /* Enough keys to fill the filter, which must grow to hold them
+     */
+    for (i = LAYOUT_TEST_KEYS; i < LAYOUT_TEST_KEYS * 4; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        hash_table_set(table, &values[i], key, NULL);
+    }
+    
+    for (i = 0; i < LAYOUT_TEST_KEYS * 4; i += 3) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        hash_table_remove(table, key);
+    }
+    
+    int pass = 0;
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; i < LAYOUT_TEST_KEYS * 4; i++) {
+            snprintf(key, sizeof(key), "key:%d", i);
+            if (hash_table_get(table, key) != ((i % 3 == 0) ? NULL : &values[i])) {
+                printf("ERROR: Found the wrong value for \"%s\" in hash table with layout %d and a filter\n", key, options->layout);
+                return false;
+            }
+        }
+        
+        if (table->filter == NULL || table->filter->length != table->length) {
+            printf("ERROR: Filter of hash table with layout %d doesn't match its keys\n", options->layout);
+            return false;
+        }
+        
+        if (pass == 0 && !hash_table_freeze(table)) {
+            printf("ERROR: Could not freeze hash table with layout %d and a filter\n", options->layout);
+            return false;
+        }
+    }
+    
+    hash_table_free(table);
+    
+    return true;
+}
+
+bool hash_table_freeze_test(hash_table_options *options) {
+    hash_table *table = hash_table_new_with_options(options);
+    
+    if (table == NULL || !hash_table_freeze(table) || hash_table_get(table, "key:0") != NULL) {
+        printf("ERROR: Could not freeze empty hash table with layout %d\n", options->layout);
+        return false;
+    }
+    
+    hash_table_free(table);
+    table = hash_table_new_with_options(options);
+    
+    static int values[LAYOUT_TEST_KEYS];
+    char key[32];
+    
+    int i = 0;
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        hash_table_set(table, &values[i], key, &hash_table_count_release);
+    }
+    
+    released = 0;
+    if (!hash_table_freeze(table) || table->layout != HASH_TABLE_FROZEN || table->length != LAYOUT_TEST_KEYS || released != 0) {
+        printf("ERROR: Could not freeze hash table with layout %d\n", options->layout);
+        return false;
+    }
+    
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        if (hash_table_get(table, key) != &values[i]) {
+            printf("ERROR: Could not read \"%s\" from frozen hash table\n", key);
+            return false;
+        }
+        
+        snprintf(key, sizeof(key), "missing:%d", i);
+        if (hash_table_get(table, key) != NULL) {
+            printf("ERROR: Found \"%s\" in frozen hash table\n", key);
+            return false;
+        }
+    }
+    
+    char *many_keys[] = { "key:1", "missing:1", "key:4999", "key:" };
+    void *many_values[4];
+    hash_table_get_many(table, many_keys, 4, many_values);
+    
+    if (many_values[0] != &values[1] || many_values[1] != NULL || many_values[2] != &values[4999] || many_values[3] != NULL) {
+        printf("ERROR: Batched lookups in frozen hash table failed\n");
+        return false;
+    }
+    
+    unsigned int max = 0;
+    double mean = 0;
+    hash_table_probe_lengths(table, &max, &mean);
+    
+    if (hash_table_set(table, NULL, "key:1", NULL) || hash_table_remove(table, "key:1") || hash_table_get(table, "key:1") != &values[1] ||
+        max != 1 || mean != 1 || hash_table_frozen_bits_per_key(table) > 8) {
+        printf("ERROR: Frozen hash table changed or has %f bits per key\n", hash_table_frozen_bits_per_key(table));
+        return false;
+    }
+    
+    hash_table_free(table);
+    
+    if (released != LAYOUT_TEST_KEYS) {
+        printf("ERROR: Freeing frozen hash table released %d values\n", released);
+        return false;
+    }
+    
+    return true;
+}
+
+size_t hash_table_int_length(void *value) {
+    return sizeof(int);
+}
+
+bool hash_table_save_test(hash_table_options *options, const char *prefix) {
+    hash_table *table = hash_table_new_with_options(options);
+    char path[64], key[160], value[32];
+    snprintf(path, sizeof(path), "/tmp/hash_table_test_%d.tmp", (int)getpid());
+    
+    static char values[LAYOUT_TEST_KEYS][32];
+    
+    int i = 0;
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "%s:%d", prefix, i);
+        snprintf(values[i], sizeof(values[i]), "value:%d", i);
+        hash_table_set(table, (i % 100 == 0) ? NULL : values[i], key, NULL);
+    }
+    
+    if (!hash_table_save(table, path, NULL) || table->layout != options->layout || table->length != LAYOUT_TEST_KEYS) {
+        printf("ERROR: Could not save hash table with layout %d\n", options->layout);
+        return false;
+    }
+    
+    hash_table_free(table);
+    
+    table = hash_table_load(path);
+    if (table == NULL || table->layout != HASH_TABLE_FROZEN || table->length != LAYOUT_TEST_KEYS) {
+        printf("ERROR: Could not load hash table saved with layout %d\n", options->layout);
+        return false;
+    }
+    
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "%s:%d", prefix, i);
+        snprintf(value, sizeof(value), "value:%d", i);
+        
+        char *loaded = hash_table_get(table, key);
+        if ((i % 100 == 0) ? loaded != NULL : (loaded == NULL || strcmp(loaded, value) != 0 || loaded == values[i])) {
+            printf("ERROR: Could not read \"%s\" from loaded hash table\n", key);
+            return false;
+        }
+        
+        snprintf(key, sizeof(key), "%s:missing:%d", prefix, i);
+        if (hash_table_get(table, key) != NULL) {
+            printf("ERROR: Found \"%s\" in loaded hash table\n", key);
+            return false;
+        }
+    }
+    
+    /* A loaded table can be saved again, with values of any size.
+     */
+    static int numbers[3] = { 1, 2, 3 };
+    hash_table_free(table);
+    table = hash_table_new_with_options(options);
+    hash_table_set(table, &numbers[0], "one", NULL);
+    hash_table_set(table, &numbers[1], "two", NULL);
+    hash_table_set(table, &numbers[2], "three", NULL);
+    
+    hash_table_freeze(table);
+    hash_table *loaded = NULL;
+    if (hash_table_save(table, path, &hash_table_int_length)) {
+        loaded = hash_table_load(path);
+    }
+    
+    hash_table_free(table);
+    table = loaded;
+    loaded = NULL;
+    
+    if (table != NULL && hash_table_save(table, path, &hash_table_int_length)) {
+        loaded = hash_table_load(path);
+    }
+    
+    int *two = (loaded != NULL) ? hash_table_get(loaded, "two") : NULL;
+    if (two == NULL || *two != 2 || two == &numbers[1] || hash_table_get(loaded, "four") != NULL) {
+        printf("ERROR: Could not reload hash table saved with layout %d\n", options->layout);
+        return false;
+    }
+    
+    hash_table_free(table);
+    hash_table_free(loaded);
+    
+    /* Truncated files aren't loaded.
+     */
+    if (truncate(path, 100) != 0 || hash_table_load(path) != NULL || hash_table_load("/nonexistent/hash_table") != NULL) {
+        printf("ERROR: Loaded a truncated hash table file\n");
+        return false;
+    }
+    
+    unlink(path);
+    
+    return true;
+}
+
+/* Writes a copy of a saved table's file with one field changed,
+ * and loads it.
+ */
+bool hash_table_load_changed(const char *path, const char *file, size_t size, size_t offset, const void *field, size_t width) {
+    char *changed = malloc(size);
+    memcpy(changed, file, size);
+    memcpy(changed + offset, field, width);
+    
+    FILE *out = fopen(path, "wb");
+    bool written = out != NULL && fwrite(changed, 1, size, out) == size;
+    written = out != NULL && fclose(out) == 0 && written;
+    free(changed);
+    
+    hash_table *table = written ? hash_table_load(path) : NULL;
+    if (table == NULL) {
+        return false;
+    }
+    
+    hash_table_free(table);
+    
+    return true;
+}
+
+/* Damages a saved file's remap array, and the key and value offsets
+ * of one of its entries, checking that none of them is loaded.
+ */
+bool hash_table_load_damaged_test() {
+    hash_table *table = hash_table_new();
+    char path[64], key[160];
+    snprintf(path, sizeof(path), "/tmp/hash_table_damaged_%d.tmp", (int)getpid());
+    
+    int i = 0;
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "https://www.example.com/catalog/products/by-category/electronics/item:%d", i);
+        hash_table_set(table, "value", key, NULL);
+    }
+    
+    bool saved = hash_table_save(table, path, NULL);
+    hash_table_free(table);
+    
+    static char file[1 << 20];
+    FILE *in = fopen(path, "rb");
+    size_t size = (in != NULL) ? fread(file, 1, sizeof(file), in) : 0;
+    if (in != NULL) {
+        fclose(in);
+    }
+    
+    hash_table_file_header header;
+    memcpy(&header, file, sizeof(header));
+    
+    if (!saved || size != header.file_size || header.keys_inline || header.position_count == header.length ||
+        !hash_table_load_changed(path, file, size, 0, file, 0)) {
+        printf("ERROR: Could not save hash table to damage\n");
+        return false;
+    }
+    
+    hash_table_frozen_entry entry;
+    memcpy(&entry, file + header.entries, sizeof(entry));
+    
+    /* The last value, which ends the file
+     */
+    hash_table_frozen_entry last;
+    memcpy(&last, file + header.entries + (header.length - 1) * header.entry_size, sizeof(last));
+    
+    uint64_t last_length = 0;
+    memcpy(&last_length, file + header.value_lengths + (header.length - 1) * sizeof(uint64_t), sizeof(last_length));
+    
+    uint32_t slot = header.length;
+    uint32_t key_offset = header.keys_size - entry.key_length + 1;
+    uint64_t value_offset = header.values_size;
+    uint64_t value_length = header.values_size - last.value + 1;
+    char terminator = 'x';
+    
+    if (hash_table_load_changed(path, file, size, header.remap, &slot, sizeof(slot)) ||
+        hash_table_load_changed(path, file, size, header.entries + offsetof(hash_table_frozen_entry, key_offset), &key_offset, sizeof(key_offset)) ||
+        hash_table_load_changed(path, file, size, header.entries + offsetof(hash_table_frozen_entry, value), &value_offset, sizeof(value_offset)) ||
+        hash_table_load_changed(path, file, size, header.value_lengths + (header.length - 1) * sizeof(uint64_t), &value_length, sizeof(value_length)) ||
+        hash_table_load_changed(path, file, size, header.values + last.value + last_length - 1, &terminator, sizeof(terminator))) {
+        printf("ERROR: Loaded a damaged hash table file\n");
+        return false;
+    }
+    
+    unlink(path);
+    
+    return true;
+}
+
+typedef struct {
+    int seen[LAYOUT_TEST_KEYS];
+    unsigned int visited;
+} hash_table_scan_state;
+
+void hash_table_scan_visit(const char *key, size_t length, void *value, void *context) {
+    hash_table_scan_state *state = context;
+    int index = 0;
+    
+    if (sscanf(key, "key:%d", &index) == 1 && length == strlen(key) && value == &state->seen[index]) {
+        state->seen[index]++;
+    }
+    
+    state->visited++;
+}
+
+bool hash_table_scan_test(hash_table_options *options) {
+    hash_table *table = hash_table_new_with_options(options);
+    static hash_table_scan_state state;
+    char key[32];
+    
+    memset(&state, 0, sizeof(state));
+    
+    int i = 0;
+    for (i = 0; i < LAYOUT_TEST_KEYS / 4; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        hash_table_set(table, &state.seen[i], key, NULL);
+    }
+    
+    /* The table grows several times during the scan.
+     */
+    unsigned long cursor = 0;
+    int added = LAYOUT_TEST_KEYS / 4;
+    do {
+        cursor = hash_table_scan(table, cursor, 16, &hash_table_scan_visit, &state);
+        
+        for (i = 0; i < 24 && added < LAYOUT_TEST_KEYS; i++, added++) {
+            snprintf(key, sizeof(key), "key:%d", added);
+            hash_table_set(table, &state.seen[added], key, NULL);
+        }
+    } while (cursor != 0);
+    
+    for (i = 0; i < LAYOUT_TEST_KEYS / 4; i++) {
+        if (state.seen[i] == 0) {
+            printf("ERROR: Scan of hash table with layout %d missed key:%d\n", options->layout, i);
+            return false;
+        }
+    }
+    
+    /* Without changes, a scan or a pass over the table visits each
+     * item once, before and after freezing.
+     */
+    int pass = 0;
+    for (pass = 0; pass < 4; pass++) {
+        memset(&state, 0, sizeof(state));
+        
+        if (pass == 2) {
+            hash_table_freeze(table);
+        }
+        
+        if (pass % 2 == 0) {
+            hash_table_foreach(table, &hash_table_scan_visit, &state);
+        } else {
+            cursor = 0;
+            do {
+                cursor = hash_table_scan(table, cursor, 7, &hash_table_scan_visit, &state);
+            } while (cursor != 0);
+        }
+        
+        for (i = 0; i < added; i++) {
+            if (state.seen[i] != 1) {
+                printf("ERROR: Full scan of hash table with layout %d visited key:%d %d times\n", options->layout, i, state.seen[i]);
+                return false;
+            }
+        }
+        
+        if (state.visited != table->length) {
+            printf("ERROR: Full scan of hash table with layout %d visited %u items\n", options->layout, state.visited);
+            return false;
+        }
+    }
+    
+    hash_table_free(table);
+    
+    return true;
+}
+
+/* Clears a large table more times than there are epochs, refilling
+ * it with a few keys each time, so that most of its slots are still
+ * stale when they are next probed, scanned or measured.
+ */
+bool hash_table_clear_reuse_test(hash_table_options *options) {
+    hash_table_options sized = *options;
+    sized.capacity = LAYOUT_TEST_KEYS;
+    
+    hash_table *table = hash_table_new_with_options(&sized);
+    static hash_table_scan_state state;
+    char key[32];
+    
+    int i = 0;
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "old:%d", i);
+        hash_table_set(table, &state.seen[i], key, NULL);
+    }
+    
+    unsigned int bucket_count = table->bucket_count;
+    
+    int round = 0;
+    for (round = 0; round < 300; round++) {
+        memset(&state, 0, sizeof(state));
+        
+        if (!hash_table_clear(table) || table->length != 0 || table->bucket_count != bucket_count) {
+            printf("ERROR: Could not clear hash table with layout %d in round %d\n", options->layout, round);
+            return false;
+        }
+        
+        for (i = 0; i < 5; i++) {
+            snprintf(key, sizeof(key), "key:%d", i);
+            hash_table_set(table, &state.seen[i], key, NULL);
+        }
+        
+        snprintf(key, sizeof(key), "old:%d", round);
+        if (hash_table_get(table, key) != NULL || !hash_table_remove(table, "key:4") || hash_table_get(table, "key:4") != NULL) {
+            printf("ERROR: Found cleared keys in hash table with layout %d in round %d\n", options->layout, round);
+            return false;
+        }
+        
+        unsigned long cursor = 0;
+        do {
+            cursor = hash_table_scan(table, cursor, 3, &hash_table_scan_visit, &state);
+        } while (cursor != 0);
+        
+        unsigned int max = 0;
+        double mean = 0;
+        if (round % 100 == 0) {
+            hash_table_probe_lengths(table, &max, &mean);
+        }
+        
+        if (state.visited != 4 || state.seen[0] != 1 || state.seen[3] != 1 || (round % 100 == 0 && max < 1)) {
+            printf("ERROR: Scan of hash table with layout %d visited %u items in round %d\n", options->layout, state.visited, round);
+            return false;
+        }
+    }
+    
+    /* Compacting the table moves only the keys added since the last
+     * clear, and so does growing it again.
+     */
+    if (!hash_table_compact(table) || table->bucket_count >= bucket_count || table->length != 4 ||
+        hash_table_get(table, "key:0") != &state.seen[0]) {
+        printf("ERROR: Could not compact cleared hash table with layout %d\n", options->layout);
+        return false;
+    }
+    
+    memset(&state, 0, sizeof(state));
+    hash_table_clear(table);
+    
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        hash_table_set(table, &state.seen[i], key, NULL);
+    }
+    
+    hash_table_foreach(table, &hash_table_scan_visit, &state);
+    
+    if (table->length != LAYOUT_TEST_KEYS || state.visited != LAYOUT_TEST_KEYS ||
+        hash_table_get(table, "key:0") != &state.seen[0] || hash_table_get(table, "old:0") != NULL) {
+        printf("ERROR: Refilling cleared hash table with layout %d left %u keys\n", options->layout, table->length);
+        return false;
+    }
+    
+    hash_table_free(table);
+    
+    return true;
+}
+
+typedef struct {
+    int order[LAYOUT_TEST_KEYS];
+    int count;
+} hash_table_order_state;
+
+void hash_table_order_visit(const char *key, size_t length, void *value, void *context) {
+    hash_table_order_state *state = context;
+    int index = -1;
+    
+    sscanf(key, "key:%d", &index);
+    state->order[state->count++] = index;
+}
+
+/* Checks that a pass over an ordered table visits exactly the keys
+ * given, in the order given.
+ */
+bool hash_table_order_check(hash_table *table, const int *expected, int count, const char *when) {
+    static hash_table_order_state state;
+    
+    state.count = 0;
+    hash_table_foreach(table, &hash_table_order_visit, &state);
+    
+    if (state.count != count || memcmp(state.order, expected, count * sizeof(int)) != 0) {
+        printf("ERROR: Ordered hash table visited keys out of order %s\n", when);
+        return false;
+    }
+    
+    return true;
+}
+
+/* Counts keys through hash_table_get_or_insert, keeping each count
+ * in its key's value.
+ */
+bool hash_table_get_or_insert_test(hash_table_options *options) {
+    hash_table *table = hash_table_new_with_options(options);
+    char key[32];
+    
+    if (table == NULL) {
+        printf("ERROR: Could not create hash table\n");
+        return false;
+    }
+    
+    /* Key n is seen n % 7 + 1 times, up to four, with the table
+     * growing while keys are being counted.
+     */
+    int added = 0;
+    int i = 0;
+    for (i = 0; i < LAYOUT_TEST_KEYS * 4; i++) {
+        int n = (i * 7919) % LAYOUT_TEST_KEYS;
+        if (i / LAYOUT_TEST_KEYS > n % 7) {
+            continue;
+        }
+        
+        snprintf(key, sizeof(key), "key:%d", n);
+        
+        bool inserted = false;
+        void **value = hash_table_get_or_insert(table, key, &inserted);
+        if (value == NULL || inserted != (*value == NULL)) {
+            printf("ERROR: Hash table with layout %d could not count \"%s\"\n", options->layout, key);
+            return false;
+        }
+
+        *value = (void *)((uintptr_t)*value + 1);
+        added += inserted;
+    }
+    
+    if (added != LAYOUT_TEST_KEYS || table->length != LAYOUT_TEST_KEYS) {
+        printf("ERROR: Hash table with layout %d added %d keys while counting\n", options->layout, added);
+        return false;
+    }
+    
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        uintptr_t count = (uintptr_t)hash_table_get(table, key);
+        if (count != ((i % 7 < 4) ? i % 7 + 1 : 4)) {
+            printf("ERROR: Hash table with layout %d counted \"%s\" %lu times\n", options->layout, key, (unsigned long)count);
+            return false;
+        }
+    }
+    
+    /* Keys can be added in place with a stored value, and a frozen
+     * table has no room for more.
+     */
+    void **value = hash_table_get_or_insert_bytes(table, "new\0key", 7, NULL);
+    if (value == NULL || *value != NULL) {
+        printf("ERROR: Hash table with layout %d could not add a key in place\n", options->layout);
+        return false;
+    }
+
+    *value = table;
+    
+    if (!hash_table_freeze(table) || hash_table_get_bytes(table, "new\0key", 7) != table ||
+        hash_table_get_or_insert(table, "another", NULL) != NULL) {
+        printf("ERROR: Frozen hash table with layout %d mishandled keys added in place\n", options->layout);
+        return false;
+    }
+    
+    hash_table_free(table);
+    
+    return true;
+}
+
+/* Measures a table in its small form, whose keys are each found
+ * with one probe.
+ */
+bool hash_table_small_measure_check(hash_table *table, hash_table_options *options) {
+    unsigned int max = 0;
+    double mean = 0;
+    hash_table_probe_lengths(table, &max, &mean);
+    
+    if (max != (table->length > 0) || mean != (table->length > 0)) {
+        printf("ERROR: Small hash table with layout %d and %u keys has probe lengths up to %u\n", options->layout, table->length, max);
+        return false;
+    }
+    
+#ifdef HASH_TABLE_STATS
+    hash_table_stats stats;
+    hash_table_get_stats(table, &stats);
+    
+    if (stats.length != table->length || stats.probe_lengths[0] != table->length || stats.max_probe_length != max) {
+        printf("ERROR: Small hash table with layout %d and %u keys has the wrong statistics\n", options->layout, table->length);
+        return false;
+    }
+#endif
+    
+    return true;
+}
+
+/* Checks that a new table holds its first keys in its small form,
+ * including keys whose first bytes and lengths are the same, and
+ * moves them into its layout's storage once it outgrows it.
+ */
+bool hash_table_small_test(hash_table_options *options) {
+    hash_table *table = hash_table_new_with_options(options);
+    int values[HASH_TABLE_SMALL_SIZE + 2];
+    char key[32];
+    
+    if (table == NULL || !table->small) {
+        printf("ERROR: Hash table with layout %d did not start small\n", options->layout);
+        return false;
+    }
+    
+    if (!hash_table_small_measure_check(table, options)) {
+        return false;
+    }
+    
+    released = 0;
+    
+    int i = 0;
+    for (i = 0; i < HASH_TABLE_SMALL_SIZE; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        hash_table_set(table, &values[i], key, &hash_table_count_release);
+    }
+    
+    hash_table_set_bytes(table, &values[1], "key:1", 5, &hash_table_count_release);
+    
+    if (!table->small || table->length != HASH_TABLE_SMALL_SIZE || released != 0 ||
+        hash_table_get(table, "key:1") != &values[1] || hash_table_get(table, "key:7") != &values[7] ||
+        hash_table_get(table, "key:8") != NULL || hash_table_get(table, "key:") != NULL) {
+        printf("ERROR: Small hash table with layout %d mishandled keys\n", options->layout);
+        return false;
+    }
+    
+    if (!hash_table_small_measure_check(table, options)) {
+        return false;
+    }
+    
+    /* Removing a key keeps the rest in the order they were added.
+     */
+    int expected[] = { 0, 1, 3, 4, 5, 6, 7, 8, 9 };
+    if (!hash_table_remove(table, "key:2") || hash_table_remove(table, "key:2") || released != 1 ||
+        !hash_table_order_check(table, expected, HASH_TABLE_SMALL_SIZE - 1, "in a small table")) {
+        return false;
+    }
+    
+    hash_table_set(table, &values[8], "key:8", &hash_table_count_release);
+    hash_table_set(table, &values[9], "key:9", &hash_table_count_release);
+    
+    if (table->small || table->length != HASH_TABLE_SMALL_SIZE + 1) {
+        printf("ERROR: Small hash table with layout %d did not grow\n", options->layout);
+        return false;
+    }
+    
+    for (i = 0; i < HASH_TABLE_SMALL_SIZE + 1; i++) {
+        snprintf(key, sizeof(key), "key:%d", expected[i]);
+        if (hash_table_get(table, key) != &values[expected[i]] || hash_table_get(table, "key:2") != NULL) {
+            printf("ERROR: Hash table with layout %d lost \"%s\" when it grew\n", options->layout, key);
+            return false;
+        }
+    }
+    
+    if (options->layout == HASH_TABLE_ORDERED &&
+        !hash_table_order_check(table, expected, HASH_TABLE_SMALL_SIZE + 1, "after it grew")) {
+        return false;
+    }
+    
+    hash_table_free(table);
+    
+    if (released != HASH_TABLE_SMALL_SIZE + 2) {
+        printf("ERROR: Hash table with layout %d released %d values\n", options->layout, released);
+        return false;
+    }
+    
+    /* Tables made for more keys skip the small form, and compacting
+     * or filtering a small table keeps its keys.
+     */
+    hash_table_options large = *options;
+    large.capacity = HASH_TABLE_SMALL_SIZE + 1;
+    table = hash_table_new_with_options(&large);
+    if (table == NULL || table->small) {
+        printf("ERROR: Hash table with layout %d and a capacity of %d started small\n", options->layout, large.capacity);
+        return false;
+    }
+    
+    hash_table_free(table);
+    
+    table = hash_table_new_with_options(options);
+    hash_table_set(table, &values[0], "key:0", NULL);
+    hash_table_set(table, &values[1], "key:1", NULL);
+    hash_table_remove(table, "key:0");
+    
+    if (!hash_table_compact(table) || hash_table_get(table, "key:1") != &values[1] ||
+        !hash_table_add_filter(table) || table->small || hash_table_get(table, "key:1") != &values[1]) {
+        printf("ERROR: Small hash table with layout %d could not be compacted and filtered\n", options->layout);
+        return false;
+    }
+    
+    hash_table_free(table);
+    
+    return true;
+}
+
+typedef struct {
+    uint64_t id;
+    double score;
+    char tag[16];
+} hash_table_record;
+
+static int released_records = 0;
+
+void hash_table_count_record(void *value) {
+    hash_table_record *record = value;
+    if (record->id == 7) {
+        released_records++;
+    }
+}
+
+/* Checks that a table with a value size holds copies of values
+ * through growth, removal, compaction, freezing and saving.
+ */
+bool hash_table_value_size_test(hash_table_options *options) {
+    hash_table_options copied = *options;
+    copied.value_size = sizeof(hash_table_record);
+    
+    hash_table *table = hash_table_new_with_options(&copied);
+    char path[64], key[32];
+    snprintf(path, sizeof(path), "/tmp/hash_table_test_%d.tmp", (int)getpid());
+    
+    if (table == NULL || table->value_size != sizeof(hash_table_record)) {
+        printf("ERROR: Could not create hash table with a value size\n");
+        return false;
+    }
+    
+    int i = 0;
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        hash_table_record record = { .id = i, .score = i / 2.0 };
+        snprintf(record.tag, sizeof(record.tag), "#%d", i);
+        snprintf(key, sizeof(key), "key:%d", i);
+        
+        if (!hash_table_set(table, &record, key, NULL)) {
+            printf("ERROR: Could not set \"%s\" in hash table with a value size\n", key);
+            return false;
+        }
+    }
+    
+    /* Values are replaced in place, and removed with their keys;
+     * the release function sees the table's copy.
+     */
+    released_records = 0;
+    hash_table_record replacement = { .id = 7, .score = -1 };
+    hash_table_record *first = hash_table_get(table, "key:0");
+    if (!hash_table_set(table, &replacement, "key:0", NULL) || hash_table_get(table, "key:0") != first ||
+        first->id != 7 || first->score != -1 || !hash_table_set(table, &replacement, "released", &hash_table_count_record) ||
+        !hash_table_remove(table, "released") || released_records != 1) {
+        printf("ERROR: Hash table with a value size mishandled replaced values\n");
+        return false;
+    }
+    
+    replacement.id = 0;
+    replacement.score = 0;
+    strcpy(replacement.tag, "#0");
+    hash_table_set(table, &replacement, "key:0", NULL);
+    
+    for (i = 0; i < LAYOUT_TEST_KEYS; i += 2) {
+        snprintf(key, sizeof(key), "key:%d", i + 1);
+        hash_table_remove(table, key);
+    }
+    
+    bool inserted = false;
+    void **added = hash_table_get_or_insert(table, "added", &inserted);
+    hash_table_record *record = (added != NULL) ? *added : NULL;
+    if (!inserted || record == NULL || record->id != 0 || record->tag[0] != '\0') {
+        printf("ERROR: Hash table with a value size added a key without a zeroed value\n");
+        return false;
+    }
+    
+    record->id = 1;
+    hash_table_remove(table, "added");
+    hash_table_compact(table);
+    
+    /* Each remaining value is checked while mutable, frozen, and
+     * loaded from a file.
+     */
+    int pass = 0;
+    for (pass = 0; pass < 3; pass++) {
+        if (pass == 1 && !hash_table_freeze(table)) {
+            printf("ERROR: Could not freeze hash table with a value size\n");
+            return false;
+        }
+        
+        if (pass == 2) {
+            if (!hash_table_save(table, path, NULL)) {
+                printf("ERROR: Could not save hash table with a value size\n");
+                return false;
+            }
+            
+            hash_table_free(table);
+            table = hash_table_load(path);
+            remove(path);
+            
+            if (table == NULL || table->value_size != sizeof(hash_table_record)) {
+                printf("ERROR: Could not load hash table with a value size\n");
+                return false;
+            }
+        }
+        
+        for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+            snprintf(key, sizeof(key), "key:%d", i);
+            record = hash_table_get(table, key);
+            
+            char tag[16];
+            snprintf(tag, sizeof(tag), "#%d", i);
+            if ((i % 2 == 0) ? (record == NULL || record->id != i || record->score != i / 2.0 || strcmp(record->tag, tag) != 0 ||
+                                (uintptr_t)record % sizeof(uint64_t) != 0) : record != NULL) {
+                printf("ERROR: Hash table with layout %d and a value size has the wrong value for \"%s\" in pass %d\n", options->layout, key, pass);
+                return false;
+            }
+        }
+    }
+    
+    hash_table_free(table);
+    
+    table = hash_table_new_with_value_size(sizeof(int));
+    int count = 41;
+    if (table == NULL || !hash_table_set(table, &count, "count", NULL) || ++*(int *)hash_table_get(table, "count") != 42 ||
+        *(int *)hash_table_get(table, "count") != 42) {
+        printf("ERROR: Could not change value in hash table with a value size\n");
+        return false;
+    }
+    
+    hash_table_free(table);
+    
+    return true;
+}
+
+bool hash_table_order_test(hash_table_options *options) {
+    hash_table *table = hash_table_new_with_options(options);
+    static int values[LAYOUT_TEST_KEYS];
+    static int expected[LAYOUT_TEST_KEYS];
+    char key[32];
+    
+    if (table == NULL) {
+        printf("ERROR: Could not create ordered hash table\n");
+        return false;
+    }
+    
+    /* Keys are set in an order unrelated to their hashes, and the
+     * index starts out one byte wide.
+     */
+    int i = 0;
+    for (i = 0; i < 100; i++) {
+        expected[i] = (i * 37) % 100;
+        snprintf(key, sizeof(key), "key:%d", expected[i]);
+        hash_table_set(table, &values[expected[i]], key, NULL);
+    }
+    
+    if (table->index_width != 1 || !hash_table_order_check(table, expected, 100, "after setting")) {
+        return false;
+    }
+    
+    /* Replacing a value keeps its key's place; removing a key and
+     * setting it again moves it to the end.
+     */
+    snprintf(key, sizeof(key), "key:%d", expected[10]);
+    hash_table_set(table, &values[expected[10]], key, NULL);
+    snprintf(key, sizeof(key), "key:%d", expected[20]);
+    hash_table_remove(table, key);
+    hash_table_set(table, &values[expected[20]], key, NULL);
+    
+    int moved = expected[20];
+    memmove(&expected[20], &expected[21], 79 * sizeof(int));
+    expected[99] = moved;
+    
+    if (!hash_table_order_check(table, expected, 100, "after replacing keys")) {
+        return false;
+    }
+    
+    /* Removing most keys leaves holes that shrinking squeezes out.
+     */
+    int kept = 0;
+    for (i = 0; i < 100; i++) {
+        if (i % 5 == 0) {
+            expected[kept++] = expected[i];
+        } else {
+            snprintf(key, sizeof(key), "key:%d", expected[i]);
+            hash_table_remove(table, key);
+        }
+    }
+    
+    if (table->entry_count > 4 * kept || !hash_table_order_check(table, expected, kept, "after removing keys")) {
+        return false;
+    }
+    
+    hash_table_compact(table);
+    if (table->entry_count != kept || !hash_table_order_check(table, expected, kept, "after compacting")) {
+        return false;
+    }
+    
+    /* The index widens as the table grows, and never loses the
+     * order.
+     */
+    for (i = 100; i < LAYOUT_TEST_KEYS; i++) {
+        expected[kept++] = i;
+        snprintf(key, sizeof(key), "key:%d", i);
+        hash_table_set(table, &values[i], key, NULL);
+        
+        if (i == 1000 && table->index_width != 2) {
+            printf("ERROR: Ordered hash table of %u keys has a %u byte index\n", table->length, table->index_width);
+            return false;
+        }
+    }
+    
+    if (!hash_table_order_check(table, expected, kept, "after growing")) {
+        return false;
+    }
+    
+    for (i = 0; i < kept; i++) {
+        snprintf(key, sizeof(key), "key:%d", expected[i]);
+        if (hash_table_get(table, key) != &values[expected[i]]) {
+            printf("ERROR: Ordered hash table lost \"%s\"\n", key);
+            return false;
+        }
+    }
+    
+    hash_table_free(table);
+    
+    return true;
+}
+
+#ifdef HASH_TABLE_STATS
+bool hash_table_stats_test(hash_table_options *options) {
+    hash_table *table = hash_table_new_with_options(options);
+    static int values[LAYOUT_TEST_KEYS];
+    char key[32];
+    
+    int i = 0;
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        hash_table_set(table, &values[i], key, NULL);
+    }
+    
+    for (i = 0; i < LAYOUT_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), (i % 4 == 0) ? "missing:%d" : "key:%d", i);
+        hash_table_get(table, key);
+    }
+    
+    hash_table_stats stats;
+    hash_table_get_stats(table, &stats);
+    
+    unsigned long items = 0, buckets = 0;
+    for (i = 0; i < HASH_TABLE_STATS_HISTOGRAM_SIZE; i++) {
+        items += stats.probe_lengths[i];
+        buckets += stats.chain_lengths[i];
+    }
+    
+    unsigned int max = 0;
+    double mean = 0;
+    hash_table_probe_lengths(table, &max, &mean);
+    
+    if (stats.length != LAYOUT_TEST_KEYS || items != LAYOUT_TEST_KEYS || stats.max_probe_length != max || stats.mean_probe_length != mean ||
+        (options->layout == HASH_TABLE_CHAINED && buckets != stats.bucket_count) || stats.load_factor <= 0 || stats.load_factor > 1) {
+        printf("ERROR: Hash table with layout %d has the wrong histograms\n", options->layout);
+        return false;
+    }
+    
+    hash_table_counters *counters = &stats.counters;
+    if (counters->gets != LAYOUT_TEST_KEYS || counters->hits != LAYOUT_TEST_KEYS - LAYOUT_TEST_KEYS / 4 ||
+        counters->searches < 2 * LAYOUT_TEST_KEYS || counters->comparisons < counters->hits || counters->resizes == 0) {
+        printf("ERROR: Hash table with layout %d has the wrong counters\n", options->layout);
+        return false;
+    }
+    
+    char text[4096] = { 0 };
+    FILE *file = fmemopen(text, sizeof(text) - 1, "w");
+    hash_table_print_stats(table, file);
+    fclose(file);
+    
+    snprintf(key, sizeof(key), "\nlength %d\n", LAYOUT_TEST_KEYS);
+    if (strstr(text, key) == NULL || strstr(text, "\nmisses 1250\n") == NULL) {
+        printf("ERROR: Printed statistics of hash table with layout %d are wrong:\n%s", options->layout, text);
+        return false;
+    }
+    
+    hash_table_free(table);
+    
+    return true;
+}
+#endif
 
 bool hash_table_test() {
     hash_table *table = hash_table_new();
@@ -48,5 +1466,41 @@ bool hash_table_test() {
 	
     hash_table_free(table);
     
-    return true;
+    hash_table_options layouts[] = {
+        { .layout = HASH_TABLE_CHAINED },
+        { .layout = HASH_TABLE_CHAINED, .incremental_resize = true },
+        { .layout = HASH_TABLE_FLAT },
+        { .layout = HASH_TABLE_FLAT, .hash = HASH_TABLE_HASH_KEYED },
+        { .layout = HASH_TABLE_CHAINED, .incremental_resize = true, .arena = true },
+        { .layout = HASH_TABLE_FLAT, .arena = true },
+        { .layout = HASH_TABLE_ROBIN_HOOD },
+        { .layout = HASH_TABLE_ROBIN_HOOD, .arena = true },
+        { .layout = HASH_TABLE_ORDERED },
+        { .layout = HASH_TABLE_ORDERED, .arena = true }
+    };
+    
+    int i = 0;
+    for (i = 0; i < sizeof(layouts) / sizeof(layouts[0]); i++) {
+        if (!hash_table_layout_test(&layouts[i]) || !hash_table_capacity_test(&layouts[i]) || !hash_table_remove_test(&layouts[i]) ||
+            !hash_table_shrink_test(&layouts[i]) || !hash_table_filter_test(&layouts[i]) ||
+            !hash_table_freeze_test(&layouts[i]) || !hash_table_save_test(&layouts[i], "key") ||
+            !hash_table_save_test(&layouts[i], "https://www.example.com/catalog/products/by-category/electronics/item") ||
+            !hash_table_scan_test(&layouts[i]) || !hash_table_get_or_insert_test(&layouts[i]) ||
+            !hash_table_value_size_test(&layouts[i]) || !hash_table_small_test(&layouts[i]) ||
+            !hash_table_clear_test(&layouts[i]) || !hash_table_clear_reuse_test(&layouts[i])) {
+            return false;
+        }
+        
+        if (layouts[i].layout == HASH_TABLE_ORDERED && !hash_table_order_test(&layouts[i])) {
+            return false;
+        }
+        
+#ifdef HASH_TABLE_STATS
+        if (!hash_table_stats_test(&layouts[i])) {
+            return false;
+        }
+#endif
+    }
+    
+    return hash_table_load_damaged_test();
 }
\ No newline at end of file
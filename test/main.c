@@ -14,7 +14,15 @@ extern bool dll_test();
 extern bool array_test();
 extern bool pointer_array_test();
 extern bool cstr_test();
+extern bool hash_test();
 extern bool hash_table_test();
+extern bool chash_table_test();
+extern bool u64_table_test();
+extern bool hash_set_test();
+extern bool sharded_table_test();
+extern bool cache_test();
+extern bool bloom_filter_test();
+extern bool cuckoo_filter_test();
 
 int main(int argc, const char * argv[])
 {
@@ -48,11 +56,59 @@ int main(int argc, const char * argv[])
 		printf("Error: C string tests fail\n");
 	}
 	
+	if (hash_test()) {
+		printf("SUCCESS: Hash function tests pass\n");
+	} else {
+		printf("Error: Hash function tests fail\n");
+	}
+	
 	if (hash_table_test()) {
         printf("SUCCESS: Hash table tests pass\n");
     } else {
         printf("Error: Hash table tests fail\n");
     }
 	
+	if (chash_table_test()) {
+		printf("SUCCESS: Concurrent hash table tests pass\n");
+	} else {
+		printf("Error: Concurrent hash table tests fail\n");
+	}
+	
+	if (u64_table_test()) {
+		printf("SUCCESS: u64 table tests pass\n");
+	} else {
+		printf("Error: u64 table tests fail\n");
+	}
+	
+	if (hash_set_test()) {
+		printf("SUCCESS: Hash set tests pass\n");
+	} else {
+		printf("Error: Hash set tests fail\n");
+	}
+	
+	if (sharded_table_test()) {
+		printf("SUCCESS: Sharded table tests pass\n");
+	} else {
+		printf("Error: Sharded table tests fail\n");
+	}
+	
+	if (cache_test()) {
+		printf("SUCCESS: Cache tests pass\n");
+	} else {
+		printf("Error: Cache tests fail\n");
+	}
+	
+	if (bloom_filter_test()) {
+		printf("SUCCESS: Bloom filter tests pass\n");
+	} else {
+		printf("Error: Bloom filter tests fail\n");
+	}
+	
+	if (cuckoo_filter_test()) {
+		printf("SUCCESS: Cuckoo filter tests pass\n");
+	} else {
+		printf("Error: Cuckoo filter tests fail\n");
+	}
+	
 	return 0;
 }
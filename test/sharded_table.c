@@ -0,0 +1,170 @@
+/*
+ *  test/sharded_table.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/18/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "sharded_table.h"
+
+#define KEYS_PER_WRITER 20000
+#define WRITER_THREADS 4
+#define SHARED_KEYS 100
+
+static int values[WRITER_THREADS * KEYS_PER_WRITER];
+static unsigned long released = 0;
+
+typedef struct {
+    sharded_table_writer *writer;
+    int start;
+    int end;
+    bool ok;
+} sharded_table_worker;
+
+void sharded_table_count_release(void *value) {
+    __atomic_add_fetch(&released, 1, __ATOMIC_RELAXED);
+}
+
+/* Sets a range of keys through a writer, along with the keys every
+ * writer shares.
+ */
+void *sharded_table_ingest(void *context) {
+    sharded_table_worker *worker = context;
+    char key[32];
+
+    int i = 0;
+    for (i = worker->start; i < worker->end; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        if (!sharded_table_writer_set(worker->writer, &values[i], key, &sharded_table_count_release)) {
+            worker->ok = false;
+        }
+    }
+
+    for (i = 0; i < SHARED_KEYS; i++) {
+        snprintf(key, sizeof(key), "shared:%d", i);
+        if (!sharded_table_writer_set(worker->writer, &values[worker->start], key, NULL)) {
+            worker->ok = false;
+        }
+    }
+
+    return NULL;
+}
+
+/* Ingests keys from several threads, merges them, and checks that
+ * each is found once and released once.
+ */
+bool sharded_table_ingest_test(sharded_table_options *options) {
+    sharded_table *table = sharded_table_new_with_options(options);
+    if (table == NULL) {
+        printf("ERROR: Could not create sharded table\n");
+        return false;
+    }
+
+    released = 0;
+
+    pthread_t threads[WRITER_THREADS];
+    sharded_table_worker workers[WRITER_THREADS];
+
+    int t = 0;
+    for (t = 0; t < WRITER_THREADS; t++) {
+        workers[t].writer = sharded_table_writer_new(table);
+        workers[t].start = t * KEYS_PER_WRITER;
+        workers[t].end = (t + 1) * KEYS_PER_WRITER;
+        workers[t].ok = true;
+
+        if (workers[t].writer == NULL || pthread_create(&threads[t], NULL, sharded_table_ingest, &workers[t]) != 0) {
+            printf("ERROR: Could not start sharded table writer\n");
+            return false;
+        }
+    }
+
+    for (t = 0; t < WRITER_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+        if (!workers[t].ok) {
+            printf("ERROR: Sharded table writer failed to set keys\n");
+            return false;
+        }
+    }
+
+    if (sharded_table_length(table) != 0 || sharded_table_get(table, "key:0") != NULL) {
+        printf("ERROR: Sharded table found keys before they were merged\n");
+        return false;
+    }
+
+    if (!sharded_table_merge(table, 3)) {
+        printf("ERROR: Could not merge sharded table\n");
+        return false;
+    }
+
+    if (sharded_table_length(table) != WRITER_THREADS * KEYS_PER_WRITER + SHARED_KEYS) {
+        printf("ERROR: Merged sharded table has %lu keys\n", sharded_table_length(table));
+        return false;
+    }
+
+    char key[32];
+    int i = 0;
+    for (i = 0; i < WRITER_THREADS * KEYS_PER_WRITER; i++) {
+        snprintf(key, sizeof(key), "key:%d", i);
+        if (sharded_table_get(table, key) != &values[i]) {
+            printf("ERROR: Merged sharded table lost \"%s\"\n", key);
+            return false;
+        }
+    }
+
+    for (i = 0; i < SHARED_KEYS; i++) {
+        snprintf(key, sizeof(key), "shared:%d", i);
+        int *value = sharded_table_get(table, key);
+        if (value == NULL || (value - values) % KEYS_PER_WRITER != 0) {
+            printf("ERROR: Merged sharded table has the wrong value for \"%s\"\n", key);
+            return false;
+        }
+    }
+
+    /* Writers can add more keys after a merge, and the table can be
+     * changed directly.
+     */
+    sharded_table_writer *writer = table->writers;
+    if (!sharded_table_writer_set(writer, &values[1], "key:0", &sharded_table_count_release) ||
+        !sharded_table_set(table, &values[2], "direct", NULL) || !sharded_table_remove(table, "key:1") ||
+        sharded_table_remove(table, "key:1") || !sharded_table_merge(table, 0) ||
+        sharded_table_get(table, "key:0") != &values[1] || sharded_table_get(table, "direct") != &values[2] ||
+        sharded_table_get(table, "key:1") != NULL) {
+        printf("ERROR: Sharded table mishandled keys after a merge\n");
+        return false;
+    }
+
+    /* An unmerged key is released with the table.
+     */
+    sharded_table_writer_set(writer, &values[3], "unmerged", &sharded_table_count_release);
+    sharded_table_free(table);
+
+    if (released != WRITER_THREADS * KEYS_PER_WRITER + 1) {
+        printf("ERROR: Sharded table released %lu values, expected %d\n", released, WRITER_THREADS * KEYS_PER_WRITER + 1);
+        return false;
+    }
+
+    return true;
+}
+
+bool sharded_table_test() {
+    sharded_table_options chained = { .shard_count = 16, .table = { .layout = HASH_TABLE_CHAINED } };
+    sharded_table_options flat = { .shard_count = 5, .table = { .layout = HASH_TABLE_FLAT, .hash = HASH_TABLE_HASH_KEYED } };
+    sharded_table_options robin_hood = { .table = { .layout = HASH_TABLE_ROBIN_HOOD, .arena = true, .capacity = 100000 } };
+
+    if (!sharded_table_ingest_test(&chained) || !sharded_table_ingest_test(&flat) || !sharded_table_ingest_test(&robin_hood)) {
+        return false;
+    }
+
+    sharded_table_options frozen = { .table = { .layout = HASH_TABLE_FROZEN } };
+    if (sharded_table_new_with_options(&frozen) != NULL) {
+        printf("ERROR: Created a sharded table of frozen shards\n");
+        return false;
+    }
+
+    return true;
+}
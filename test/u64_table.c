@@ -0,0 +1,102 @@
+/*
+ *  test/u64_table.c
+ *  Data Structures
+ *
+ *  Created by David Pearson on 10/17/26.
+ *  Copyright (c) 2026 David Pearson. All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "u64_table.h"
+
+#define TEST_KEYS 100000
+
+/* Spreads test keys over the whole 64-bit range, including keys
+ * that differ only in their high bits.
+ */
+static uint64_t u64_table_test_key(uint64_t i) {
+    return (i % 2 == 0) ? i * 0x100000001ULL : i << 40;
+}
+
+bool u64_table_test() {
+    u64_table *table = u64_table_new();
+    if (table == NULL) {
+        printf("ERROR: Could not create u64 table\n");
+        return false;
+    }
+    
+    static int values[3];
+    uint64_t value = 0;
+    
+    if (u64_table_get(table, 0) != NULL || u64_table_get_u64(table, 7, &value) || u64_table_remove(table, 0)) {
+        printf("ERROR: Empty u64 table has items\n");
+        return false;
+    }
+    
+    if (!u64_table_set(table, 0, &values[0]) || !u64_table_set(table, UINT64_MAX, &values[1]) ||
+        u64_table_get(table, 0) != &values[0] || u64_table_get(table, UINT64_MAX) != &values[1] || table->length != 2) {
+        printf("ERROR: u64 table lost the zero or largest key\n");
+        return false;
+    }
+    
+    if (!u64_table_set(table, 0, &values[2]) || u64_table_get(table, 0) != &values[2] || table->length != 2) {
+        printf("ERROR: u64 table didn't overwrite the zero key\n");
+        return false;
+    }
+    
+    if (!u64_table_remove(table, 0) || u64_table_get(table, 0) != NULL || !u64_table_remove(table, UINT64_MAX) || table->length != 0) {
+        printf("ERROR: u64 table didn't remove keys\n");
+        return false;
+    }
+    
+    uint64_t i = 0;
+    for (i = 0; i < TEST_KEYS; i++) {
+        if (!u64_table_set_u64(table, u64_table_test_key(i), i * 3)) {
+            printf("ERROR: Could not set key %llu in u64 table\n", (unsigned long long)i);
+            return false;
+        }
+    }
+    
+    if (table->length != TEST_KEYS || !u64_table_set_u64(table, u64_table_test_key(5), 1) || table->length != TEST_KEYS) {
+        printf("ERROR: u64 table has %u items\n", table->length);
+        return false;
+    }
+    
+    u64_table_set_u64(table, u64_table_test_key(5), 15);
+    
+    /* Removing every third key shifts the keys after each one back,
+     * which must keep every other key reachable.
+     */
+    for (i = 0; i < TEST_KEYS; i += 3) {
+        if (!u64_table_remove(table, u64_table_test_key(i)) || u64_table_remove(table, u64_table_test_key(i))) {
+            printf("ERROR: Could not remove key %llu from u64 table\n", (unsigned long long)i);
+            return false;
+        }
+    }
+    
+    for (i = 0; i < TEST_KEYS; i++) {
+        bool found = u64_table_get_u64(table, u64_table_test_key(i), &value);
+        if (found != (i % 3 != 0) || (found && value != i * 3)) {
+            printf("ERROR: u64 table has the wrong value for key %llu\n", (unsigned long long)i);
+            return false;
+        }
+        
+        if (u64_table_get_u64(table, u64_table_test_key(i + TEST_KEYS), &value)) {
+            printf("ERROR: Found missing key %llu in u64 table\n", (unsigned long long)(i + TEST_KEYS));
+            return false;
+        }
+    }
+    
+    unsigned int bucket_count = table->bucket_count;
+    if (!u64_table_reserve(table, TEST_KEYS * 4) || table->bucket_count <= bucket_count ||
+        !u64_table_get_u64(table, u64_table_test_key(5), &value) || value != 15) {
+        printf("ERROR: Could not reserve space in u64 table\n");
+        return false;
+    }
+    
+    u64_table_free(table);
+    
+    return true;
+}